@@ -3,6 +3,7 @@
 #include <rai/versioning.hpp>
 
 #include <fstream>
+#include <sstream>
 
 TEST (block_store, construction)
 {
@@ -67,6 +68,7 @@ TEST (block_store, add_two_items)
     ASSERT_EQ (nullptr, latest1);
     rai::open_block block2 (0, 1, 3, rai::keypair ().prv, 0, 0);
     block2.hashables.account = 3;
+    block2.refresh ();
     rai::uint256_union hash2 (block2.hash ());
     block2.signature = rai::sign_message (key1.prv, key1.pub, hash2);
     auto latest2 (store.block_get (transaction, hash2));
@@ -334,6 +336,7 @@ TEST (block_store, two_block)
 	ASSERT_TRUE (!init);
 	rai::open_block block1 (0, 1, 1, rai::keypair ().prv, 0, 0);
 	block1.hashables.account = 1;
+	block1.refresh ();
 	std::vector <rai::block_hash> hashes;
 	std::vector <rai::open_block> blocks;
 	hashes.push_back (block1.hash ());
@@ -970,3 +973,483 @@ TEST (block_store, upgrade_v9_v10)
 	ASSERT_EQ (block_info.account, rai::test_genesis_key.pub);
 	ASSERT_EQ (block_info.balance.number (), rai::genesis_amount - rai::Gxrb_ratio * 31);
 }
+
+TEST (block_store, rep_weights_publish)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::keypair key1;
+	auto weights1 (store.rep_weights.snapshot ());
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.representation_put (transaction, key1.pub, 100);
+		ASSERT_EQ (100, store.representation_get (transaction, key1.pub));
+		ASSERT_EQ (0, store.rep_weights.get (nullptr, key1.pub));
+		ASSERT_EQ (weights1, store.rep_weights.snapshot ());
+	}
+	auto weights2 (store.rep_weights.snapshot ());
+	ASSERT_NE (weights1, weights2);
+	ASSERT_EQ (weights1->end (), weights1->find (key1.pub));
+	ASSERT_EQ (100, weights2->find (key1.pub)->second);
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_EQ (100, store.representation_get (transaction, key1.pub));
+}
+
+TEST (block_store, rep_weights_load)
+{
+	auto path (rai::unique_path ());
+	rai::keypair key1;
+	{
+		bool init (false);
+		rai::block_store store (init, path);
+		ASSERT_TRUE (!init);
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.representation_put (transaction, key1.pub, 100);
+	}
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_TRUE (!init);
+	ASSERT_EQ (100, store.rep_weights.snapshot ()->find (key1.pub)->second);
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_EQ (100, store.representation_get (transaction, key1.pub));
+}
+
+TEST (block_store, periodic_sync)
+{
+	auto path (rai::unique_path ());
+	rai::mdb_env_config config;
+	config.sync = rai::mdb_sync_mode::periodic;
+	config.sync_interval = 10;
+	config.no_readahead = true;
+	rai::keypair key1;
+	{
+		bool init (false);
+		rai::block_store store (init, path, config);
+		ASSERT_TRUE (!init);
+		unsigned flags;
+		ASSERT_EQ (0, mdb_env_get_flags (store.environment, &flags));
+		ASSERT_NE (0, flags & MDB_NOSYNC);
+		ASSERT_NE (0, flags & MDB_NORDAHEAD);
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.representation_put (transaction, key1.pub, 100);
+	}
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_TRUE (!init);
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_EQ (100, store.representation_get (transaction, key1.pub));
+}
+
+TEST (block_store, sync_benchmark)
+{
+	size_t const count (500);
+	std::vector <std::pair <std::string, rai::mdb_env_config>> configs;
+	rai::mdb_env_config full;
+	configs.push_back (std::make_pair ("full", full));
+	rai::mdb_env_config no_metasync;
+	no_metasync.sync = rai::mdb_sync_mode::no_metasync;
+	configs.push_back (std::make_pair ("no_metasync", no_metasync));
+	rai::mdb_env_config periodic;
+	periodic.sync = rai::mdb_sync_mode::periodic;
+	configs.push_back (std::make_pair ("periodic", periodic));
+	rai::mdb_env_config write_map (periodic);
+	write_map.write_map = true;
+	configs.push_back (std::make_pair ("periodic write_map", write_map));
+	rai::keypair key1;
+	rai::open_block open (0, 1, key1.pub, key1.prv, key1.pub, 0);
+	std::vector <rai::send_block> blocks;
+	rai::block_hash previous (open.hash ());
+	for (size_t j (0); j < count; ++j)
+	{
+		blocks.push_back (rai::send_block (previous, 0, j, key1.prv, key1.pub, 0));
+		previous = blocks.back ().hash ();
+	}
+	for (auto & i : configs)
+	{
+		bool init (false);
+		rai::block_store store (init, rai::unique_path (), i.second);
+		ASSERT_TRUE (!init);
+		{
+			rai::transaction transaction (store.environment, nullptr, true);
+			store.block_put (transaction, open.hash (), open);
+		}
+		auto start (std::chrono::steady_clock::now ());
+		// One commit per block, the pattern of wallet and RPC writes
+		for (auto & j : blocks)
+		{
+			rai::transaction transaction (store.environment, nullptr, true);
+			store.block_put (transaction, j.hash (), j);
+		}
+		auto elapsed (std::chrono::duration_cast <std::chrono::microseconds> (std::chrono::steady_clock::now () - start));
+		std::cerr << boost::str (boost::format ("%1%: %2% commits/s\n") % i.first % (count * 1000000 / std::max <uint64_t> (1, elapsed.count ())));
+		rai::transaction transaction (store.environment, nullptr, false);
+		ASSERT_TRUE (store.block_exists (transaction, previous));
+	}
+}
+
+TEST (block_store, upgrade_v10_v11)
+{
+	auto path (rai::unique_path ());
+	rai::keypair key1;
+	rai::send_block send (0, key1.pub, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	rai::open_block open (send.hash (), 1, key1.pub, key1.prv, key1.pub, 0);
+	rai::change_block change (open.hash (), 2, key1.prv, key1.pub, 0);
+	{
+		bool init (false);
+		rai::block_store store (init, path);
+		ASSERT_FALSE (init);
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.version_put (transaction, 10);
+		// Recreate the per-type tables of version 10
+		std::vector <std::pair <char const *, rai::block const *>> old_blocks ({{"send", &send}, {"open", &open}, {"change", &change}});
+		for (auto & i : old_blocks)
+		{
+			MDB_dbi database;
+			ASSERT_EQ (0, mdb_dbi_open (transaction, i.first, MDB_CREATE, &database));
+			std::vector <uint8_t> data;
+			{
+				rai::vectorstream stream (data);
+				i.second->serialize (stream);
+				rai::write (stream, rai::block_hash (i.second == &open ? change.hash () : 0).bytes);
+			}
+			ASSERT_EQ (0, mdb_put (transaction, database, rai::mdb_val (i.second->hash ()), rai::mdb_val (data.size (), data.data ()), 0));
+		}
+		ASSERT_FALSE (store.block_exists (transaction, send.hash ()));
+	}
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_FALSE (init);
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_LT (10, store.version_get (transaction));
+	auto send1 (store.block_get (transaction, send.hash ()));
+	ASSERT_NE (nullptr, send1);
+	ASSERT_EQ (send, *send1);
+	auto open1 (store.block_get (transaction, open.hash ()));
+	ASSERT_NE (nullptr, open1);
+	ASSERT_EQ (open, *open1);
+	ASSERT_EQ (change.hash (), store.block_successor (transaction, open.hash ()));
+	ASSERT_TRUE (store.block_exists (transaction, change.hash ()));
+	auto count (store.block_count (transaction));
+	ASSERT_EQ (1, count.send);
+	ASSERT_EQ (0, count.receive);
+	ASSERT_EQ (1, count.open);
+	ASSERT_EQ (1, count.change);
+	MDB_dbi database;
+	ASSERT_EQ (MDB_NOTFOUND, mdb_dbi_open (transaction, "send", 0, &database));
+}
+
+TEST (block_store, block_count_rewrite)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::transaction transaction (store.environment, nullptr, true);
+	rai::keypair key1;
+	rai::open_block open (0, 1, key1.pub, key1.prv, key1.pub, 0);
+	rai::send_block send (open.hash (), 0, 0, key1.prv, key1.pub, 0);
+	store.block_put (transaction, open.hash (), open);
+	store.block_put (transaction, send.hash (), send);
+	store.block_successor_clear (transaction, open.hash ());
+	store.block_put (transaction, send.hash (), send);
+	auto count1 (store.block_count (transaction));
+	ASSERT_EQ (1, count1.open);
+	ASSERT_EQ (1, count1.send);
+	store.block_del (transaction, send.hash ());
+	auto count2 (store.block_count (transaction));
+	ASSERT_EQ (1, count2.open);
+	ASSERT_EQ (0, count2.send);
+}
+
+TEST (block_store, block_get_benchmark)
+{
+	size_t const count (20000);
+	size_t const lookups (200000);
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::keypair key1;
+	std::vector <rai::block_hash> hashes;
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		rai::open_block open (0, 1, key1.pub, key1.prv, key1.pub, 0);
+		store.block_put (transaction, open.hash (), open);
+		hashes.push_back (open.hash ());
+		// Spread the ledger across every block type
+		for (size_t i (1); i < count; ++i)
+		{
+			std::unique_ptr <rai::block> block;
+			switch (i % 3)
+			{
+				case 0:
+					block.reset (new rai::send_block (hashes.back (), 0, i, key1.prv, key1.pub, 0));
+					break;
+				case 1:
+					block.reset (new rai::receive_block (hashes.back (), i, key1.prv, key1.pub, 0));
+					break;
+				default:
+					block.reset (new rai::change_block (hashes.back (), i, key1.prv, key1.pub, 0));
+					break;
+			}
+			store.block_put (transaction, block->hash (), *block);
+			hashes.push_back (block->hash ());
+		}
+	}
+	rai::transaction transaction (store.environment, nullptr, false);
+	std::vector <size_t> order (lookups);
+	for (auto & i : order)
+	{
+		i = rai::random_pool.GenerateWord32 (0, count - 1);
+	}
+	auto start (std::chrono::steady_clock::now ());
+	for (auto i : order)
+	{
+		auto block (store.block_get (transaction, hashes [i]));
+		ASSERT_NE (nullptr, block);
+	}
+	auto elapsed (std::chrono::duration_cast <std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start));
+	std::cerr << boost::str (boost::format ("block_get: %1% ns\n") % (elapsed.count () / lookups));
+	start = std::chrono::steady_clock::now ();
+	for (size_t i (0); i < lookups; ++i)
+	{
+		ASSERT_FALSE (store.block_exists (transaction, rai::block_hash (i)));
+	}
+	elapsed = std::chrono::duration_cast <std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start);
+	std::cerr << boost::str (boost::format ("block_exists miss: %1% ns\n") % (elapsed.count () / lookups));
+}
+
+TEST (block_store, upgrade_v11_v12)
+{
+	auto path (rai::unique_path ());
+	rai::keypair key1;
+	rai::genesis genesis;
+	rai::send_block send (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	rai::open_block open (send.hash (), key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	rai::change_block change (open.hash (), rai::test_genesis_key.pub, key1.prv, key1.pub, 0);
+	{
+		bool init (false);
+		rai::block_store store (init, path);
+		ASSERT_FALSE (init);
+		rai::transaction transaction (store.environment, nullptr, true);
+		genesis.initialize (transaction, store);
+		rai::ledger ledger (store);
+		ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send).code);
+		ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, open).code);
+		ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, change).code);
+		// Strip sidebands as version 11 didn't have them
+		for (auto hash : {genesis.hash (), send.hash (), open.hash (), change.hash ()})
+		{
+			auto block (store.block_get (transaction, hash));
+			store.block_put (transaction, hash, *block, store.block_successor (transaction, hash));
+		}
+		rai::block_sideband sideband;
+		ASSERT_TRUE (store.block_sideband_get (transaction, open.hash (), sideband));
+		ASSERT_EQ (key1.pub, ledger.account (transaction, open.hash ()));
+		store.version_put (transaction, 11);
+	}
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_FALSE (init);
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_LT (11, store.version_get (transaction));
+	rai::block_sideband sideband;
+	ASSERT_FALSE (store.block_sideband_get (transaction, genesis.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (rai::test_genesis_key.pub, 1, rai::genesis_amount), sideband);
+	ASSERT_FALSE (store.block_sideband_get (transaction, send.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (rai::test_genesis_key.pub, 2, rai::genesis_amount - 100), sideband);
+	ASSERT_FALSE (store.block_sideband_get (transaction, open.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (key1.pub, 1, 100), sideband);
+	ASSERT_FALSE (store.block_sideband_get (transaction, change.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (key1.pub, 2, 100), sideband);
+	ASSERT_EQ (change.hash (), store.block_successor (transaction, open.hash ()));
+}
+
+TEST (block_store, snapshot)
+{
+	bool init (false);
+	rai::block_store store1 (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::ledger ledger1 (store1);
+	rai::genesis genesis;
+	rai::keypair key1;
+	std::stringstream snapshot;
+	{
+		rai::transaction transaction (store1.environment, nullptr, true);
+		genesis.initialize (transaction, store1);
+		rai::send_block send (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+		ASSERT_EQ (rai::process_result::progress, ledger1.process (transaction, send).code);
+		rai::open_block open (send.hash (), key1.pub, key1.pub, key1.prv, key1.pub, 0);
+		ASSERT_EQ (rai::process_result::progress, ledger1.process (transaction, open).code);
+		rai::keypair key2;
+		rai::send_block send2 (open.hash (), key2.pub, 40, key1.prv, key1.pub, 0);
+		ASSERT_EQ (rai::process_result::progress, ledger1.process (transaction, send2).code);
+		ASSERT_FALSE (store1.snapshot_export (transaction, snapshot));
+	}
+	bool init2 (false);
+	rai::block_store store2 (init2, rai::unique_path ());
+	ASSERT_TRUE (!init2);
+	rai::ledger ledger2 (store2);
+	ASSERT_FALSE (store2.snapshot_import (snapshot));
+	rai::transaction transaction1 (store1.environment, nullptr, false);
+	rai::transaction transaction2 (store2.environment, nullptr, false);
+	ASSERT_EQ (store1.block_count (transaction1).sum (), store2.block_count (transaction2).sum ());
+	ASSERT_EQ (store1.block_count (transaction1).send, store2.block_count (transaction2).send);
+	ASSERT_EQ (store1.frontier_count (transaction1), store2.frontier_count (transaction2));
+	rai::account_info info1;
+	rai::account_info info2;
+	ASSERT_FALSE (store1.account_get (transaction1, key1.pub, info1));
+	ASSERT_FALSE (store2.account_get (transaction2, key1.pub, info2));
+	ASSERT_EQ (info1, info2);
+	ASSERT_EQ (ledger1.account_pending (transaction1, rai::test_genesis_key.pub), ledger2.account_pending (transaction2, rai::test_genesis_key.pub));
+	ASSERT_EQ (ledger1.account_balance (transaction1, key1.pub), ledger2.account_balance (transaction2, key1.pub));
+	ASSERT_EQ (ledger1.weight (transaction1, key1.pub), ledger2.weight (transaction2, key1.pub));
+	ASSERT_EQ (ledger1.weight (transaction1, key1.pub), store2.rep_weights.snapshot ()->find (key1.pub)->second);
+	rai::account max (std::numeric_limits <rai::uint256_t>::max ());
+	ASSERT_EQ (ledger1.checksum (transaction1, 0, max), ledger2.checksum (transaction2, 0, max));
+}
+
+TEST (block_store, snapshot_corrupt)
+{
+	bool init (false);
+	rai::block_store store1 (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	std::string snapshot;
+	{
+		rai::transaction transaction (store1.environment, nullptr, true);
+		rai::genesis genesis;
+		genesis.initialize (transaction, store1);
+		std::stringstream stream;
+		ASSERT_FALSE (store1.snapshot_export (transaction, stream));
+		snapshot = stream.str ();
+	}
+	// A flipped byte inside an entry only shows up in the digest
+	snapshot [snapshot.size () - 100] ^= 1;
+	bool init2 (false);
+	rai::block_store store2 (init2, rai::unique_path ());
+	ASSERT_TRUE (!init2);
+	std::stringstream stream1 (snapshot);
+	ASSERT_TRUE (store2.snapshot_import (stream1));
+	std::stringstream stream2 (snapshot.substr (0, snapshot.size () / 2));
+	ASSERT_TRUE (store2.snapshot_import (stream2));
+	rai::transaction transaction (store2.environment, nullptr, false);
+	ASSERT_EQ (0, store2.block_count (transaction).sum ());
+	ASSERT_TRUE (store2.latest_begin (transaction) == store2.latest_end ());
+}
+
+TEST (block_store, snapshot_type_counts)
+{
+	bool init (false);
+	rai::block_store store1 (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	std::stringstream snapshot;
+	{
+		rai::transaction transaction (store1.environment, nullptr, true);
+		rai::genesis genesis;
+		genesis.initialize (transaction, store1);
+		// Same total with the wrong split between types
+		store1.block_count_add (transaction, rai::block_type::open, -1);
+		store1.block_count_add (transaction, rai::block_type::send, 1);
+		ASSERT_FALSE (store1.snapshot_export (transaction, snapshot));
+	}
+	bool init2 (false);
+	rai::block_store store2 (init2, rai::unique_path ());
+	ASSERT_TRUE (!init2);
+	ASSERT_TRUE (store2.snapshot_import (snapshot));
+	rai::transaction transaction (store2.environment, nullptr, false);
+	ASSERT_EQ (0, store2.block_count (transaction).sum ());
+}
+
+TEST (block_store, block_buffer)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::open_block block1 (0, 1, 0, rai::keypair ().prv, 0, 0);
+	rai::send_block block2 (block1.hash (), 0, 0, rai::keypair ().prv, 0, 0);
+	rai::open_block block3 (1, 1, 0, rai::keypair ().prv, 0, 0);
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.block_put (transaction, block3.hash (), block3);
+	}
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.block_buffer_begin (transaction);
+		store.block_put (transaction, block1.hash (), block1);
+		store.block_put (transaction, block2.hash (), block2);
+		store.block_del (transaction, block3.hash ());
+		// Reads through the writing transaction see the staged blocks
+		ASSERT_TRUE (store.block_exists (transaction, block1.hash ()));
+		ASSERT_FALSE (store.block_exists (transaction, block3.hash ()));
+		ASSERT_EQ (block2.hash (), store.block_successor (transaction, block1.hash ()));
+		ASSERT_EQ (block2, *store.block_get (transaction, block2.hash ()));
+		ASSERT_EQ (2, store.block_count (transaction).sum ());
+		// Nothing reaches the table until commit
+		ASSERT_EQ (3, store.block_buffer.blocks.size ());
+		rai::mdb_val junk;
+		ASSERT_EQ (MDB_NOTFOUND, mdb_get (transaction, store.blocks, rai::mdb_val (block1.hash ()), junk));
+		ASSERT_EQ (0, mdb_get (transaction, store.blocks, rai::mdb_val (block3.hash ()), junk));
+	}
+	ASSERT_TRUE (store.block_buffer.blocks.empty ());
+	ASSERT_EQ (nullptr, store.block_buffer.transaction.load ());
+	ASSERT_EQ (3, store.block_buffer.written.load ());
+	ASSERT_EQ (1, store.block_buffer.flushes.load ());
+	rai::transaction transaction (store.environment, nullptr, false);
+	ASSERT_EQ (block2.hash (), store.block_successor (transaction, block1.hash ()));
+	ASSERT_EQ (block1, *store.block_get (transaction, block1.hash ()));
+	ASSERT_FALSE (store.block_exists (transaction, block3.hash ()));
+	ASSERT_EQ (2, store.block_count (transaction).sum ());
+}
+
+TEST (block_store, unchecked_pool)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	store.unchecked_pool.max = 8;
+	rai::keypair key1;
+	std::vector <std::shared_ptr <rai::block>> blocks;
+	for (auto i (0); i < 9; ++i)
+	{
+		blocks.push_back (std::make_shared <rai::send_block> (i, 1, 2, key1.prv, key1.pub, 3));
+	}
+	rai::transaction transaction (store.environment, nullptr, true);
+	for (auto & i : blocks)
+	{
+		store.unchecked_put (transaction, 1, i);
+	}
+	// Putting the same block again doesn't grow the pool
+	store.unchecked_put (transaction, 1, blocks [8]);
+	// Going over the limit spilled the oldest eighth
+	ASSERT_EQ (7, store.unchecked_pool_size ());
+	ASSERT_EQ (2, store.unchecked_pool_spilled ());
+	ASSERT_EQ (2, store.unchecked_stored (transaction));
+	ASSERT_EQ (9, store.unchecked_count (transaction));
+	ASSERT_EQ (9, store.unchecked_get (transaction, 1).size ());
+	ASSERT_TRUE (store.unchecked_get (transaction, 2).empty ());
+	store.unchecked_del (transaction, 1, *blocks [0]);
+	store.unchecked_del (transaction, 1, *blocks [8]);
+	ASSERT_EQ (6, store.unchecked_pool_size ());
+	ASSERT_EQ (1, store.unchecked_stored (transaction));
+	// Only blocks that arrived before the cutoff are written
+	store.unchecked_spill (transaction, std::chrono::system_clock::now () - std::chrono::seconds (60));
+	ASSERT_EQ (6, store.unchecked_pool_size ());
+	store.unchecked_spill (transaction, std::chrono::system_clock::time_point::max ());
+	ASSERT_EQ (0, store.unchecked_pool_size ());
+	ASSERT_EQ (7, store.unchecked_stored (transaction));
+	ASSERT_EQ (7, store.unchecked_get (transaction, 1).size ());
+	// A block already written to the table isn't pooled again
+	store.unchecked_put (transaction, 1, blocks [1]);
+	ASSERT_EQ (0, store.unchecked_pool_size ());
+	ASSERT_EQ (7, store.unchecked_get (transaction, 1).size ());
+	store.unchecked_put (transaction, 1, blocks [8]);
+	ASSERT_EQ (1, store.unchecked_pool_size ());
+	// Found by their own hash whether pooled or stored
+	ASSERT_EQ (*blocks [8], *store.unchecked_find (transaction, blocks [8]->hash ()));
+	ASSERT_EQ (*blocks [1], *store.unchecked_find (transaction, blocks [1]->hash ()));
+	ASSERT_EQ (nullptr, store.unchecked_find (transaction, 1));
+	auto pooled (store.unchecked_pooled (0, 8));
+	ASSERT_EQ (1, pooled.size ());
+	ASSERT_EQ (1, pooled [0].dependency);
+	ASSERT_EQ (blocks [8]->hash (), pooled [0].hash);
+	ASSERT_TRUE (store.unchecked_pooled (2, 8).empty ());
+}
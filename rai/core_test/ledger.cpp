@@ -747,6 +747,30 @@ TEST (votes, add_one)
 	ASSERT_EQ (rai::genesis_amount - 100, winner.first);
 }
 
+// Applying a vote to an election doesn't need the store's write lock
+TEST (votes, vote_during_write)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes [0]);
+	rai::genesis genesis;
+	rai::keypair key1;
+	auto send1 (std::make_shared <rai::send_block> (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, true);
+		ASSERT_EQ (rai::process_result::progress, node1.ledger.process (transaction, *send1).code);
+	}
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, false);
+		node1.active.start (transaction, send1);
+	}
+	node1.active.update_weights ();
+	auto votes1 (node1.active.roots.find (send1->root ())->election);
+	auto vote1 (std::make_shared <rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 1, send1));
+	rai::transaction transaction (node1.store.environment, nullptr, true);
+	votes1->vote (vote1);
+	ASSERT_EQ (2, votes1->votes.rep_votes.size ());
+}
+
 TEST (votes, add_two)
 {
 	rai::system system (24000, 1);
@@ -970,6 +994,23 @@ TEST (ledger, fail_send_bad_signature)
 	ASSERT_EQ (rai::process_result::bad_signature, result1.code);
 }
 
+// A signature verified against a different account than the block's signer is checked again
+TEST (ledger, fail_send_verified_other_account)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_FALSE (init);
+	rai::ledger ledger (store);
+	rai::genesis genesis;
+	rai::transaction transaction (store.environment, nullptr, true);
+	genesis.initialize (transaction, store);
+	rai::keypair key1;
+	rai::send_block block (genesis.hash (), key1.pub, 1, key1.prv, key1.pub, 0);
+	ASSERT_EQ (rai::process_result::bad_signature, ledger.process (transaction, block, key1.pub).code);
+	rai::send_block block2 (genesis.hash (), key1.pub, 1, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, block2, rai::test_genesis_key.pub).code);
+}
+
 TEST (ledger, fail_send_overspend)
 {
 	bool init (false);
@@ -1340,6 +1381,31 @@ TEST (ledger, inactive_supply)
 	ASSERT_EQ (50, ledger.supply (transaction));
 }
 
+TEST (ledger, weight_snapshot)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::ledger ledger (store);
+	rai::genesis genesis;
+	rai::keypair key2;
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		genesis.initialize (transaction, store);
+		rai::change_block change (genesis.hash (), key2.pub, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+		ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, change).code);
+	}
+	rai::transaction transaction (store.environment, nullptr, false);
+	auto weights (ledger.weights (transaction));
+	ASSERT_EQ (rai::genesis_amount, weights->weight (key2.pub));
+	ASSERT_EQ (0, weights->weight (rai::test_genesis_key.pub));
+	ASSERT_EQ (ledger.supply (transaction), weights->supply);
+	rai::votes votes (std::make_shared <rai::change_block> (genesis.hash (), key2.pub, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	auto vote (std::make_shared <rai::vote> (key2.pub, key2.prv, 1, votes.rep_votes.begin ()->second));
+	votes.vote (vote);
+	ASSERT_EQ (ledger.tally (transaction, votes), ledger.tally (*weights, votes));
+}
+
 TEST (ledger, change_representative_move_representation)
 {
 	bool init (false);
@@ -1420,3 +1486,48 @@ TEST (ledger, send_open_receive_rollback)
 	ASSERT_EQ (0, ledger.weight (transaction, key3.pub));
 	ASSERT_EQ (rai::genesis_amount - 0, ledger.weight (transaction, rai::test_genesis_key.pub));
 }
+
+TEST (ledger, sideband)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::ledger ledger (store);
+	rai::transaction transaction (store.environment, nullptr, true);
+	rai::genesis genesis;
+	genesis.initialize (transaction, store);
+	rai::keypair key1;
+	rai::send_block send1 (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send1).code);
+	rai::open_block open (send1.hash (), key1.pub, key1.pub, key1.prv, key1.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, open).code);
+	rai::send_block send2 (send1.hash (), key1.pub, rai::genesis_amount - 150, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send2).code);
+	rai::receive_block receive (open.hash (), send2.hash (), key1.prv, key1.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, receive).code);
+	rai::change_block change (receive.hash (), rai::test_genesis_key.pub, key1.prv, key1.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, change).code);
+	rai::block_sideband sideband;
+	ASSERT_FALSE (store.block_sideband_get (transaction, genesis.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (rai::test_genesis_key.pub, 1, rai::genesis_amount), sideband);
+	ASSERT_FALSE (store.block_sideband_get (transaction, send2.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (rai::test_genesis_key.pub, 3, rai::genesis_amount - 150), sideband);
+	ASSERT_FALSE (store.block_sideband_get (transaction, open.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (key1.pub, 1, 100), sideband);
+	ASSERT_FALSE (store.block_sideband_get (transaction, receive.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (key1.pub, 2, 150), sideband);
+	ASSERT_FALSE (store.block_sideband_get (transaction, change.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (key1.pub, 3, 150), sideband);
+	ASSERT_EQ (key1.pub, ledger.account (transaction, receive.hash ()));
+	ASSERT_EQ (150, ledger.balance (transaction, change.hash ()));
+	ASSERT_EQ (50, ledger.amount (transaction, send2.hash ()));
+	ASSERT_EQ (50, ledger.amount (transaction, receive.hash ()));
+	ASSERT_EQ (100, ledger.amount (transaction, open.hash ()));
+	ASSERT_EQ (0, ledger.amount (transaction, change.hash ()));
+	// Clearing a successor keeps the sideband
+	ledger.rollback (transaction, change.hash ());
+	ASSERT_FALSE (store.block_sideband_get (transaction, receive.hash (), sideband));
+	ASSERT_EQ (rai::block_sideband (key1.pub, 2, 150), sideband);
+	ASSERT_TRUE (store.block_successor (transaction, receive.hash ()).is_zero ());
+	ASSERT_TRUE (store.block_sideband_get (transaction, change.hash (), sideband));
+}
@@ -144,3 +144,210 @@ TEST (message_parser, exact_keepalive_size)
     ASSERT_EQ (1, visitor.keepalive_count);
     ASSERT_TRUE (parser.error);
 }
+
+TEST (message_parser, benchmark)
+{
+    rai::system system (24000, 1);
+    test_visitor visitor;
+    rai::message_parser parser (visitor, system.work);
+    rai::keypair key1;
+    std::vector <std::pair <std::string, std::vector <uint8_t>>> packets;
+    {
+        rai::keepalive message;
+        packets.push_back (std::make_pair ("keepalive", std::vector <uint8_t> ()));
+        rai::vectorstream stream (packets.back ().second);
+        message.serialize (stream);
+    }
+    {
+        rai::publish message (std::make_shared <rai::send_block> (1, 1, 2, key1.prv, key1.pub, system.work.generate (1)));
+        packets.push_back (std::make_pair ("publish", std::vector <uint8_t> ()));
+        rai::vectorstream stream (packets.back ().second);
+        message.serialize (stream);
+    }
+    {
+        rai::confirm_req message (std::make_shared <rai::open_block> (1, 1, key1.pub, key1.prv, key1.pub, system.work.generate (key1.pub)));
+        packets.push_back (std::make_pair ("confirm_req", std::vector <uint8_t> ()));
+        rai::vectorstream stream (packets.back ().second);
+        message.serialize (stream);
+    }
+    {
+        auto vote (std::make_shared <rai::vote> (key1.pub, key1.prv, 0, std::unique_ptr <rai::block> (new rai::send_block (1, 1, 2, key1.prv, key1.pub, system.work.generate (1)))));
+        rai::confirm_ack message (vote);
+        packets.push_back (std::make_pair ("confirm_ack", std::vector <uint8_t> ()));
+        rai::vectorstream stream (packets.back ().second);
+        message.serialize (stream);
+    }
+    size_t const count (100000);
+    for (auto & i : packets)
+    {
+        auto start (std::chrono::steady_clock::now ());
+        for (size_t j (0); j < count; ++j)
+        {
+            parser.deserialize_buffer (i.second.data (), i.second.size ());
+        }
+        auto elapsed (std::chrono::duration_cast <std::chrono::microseconds> (std::chrono::steady_clock::now () - start));
+        ASSERT_FALSE (parser.error);
+        ASSERT_FALSE (parser.insufficient_work);
+        std::cerr << boost::str (boost::format ("%1%: %2% packets/s\n") % i.first % (count * 1000000 / std::max <uint64_t> (1, elapsed.count ())));
+    }
+    ASSERT_EQ (count, visitor.keepalive_count);
+    ASSERT_EQ (count, visitor.publish_count);
+    ASSERT_EQ (count, visitor.confirm_req_count);
+    ASSERT_EQ (count, visitor.confirm_ack_count);
+}
+
+TEST (message_parser, insufficient_work)
+{
+    rai::system system (24000, 1);
+    test_visitor visitor;
+    rai::message_parser parser (visitor, system.work);
+    rai::keypair key1;
+    // Work is checked against the account for open blocks and the previous block for everything else
+    std::vector <std::shared_ptr <rai::block>> blocks;
+    blocks.push_back (std::make_shared <rai::send_block> (1, 1, 2, key1.prv, key1.pub, system.work.generate (1)));
+    blocks.push_back (std::make_shared <rai::receive_block> (1, 2, key1.prv, key1.pub, system.work.generate (1)));
+    blocks.push_back (std::make_shared <rai::open_block> (1, 1, key1.pub, key1.prv, key1.pub, system.work.generate (key1.pub)));
+    blocks.push_back (std::make_shared <rai::change_block> (1, 1, key1.prv, key1.pub, system.work.generate (1)));
+    for (auto & i : blocks)
+    {
+        std::vector <uint8_t> bytes;
+        {
+            rai::publish message (i);
+            rai::vectorstream stream (bytes);
+            message.serialize (stream);
+        }
+        parser.insufficient_work = false;
+        parser.deserialize_buffer (bytes.data (), bytes.size ());
+        ASSERT_FALSE (parser.error);
+        ASSERT_FALSE (parser.insufficient_work);
+        while (!rai::work_validate (*i))
+        {
+            i->block_work_set (i->block_work () + 1);
+        }
+        bytes.clear ();
+        {
+            rai::publish message (i);
+            rai::vectorstream stream (bytes);
+            message.serialize (stream);
+        }
+        parser.deserialize_buffer (bytes.data (), bytes.size ());
+        ASSERT_FALSE (parser.error);
+        ASSERT_TRUE (parser.insufficient_work);
+    }
+    ASSERT_EQ (blocks.size (), visitor.publish_count);
+}
+
+TEST (message_parser, benchmark_rejected)
+{
+    rai::system system (24000, 1);
+    test_visitor visitor;
+    rai::message_parser parser (visitor, system.work);
+    rai::keypair key1;
+    std::vector <uint8_t> bytes;
+    {
+        rai::publish message (std::make_shared <rai::send_block> (1, 1, 2, key1.prv, key1.pub, 0));
+        rai::vectorstream stream (bytes);
+        message.serialize (stream);
+    }
+    ASSERT_TRUE (rai::work_validate (1, 0));
+    size_t const count (100000);
+    auto start (std::chrono::steady_clock::now ());
+    for (size_t i (0); i < count; ++i)
+    {
+        parser.deserialize_buffer (bytes.data (), bytes.size ());
+    }
+    auto elapsed (std::chrono::duration_cast <std::chrono::microseconds> (std::chrono::steady_clock::now () - start));
+    ASSERT_TRUE (parser.insufficient_work);
+    ASSERT_EQ (0, visitor.publish_count);
+    std::cerr << boost::str (boost::format ("publish without work: %1% packets/s\n") % (count * 1000000 / std::max <uint64_t> (1, elapsed.count ())));
+}
+
+TEST (message_parser, duplicate_filter)
+{
+    rai::system system (24000, 1);
+    test_visitor visitor;
+    rai::digest_filter filter (1024);
+    rai::message_parser parser (visitor, system.work, &filter);
+    rai::keypair key1;
+    std::vector <uint8_t> bytes1;
+    {
+        rai::publish message (std::make_shared <rai::send_block> (1, 1, 2, key1.prv, key1.pub, system.work.generate (1)));
+        rai::vectorstream stream (bytes1);
+        message.serialize (stream);
+    }
+    parser.deserialize_buffer (bytes1.data (), bytes1.size ());
+    ASSERT_FALSE (parser.duplicate);
+    ASSERT_EQ (1, visitor.publish_count);
+    parser.deserialize_buffer (bytes1.data (), bytes1.size ());
+    ASSERT_TRUE (parser.duplicate);
+    ASSERT_FALSE (parser.error);
+    ASSERT_EQ (1, visitor.publish_count);
+    // Same block from a peer advertising another version
+    auto bytes2 (bytes1);
+    bytes2 [rai::message::magic_number.size ()] += 1;
+    parser.deserialize_buffer (bytes2.data (), bytes2.size ());
+    ASSERT_TRUE (parser.duplicate);
+    ASSERT_EQ (1, visitor.publish_count);
+    std::vector <uint8_t> bytes3;
+    {
+        rai::publish message (std::make_shared <rai::send_block> (1, 1, 3, key1.prv, key1.pub, system.work.generate (1)));
+        rai::vectorstream stream (bytes3);
+        message.serialize (stream);
+    }
+    parser.deserialize_buffer (bytes3.data (), bytes3.size ());
+    ASSERT_FALSE (parser.duplicate);
+    ASSERT_EQ (2, visitor.publish_count);
+    ASSERT_EQ (4, filter.checked);
+    ASSERT_EQ (2, filter.hits);
+}
+
+TEST (message_parser, duplicate_dropped)
+{
+    rai::system system (24000, 1);
+    test_visitor visitor;
+    rai::digest_filter filter (1024);
+    rai::message_parser parser (visitor, system.work, &filter);
+    rai::keypair key1;
+    rai::publish message (std::make_shared <rai::send_block> (1, 1, 2, key1.prv, key1.pub, system.work.generate (1)));
+    std::vector <uint8_t> bytes;
+    {
+        rai::vectorstream stream (bytes);
+        message.serialize (stream);
+    }
+    parser.deserialize_buffer (bytes.data (), bytes.size ());
+    ASSERT_FALSE (parser.duplicate);
+    ASSERT_EQ (1, visitor.publish_count);
+    // Queue overflowed before the publish was handled, a resend has to get through
+    filter.erase (message);
+    parser.deserialize_buffer (bytes.data (), bytes.size ());
+    ASSERT_FALSE (parser.duplicate);
+    ASSERT_EQ (2, visitor.publish_count);
+    parser.deserialize_buffer (bytes.data (), bytes.size ());
+    ASSERT_TRUE (parser.duplicate);
+    ASSERT_EQ (2, visitor.publish_count);
+}
+
+TEST (message_parser, benchmark_duplicates)
+{
+    rai::system system (24000, 1);
+    test_visitor visitor;
+    rai::digest_filter filter (rai::network::duplicate_filter_size);
+    rai::message_parser parser (visitor, system.work, &filter);
+    rai::keypair key1;
+    std::vector <uint8_t> bytes;
+    {
+        rai::publish message (std::make_shared <rai::send_block> (1, 1, 2, key1.prv, key1.pub, system.work.generate (1)));
+        rai::vectorstream stream (bytes);
+        message.serialize (stream);
+    }
+    size_t const count (100000);
+    auto start (std::chrono::steady_clock::now ());
+    for (size_t i (0); i < count; ++i)
+    {
+        parser.deserialize_buffer (bytes.data (), bytes.size ());
+    }
+    auto elapsed (std::chrono::duration_cast <std::chrono::microseconds> (std::chrono::steady_clock::now () - start));
+    ASSERT_EQ (1, visitor.publish_count);
+    ASSERT_EQ (count - 1, filter.hits);
+    std::cerr << boost::str (boost::format ("duplicate publish: %1% packets/s\n") % (count * 1000000 / std::max <uint64_t> (1, elapsed.count ())));
+}
@@ -55,9 +55,8 @@ TEST (network, construction)
 TEST (network, self_discard)
 {
     rai::system system (24000, 1);
-	system.nodes [0]->network.remote = system.nodes [0]->network.endpoint ();
 	ASSERT_EQ (0, system.nodes [0]->network.bad_sender_count);
-	system.nodes [0]->network.receive_action (boost::system::error_code {}, 0);
+	system.nodes [0]->network.process_packet (system.nodes [0]->network.endpoint (), nullptr, 0);
 	ASSERT_EQ (1, system.nodes [0]->network.bad_sender_count);
 }
 
@@ -89,6 +88,216 @@ TEST (network, send_keepalive)
     node1->stop ();
 }
 
+TEST (network, multiple_receivers)
+{
+    rai::system system (24000, 4);
+    rai::node_init init1;
+    rai::node_config config (24004, system.logging);
+    config.network_receivers = 4;
+    auto node1 (std::make_shared <rai::node> (init1, system.service, rai::unique_path (), system.alarm, config, system.work));
+    ASSERT_FALSE (init1.error ());
+    node1->start ();
+    ASSERT_EQ (4, node1->network.receivers.size ());
+    ASSERT_EQ (24004, node1->network.endpoint ().port ());
+    auto initial (node1->network.incoming.keepalive.load ());
+    // Distinct source ports so SO_REUSEPORT can spread them over the receive sockets
+    for (auto & i : system.nodes)
+    {
+        i->network.send_keepalive (node1->network.endpoint ());
+    }
+    auto iterations (0);
+    while (node1->network.incoming.keepalive < initial + system.nodes.size ())
+    {
+        system.poll ();
+        ++iterations;
+        ASSERT_LT (iterations, 200);
+    }
+    uint64_t packets (0);
+    for (auto & i : node1->network.receivers)
+    {
+        packets += i->packets;
+    }
+    ASSERT_LE (system.nodes.size (), packets);
+    node1->stop ();
+}
+
+#if defined (__linux__) && defined (SO_REUSEPORT)
+TEST (network, reuse_port_in_use)
+{
+    rai::system system (24000, 1);
+    // Another process holding the port with SO_REUSEPORT set would otherwise be let in to the receive group
+    boost::asio::ip::udp::socket other (system.service, boost::asio::ip::udp::v6 ());
+    other.set_option (boost::asio::detail::socket_option::boolean <SOL_SOCKET, SO_REUSEPORT> (true));
+    other.bind (rai::endpoint (boost::asio::ip::address_v6::any (), 24005));
+    rai::node_init init1;
+    rai::node_config config (24005, system.logging);
+    config.network_receivers = 4;
+    ASSERT_THROW (std::make_shared <rai::node> (init1, system.service, rai::unique_path (), system.alarm, config, system.work), boost::system::system_error);
+}
+#endif
+
+TEST (network, send_buffer_many)
+{
+    rai::system system (24000, 3);
+    auto & node1 (*system.nodes [0]);
+    rai::keepalive message;
+    std::shared_ptr <std::vector <uint8_t>> bytes (new std::vector <uint8_t>);
+    {
+        rai::vectorstream stream (*bytes);
+        message.serialize (stream);
+    }
+    std::vector <rai::endpoint> endpoints;
+    for (auto i (1); i < 3; ++i)
+    {
+        endpoints.push_back (system.nodes [i]->network.endpoint ());
+    }
+    auto errors (0);
+    node1.network.send_buffer_many (bytes, endpoints, [&errors] (boost::system::error_code const &, rai::endpoint const &) { ++errors; });
+    auto iterations (0);
+    while (system.nodes [1]->network.incoming.keepalive == 0 || system.nodes [2]->network.incoming.keepalive == 0)
+    {
+        system.poll ();
+        ++iterations;
+        ASSERT_LT (iterations, 200);
+    }
+    ASSERT_EQ (0, errors);
+    if (node1.network.batching)
+    {
+        ASSERT_EQ (1, node1.network.send_batches);
+        ASSERT_LE (1, system.nodes [1]->network.receivers [0]->batches);
+    }
+}
+
+TEST (token_bucket, refill)
+{
+	rai::token_bucket bucket (1000);
+	auto now (std::chrono::steady_clock::now ());
+	ASSERT_TRUE (bucket.full (now));
+	ASSERT_TRUE (bucket.try_consume (600, now));
+	ASSERT_FALSE (bucket.try_consume (600, now));
+	ASSERT_TRUE (bucket.try_consume (400, now));
+	ASSERT_FALSE (bucket.full (now));
+	ASSERT_TRUE (bucket.try_consume (500, now + std::chrono::milliseconds (500)));
+	// Refills never hold more than one second of bandwidth
+	ASSERT_TRUE (bucket.full (now + std::chrono::seconds (10)));
+	ASSERT_TRUE (bucket.try_consume (1000, now + std::chrono::seconds (10)));
+	ASSERT_FALSE (bucket.try_consume (1, now + std::chrono::seconds (10)));
+	// A packet larger than the bucket goes out whenever the bucket is full
+	rai::token_bucket small (100);
+	ASSERT_TRUE (small.try_consume (1000, now));
+	ASSERT_FALSE (small.try_consume (1, now + std::chrono::seconds (1)));
+	rai::token_bucket unlimited (0);
+	ASSERT_TRUE (unlimited.try_consume (std::numeric_limits <size_t>::max (), now));
+}
+
+TEST (send_queue, priority)
+{
+	rai::system system (24000, 1);
+	rai::node_init init1;
+	rai::node_config config (24001, system.logging);
+	config.bandwidth_limit = 1000;
+	auto node1 (std::make_shared <rai::node> (init1, system.service, rai::unique_path (), system.alarm, config, system.work));
+	ASSERT_FALSE (init1.error ());
+	auto & queue (node1->network.send_queue);
+	std::vector <rai::endpoint> endpoints (1, system.nodes [0]->network.endpoint ());
+	auto errors (0);
+	auto callback ([&errors] (boost::system::error_code const & ec, rai::endpoint const &) { if (ec) { ++errors; } });
+	// The first second of bandwidth goes out immediately, the rest waits
+	for (auto i (0); i < 8; ++i)
+	{
+		node1->network.send (std::make_shared <std::vector <uint8_t>> (250, i), endpoints, rai::send_priority::keepalive, callback);
+	}
+	ASSERT_EQ (1000, queue.size ());
+	// The same payload to the same peer is already waiting
+	node1->network.send (std::make_shared <std::vector <uint8_t>> (250, 7), endpoints, rai::send_priority::keepalive, callback);
+	ASSERT_EQ (1, queue.coalesced);
+	ASSERT_EQ (1000, queue.size ());
+	node1->network.send (std::make_shared <std::vector <uint8_t>> (50, 0xff), endpoints, rai::send_priority::vote, callback);
+	ASSERT_EQ (1050, queue.size ());
+	// The vote goes out before the keepalives queued ahead of it
+	auto iterations (0);
+	while (queue.size () == 1050)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	ASSERT_EQ (1000, queue.size ());
+	ASSERT_EQ (1050, queue.queued_bytes);
+	ASSERT_EQ (0, queue.dropped_bytes);
+	ASSERT_EQ (0, errors);
+	node1->stop ();
+}
+
+TEST (send_queue, per_peer)
+{
+	rai::system system (24000, 1);
+	rai::node_init init1;
+	rai::node_config config (24001, system.logging);
+	config.bandwidth_limit = 0;
+	config.peer_bandwidth_limit = 1000;
+	auto node1 (std::make_shared <rai::node> (init1, system.service, rai::unique_path (), system.alarm, config, system.work));
+	ASSERT_FALSE (init1.error ());
+	auto & queue (node1->network.send_queue);
+	std::vector <rai::endpoint> endpoints1 (1, system.nodes [0]->network.endpoint ());
+	std::vector <rai::endpoint> endpoints2 (1, rai::endpoint (boost::asio::ip::address_v6::loopback (), 24002));
+	std::vector <boost::system::error_code> results;
+	auto callback ([&results] (boost::system::error_code const & ec, rai::endpoint const &) { results.push_back (ec); });
+	for (auto i (0); i < 5; ++i)
+	{
+		node1->network.send (std::make_shared <std::vector <uint8_t>> (250, i), endpoints1, rai::send_priority::keepalive, callback);
+	}
+	ASSERT_EQ (250, queue.size ());
+	// Another peer with bandwidth left isn't held behind the first one's queue
+	node1->network.send (std::make_shared <std::vector <uint8_t>> (250, 0), endpoints2, rai::send_priority::keepalive, callback);
+	ASSERT_EQ (250, queue.size ());
+	// A payload coalesced into the queued one reports success
+	node1->network.send (std::make_shared <std::vector <uint8_t>> (250, 4), endpoints1, rai::send_priority::keepalive, callback);
+	ASSERT_EQ (1, queue.coalesced);
+	ASSERT_EQ (250, queue.size ());
+	ASSERT_EQ (1, results.size ());
+	ASSERT_FALSE (results [0]);
+	// The same payload to a different peer is a different packet
+	node1->network.send (std::make_shared <std::vector <uint8_t>> (250, 4), endpoints2, rai::send_priority::keepalive, callback);
+	ASSERT_EQ (1, queue.coalesced);
+	node1->stop ();
+}
+
+TEST (send_queue, evict_lowest)
+{
+	rai::system system (24000, 1);
+	rai::node_init init1;
+	rai::node_config config (24001, system.logging);
+	config.bandwidth_limit = 1;
+	auto node1 (std::make_shared <rai::node> (init1, system.service, rai::unique_path (), system.alarm, config, system.work));
+	ASSERT_FALSE (init1.error ());
+	auto & queue (node1->network.send_queue);
+	std::vector <rai::endpoint> endpoints (1, system.nodes [0]->network.endpoint ());
+	std::vector <rai::endpoint> dropped;
+	auto callback ([&dropped] (boost::system::error_code const & ec, rai::endpoint const & endpoint_a)
+	{
+		ASSERT_EQ (boost::system::errc::no_buffer_space, ec.value ());
+		dropped.push_back (endpoint_a);
+	});
+	size_t const size (32 * 1024);
+	auto count (rai::send_queue::max_queued_bytes / size);
+	// The first packet empties the bucket
+	for (size_t i (0); i < count + 1; ++i)
+	{
+		auto buffer (std::make_shared <std::vector <uint8_t>> (size, 0));
+		*reinterpret_cast <size_t *> (buffer->data ()) = i;
+		node1->network.send (buffer, endpoints, rai::send_priority::keepalive, callback);
+	}
+	ASSERT_EQ (count * size, queue.size ());
+	ASSERT_TRUE (dropped.empty ());
+	// A full queue makes room for votes by dropping the oldest keepalive
+	node1->network.send (std::make_shared <std::vector <uint8_t>> (size, 0xff), endpoints, rai::send_priority::vote, callback);
+	ASSERT_EQ (count * size, queue.size ());
+	ASSERT_EQ (size, queue.dropped_bytes);
+	ASSERT_EQ (1, dropped.size ());
+	node1->stop ();
+}
+
 TEST (network, keepalive_ipv4)
 {
     rai::system system (24000, 1);
@@ -445,6 +654,7 @@ TEST (bulk_pull, end_not_owned)
     open.hashables.account = key2.pub;
     open.hashables.representative = key2.pub;
     open.hashables.source = latest;
+    open.refresh ();
     open.signature = rai::sign_message (key2.prv, key2.pub, open.hash ());
 	ASSERT_EQ (rai::process_result::progress, system.nodes [0]->process (open).code);
     auto connection (std::make_shared <rai::bootstrap_server> (nullptr, system.nodes [0]));
@@ -488,6 +698,81 @@ TEST (bulk_pull, get_next_on_open)
     ASSERT_EQ (request->current, request->request->end);
 }
 
+TEST (bulk_pull, benchmark)
+{
+	size_t const count (20000);
+	rai::system system (24000, 1);
+	auto node (system.nodes [0]);
+	{
+		// Extend the genesis chain directly in the store, the server only reads it back
+		rai::transaction transaction (node->store.environment, nullptr, true);
+		rai::account_info info;
+		ASSERT_FALSE (node->store.account_get (transaction, rai::test_genesis_key.pub, info));
+		for (size_t i (0); i < count; ++i)
+		{
+			rai::change_block change (info.head, rai::account (i), rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+			node->store.block_put (transaction, change.hash (), change);
+			info.head = change.hash ();
+		}
+		node->store.account_put (transaction, rai::test_genesis_key.pub, info);
+	}
+	for (auto batch_size : { 1u, 7u, node->config.bulk_pull_batch_size })
+	{
+		node->config.bulk_pull_batch_size = batch_size;
+		std::atomic <bool> done (false);
+		size_t received (0);
+		auto type (rai::block_type::invalid);
+		std::chrono::steady_clock::duration elapsed;
+		std::thread client ([&] ()
+		{
+			boost::asio::io_service service;
+			boost::asio::ip::tcp::socket socket (service);
+			socket.connect (node->bootstrap.endpoint ());
+			std::vector <uint8_t> request_buffer;
+			{
+				rai::bulk_pull request;
+				request.start = rai::test_genesis_key.pub;
+				request.end.clear ();
+				rai::vectorstream stream (request_buffer);
+				request.serialize (stream);
+			}
+			auto start (std::chrono::steady_clock::now ());
+			boost::asio::write (socket, boost::asio::buffer (request_buffer));
+			std::array <uint8_t, 256> buffer;
+			do
+			{
+				boost::asio::read (socket, boost::asio::buffer (buffer.data (), 1));
+				type = static_cast <rai::block_type> (buffer [0]);
+				switch (type)
+				{
+					case rai::block_type::change:
+						boost::asio::read (socket, boost::asio::buffer (buffer.data (), rai::change_block::size));
+						++received;
+						break;
+					case rai::block_type::open:
+						boost::asio::read (socket, boost::asio::buffer (buffer.data (), rai::open_block::size));
+						++received;
+						break;
+					default:
+						break;
+				}
+			} while (type == rai::block_type::change || type == rai::block_type::open);
+			elapsed = std::chrono::steady_clock::now () - start;
+			done = true;
+		});
+		// Run handlers without system.poll's idle sleep so the write completions aren't delayed
+		while (!done)
+		{
+			system.service.poll ();
+		}
+		client.join ();
+		ASSERT_EQ (rai::block_type::not_a_block, type);
+		ASSERT_EQ (count + 1, received);
+		auto seconds (std::chrono::duration_cast <std::chrono::duration <double>> (elapsed).count ());
+		std::cerr << boost::str (boost::format ("bulk_pull batch %1%: %2% blocks/sec\n") % batch_size % static_cast <uint64_t> (received / seconds));
+	}
+}
+
 TEST (bootstrap_processor, DISABLED_process_none)
 {
     rai::system system (24000, 1);
@@ -527,6 +812,123 @@ TEST (bootstrap_processor, process_one)
     node1->stop ();
 }
 
+TEST (bootstrap_processor, requeue_completed)
+{
+	rai::system system (24000, 1);
+	auto attempt (std::make_shared <rai::bootstrap_attempt> (system.nodes [0]));
+	rai::pull_info pull1 (rai::test_genesis_key.pub, 1, 0);
+	auto pull2 (pull1);
+	attempt->requeue_pull (pull1);
+	ASSERT_EQ (1, attempt->pulls.size ());
+	// Once any copy of a pull finishes the others aren't retried
+	*pull1.completed = true;
+	attempt->requeue_pull (pull2);
+	ASSERT_EQ (1, attempt->pulls.size ());
+	attempt->requeue_pull (rai::pull_info (rai::test_genesis_key.pub, 1, 0));
+	ASSERT_EQ (2, attempt->pulls.size ());
+}
+
+TEST (bootstrap_processor, block_rate)
+{
+	rai::system system (24000, 1);
+	auto attempt (std::make_shared <rai::bootstrap_attempt> (system.nodes [0]));
+	auto client (std::make_shared <rai::bootstrap_client> (system.nodes [0], attempt, rai::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24000)));
+	ASSERT_FALSE (client->pulling ());
+	ASSERT_EQ (0.0, client->block_rate ());
+	client->streamed_count = 100;
+	client->pull_time = 2000000;
+	ASSERT_DOUBLE_EQ (50.0, client->block_rate ());
+	// Only time spent streaming counts, waiting for the first block of a pull doesn't
+	client->start_pull ();
+	ASSERT_TRUE (client->pulling ());
+	std::this_thread::sleep_for (std::chrono::milliseconds (500));
+	ASSERT_DOUBLE_EQ (2.0, client->pull_seconds ());
+	client->pulled_block ();
+	ASSERT_EQ (100, client->streamed_count);
+	std::this_thread::sleep_for (std::chrono::milliseconds (100));
+	client->pulled_block ();
+	client->end_pull ();
+	ASSERT_FALSE (client->pulling ());
+	ASSERT_EQ (2, client->block_count);
+	ASSERT_EQ (101, client->streamed_count);
+	ASSERT_LE (2.1, client->pull_seconds ());
+	ASSERT_GT (2.5, client->pull_seconds ());
+	auto seconds (client->pull_seconds ());
+	std::this_thread::sleep_for (std::chrono::milliseconds (10));
+	ASSERT_EQ (seconds, client->pull_seconds ());
+}
+
+TEST (bootstrap_processor, frontier_ranges)
+{
+	size_t const count (100000);
+	rai::system system (24000, 1);
+	auto node0 (system.nodes [0]);
+	rai::node_init init1;
+	auto node1 (std::make_shared <rai::node> (init1, system.service, 24001, rai::unique_path (), system.alarm, system.logging, system.work));
+	ASSERT_FALSE (init1.error ());
+	{
+		// Accounts spread over the whole key space, every tenth one is only known to node0
+		rai::transaction transaction0 (node0->store.environment, nullptr, true);
+		rai::transaction transaction1 (node1->store.environment, nullptr, true);
+		for (size_t i (0); i < count; ++i)
+		{
+			rai::account account;
+			rai::random_pool.GenerateBlock (account.bytes.data (), account.bytes.size ());
+			rai::account_info info (rai::block_hash (i + 1), 0, 0, 0, node0->store.now (), 1);
+			node0->store.account_put (transaction0, account, info);
+			if (i % 10 != 0)
+			{
+				node1->store.account_put (transaction1, account, info);
+			}
+		}
+	}
+	for (auto ranges : { 1u, 4u })
+	{
+		node1->config.bootstrap_frontier_ranges = ranges;
+		auto attempt (std::make_shared <rai::bootstrap_attempt> (node1));
+		for (size_t i (0); i < ranges; ++i)
+		{
+			auto client (std::make_shared <rai::bootstrap_client> (node1, attempt, node0->bootstrap.endpoint ()));
+			client->socket.connect (node0->bootstrap.endpoint ());
+			attempt->idle.push_back (client);
+		}
+		std::atomic <bool> done (false);
+		auto result (true);
+		auto start (std::chrono::steady_clock::now ());
+		std::thread thread ([&] ()
+		{
+			std::unique_lock <std::mutex> lock (attempt->mutex);
+			result = attempt->request_frontier (lock);
+			done = true;
+		});
+		// Serve and compare the ranges on several threads the way a node's io threads would
+		std::vector <std::thread> io_threads;
+		for (size_t i (0); i < 4; ++i)
+		{
+			io_threads.push_back (std::thread ([&] ()
+			{
+				while (!done)
+				{
+					system.service.poll ();
+				}
+			}));
+		}
+		thread.join ();
+		for (auto & i : io_threads)
+		{
+			i.join ();
+		}
+		auto elapsed (std::chrono::duration_cast <std::chrono::duration <double>> (std::chrono::steady_clock::now () - start));
+		ASSERT_FALSE (result);
+		ASSERT_EQ (ranges, attempt->frontiers.size ());
+		ASSERT_EQ (count / 10, attempt->pulls.size ());
+		// Only the range running to the end of the account space sees the terminator and keeps its connection
+		ASSERT_EQ (1, attempt->idle.size ());
+		std::cerr << boost::str (boost::format ("frontier ranges %1%: %2% frontiers/sec\n") % ranges % static_cast <uint64_t> (count / elapsed.count ()));
+	}
+	node1->stop ();
+}
+
 TEST (bootstrap_processor, process_two)
 {
 	rai::system system (24000, 1);
@@ -739,6 +1141,49 @@ TEST (frontier_req, time_cutoff)
     ASSERT_EQ (genesis.hash (), request->info.head);
 }
 
+TEST (frontier_req, benchmark)
+{
+	size_t const count (100000);
+	rai::system system (24000, 1);
+	auto node0 (system.nodes [0]);
+	rai::node_init init1;
+	auto node1 (std::make_shared <rai::node> (init1, system.service, 24001, rai::unique_path (), system.alarm, system.logging, system.work));
+	ASSERT_FALSE (init1.error ());
+	{
+		// Both ledgers share the same accounts except every tenth one, which only the server has
+		rai::transaction transaction0 (node0->store.environment, nullptr, true);
+		rai::transaction transaction1 (node1->store.environment, nullptr, true);
+		for (size_t i (0); i < count; ++i)
+		{
+			rai::account account (i + 1);
+			rai::account_info info (rai::block_hash (i + 1), 0, 0, 0, node0->store.now (), 1);
+			node0->store.account_put (transaction0, account, info);
+			if (i % 10 != 0)
+			{
+				node1->store.account_put (transaction1, account, info);
+			}
+		}
+	}
+	auto attempt (std::make_shared <rai::bootstrap_attempt> (node1));
+	auto client (std::make_shared <rai::bootstrap_client> (node1, attempt, node0->bootstrap.endpoint ()));
+	client->socket.connect (node0->bootstrap.endpoint ());
+	auto frontiers (std::make_shared <rai::frontier_req_client> (client, rai::account (0), rai::account (0)));
+	auto future (frontiers->promise.get_future ());
+	auto start (std::chrono::steady_clock::now ());
+	frontiers->run ();
+	// Run handlers without system.poll's idle sleep so the reads aren't delayed
+	while (future.wait_for (std::chrono::seconds (0)) != std::future_status::ready)
+	{
+		system.service.poll ();
+	}
+	auto elapsed (std::chrono::duration_cast <std::chrono::duration <double>> (std::chrono::steady_clock::now () - start));
+	ASSERT_FALSE (future.get ());
+	ASSERT_EQ (count + 1, frontiers->count);
+	ASSERT_EQ (count / 10, attempt->pulls.size ());
+	std::cerr << boost::str (boost::format ("frontier_req: %1% frontiers/sec\n") % static_cast <uint64_t> (frontiers->count / elapsed.count ()));
+	node1->stop ();
+}
+
 TEST (bulk, genesis)
 {
     rai::system system (24000, 1);
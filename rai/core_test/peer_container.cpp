@@ -61,13 +61,19 @@ TEST (peer_container, split)
     auto now (std::chrono::system_clock::now ());
     rai::endpoint endpoint1 (boost::asio::ip::address_v6::any (), 100);
     rai::endpoint endpoint2 (boost::asio::ip::address_v6::any (), 101);
-	peers.peers.insert (rai::peer_information (endpoint1, now - std::chrono::seconds (1), now));
-    peers.peers.insert (rai::peer_information (endpoint2, now + std::chrono::seconds (1), now));
+	ASSERT_FALSE (peers.insert (rai::peer_information (endpoint1, now - std::chrono::seconds (1), now)));
+    ASSERT_FALSE (peers.insert (rai::peer_information (endpoint2, now + std::chrono::seconds (1), now)));
+    ASSERT_TRUE (peers.insert (rai::peer_information (endpoint2, now, now)));
 	ASSERT_EQ (2, peers.peers.size ());
     auto list (peers.purge_list (now));
 	ASSERT_EQ (1, peers.peers.size ());
     ASSERT_EQ (1, list.size ());
     ASSERT_EQ (endpoint2, list [0].endpoint);
+    ASSERT_EQ (now, list [0].last_attempt);
+    // The purge counts as an attempt for the next one
+    auto list2 (peers.purge_list (now));
+    ASSERT_EQ (1, list2.size ());
+    ASSERT_LT (now, list2 [0].last_attempt);
 }
 
 TEST (peer_container, fill_random_clear)
@@ -139,3 +145,107 @@ TEST (peer_container, rep_weight)
 	ASSERT_EQ (100, reps [0].rep_weight.number ());
 	ASSERT_EQ (endpoint0, reps [0].endpoint);
 }
+
+TEST (peer_container, purge_reindex)
+{
+    rai::peer_container peers (rai::endpoint {});
+    auto now (std::chrono::system_clock::now ());
+    for (auto i (0); i < 1000; ++i)
+    {
+        ASSERT_FALSE (peers.insert (rai::peer_information (rai::endpoint (boost::asio::ip::address_v6::loopback (), 10000 + i), now + std::chrono::seconds (i % 2 ? 1 : -1), now)));
+    }
+    auto list (peers.purge_list (now));
+    ASSERT_EQ (500, list.size ());
+    ASSERT_EQ (500, peers.size ());
+    // Peers that moved during the purge are still found
+    for (auto i (0); i < 1000; ++i)
+    {
+        ASSERT_EQ (i % 2 == 1, peers.known_peer (rai::endpoint (boost::asio::ip::address_v6::loopback (), 10000 + i)));
+    }
+}
+
+TEST (peer_container, rep_crawl_oldest)
+{
+    rai::peer_container peers (rai::endpoint {});
+    for (auto i (0); i < rai::peer_container::peers_per_crawl * 2; ++i)
+    {
+        peers.insert (rai::endpoint (boost::asio::ip::address_v6::loopback (), 10000 + i), 0);
+    }
+    auto crawl1 (peers.rep_crawl ());
+    ASSERT_EQ (rai::peer_container::peers_per_crawl, crawl1.size ());
+    for (auto & i : crawl1)
+    {
+        peers.rep_request (i);
+    }
+    // The next crawl asks the peers that haven't been asked yet
+    auto crawl2 (peers.rep_crawl ());
+    ASSERT_EQ (rai::peer_container::peers_per_crawl, crawl2.size ());
+    for (auto & i : crawl2)
+    {
+        ASSERT_EQ (crawl1.end (), std::find (crawl1.begin (), crawl1.end (), i));
+    }
+}
+
+TEST (peer_container, rep_weight_order)
+{
+    rai::peer_container peers (rai::endpoint {});
+    rai::endpoint endpoint0 (boost::asio::ip::address_v6::loopback (), 24000);
+    rai::endpoint endpoint1 (boost::asio::ip::address_v6::loopback (), 24001);
+    peers.insert (endpoint0, 0);
+    peers.insert (endpoint1, 0);
+    ASSERT_TRUE (peers.rep_response (endpoint0, rai::amount (100)));
+    ASSERT_EQ (endpoint0, peers.representatives (1) [0].endpoint);
+    ASSERT_TRUE (peers.rep_response (endpoint1, rai::amount (200)));
+    auto reps (peers.representatives (2));
+    ASSERT_EQ (2, reps.size ());
+    ASSERT_EQ (endpoint1, reps [0].endpoint);
+    ASSERT_FALSE (peers.rep_response (endpoint1, rai::amount (50)));
+    ASSERT_EQ (200, peers.representatives (1) [0].rep_weight.number ());
+}
+
+TEST (peer_container, bootstrap_peer_rotation)
+{
+    rai::peer_container peers (rai::endpoint {});
+    rai::endpoint endpoint0 (boost::asio::ip::address_v6::loopback (), 24000);
+    rai::endpoint endpoint1 (boost::asio::ip::address_v6::loopback (), 24001);
+    peers.insert (endpoint0, 0x5);
+    ASSERT_EQ (endpoint0, peers.bootstrap_peer ());
+    peers.insert (endpoint1, 0x5);
+    ASSERT_EQ (endpoint1, peers.bootstrap_peer ());
+    ASSERT_EQ (endpoint0, peers.bootstrap_peer ());
+}
+
+TEST (peer_container, benchmark_contacted)
+{
+    rai::peer_container peers (rai::endpoint {});
+    std::vector <rai::endpoint> endpoints;
+    for (auto i (0); i < 4096; ++i)
+    {
+        endpoints.push_back (rai::endpoint (boost::asio::ip::address_v6::v4_mapped (boost::asio::ip::address_v4 (0x0a000000 + i)), 7075));
+        peers.contacted (endpoints.back (), 0x5);
+    }
+    ASSERT_EQ (endpoints.size (), peers.size ());
+    auto thread_count (std::max <unsigned> (4, std::thread::hardware_concurrency ()));
+    size_t const count (200000);
+    std::vector <std::thread> threads;
+    auto start (std::chrono::steady_clock::now ());
+    for (unsigned i (0); i < thread_count; ++i)
+    {
+        threads.push_back (std::thread ([&peers, &endpoints, i, count] ()
+        {
+            for (size_t j (0); j < count; ++j)
+            {
+                auto & endpoint (endpoints [(j * 7 + i * 613) % endpoints.size ()]);
+                peers.contacted (endpoint, 0x5);
+                peers.known_peer (endpoint);
+            }
+        }));
+    }
+    for (auto & i : threads)
+    {
+        i.join ();
+    }
+    auto elapsed (std::chrono::duration_cast <std::chrono::microseconds> (std::chrono::steady_clock::now () - start));
+    ASSERT_EQ (endpoints.size (), peers.size ());
+    std::cerr << boost::str (boost::format ("contacted: %1% packets/s over %2% threads\n") % (count * thread_count * 1000000 / std::max <uint64_t> (1, elapsed.count ())) % thread_count);
+}
@@ -1363,6 +1363,41 @@ TEST (rpc, search_pending)
 	}
 }
 
+TEST (rpc, network_stats)
+{
+    rai::system system (24000, 2);
+    auto & node1 (*system.nodes [0]);
+	system.nodes [1]->network.send_keepalive (node1.network.endpoint ());
+	auto iterations (0);
+	while (node1.network.incoming.keepalive == 0)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+    rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+    boost::property_tree::ptree request1;
+	request1.put ("action", "network_stats");
+	test_response response1 (request1, rpc, system.service);
+	while (response1.status == 0)
+	{
+		system.poll ();
+	}
+    ASSERT_EQ (200, response1.status);
+	auto & receivers (response1.json.get_child ("receivers"));
+	ASSERT_EQ (node1.network.receivers.size (), receivers.size ());
+	uint64_t packets (0);
+	for (auto & i : receivers)
+	{
+		packets += std::stoull (i.second.get <std::string> ("packets"));
+	}
+	ASSERT_LE (1, packets);
+	ASSERT_EQ ("0", response1.json.get <std::string> ("error"));
+	ASSERT_EQ ("0", response1.json.get <std::string> ("dropped.keepalive"));
+	ASSERT_EQ ("0", response1.json.get <std::string> ("send_queue.dropped_bytes"));
+}
+
 TEST (rpc, version)
 {
     rai::system system (24000, 1);
@@ -1383,7 +1418,7 @@ TEST (rpc, version)
     ASSERT_EQ (200, response1.status);
 	ASSERT_EQ ("1", response1.json.get <std::string> ("rpc_version"));
     ASSERT_EQ (200, response1.status);
-	ASSERT_EQ ("10", response1.json.get <std::string> ("store_version"));
+	ASSERT_EQ ("12", response1.json.get <std::string> ("store_version"));
 	ASSERT_EQ (boost::str (boost::format ("RaiBlocks %1%.%2%") % RAIBLOCKS_VERSION_MAJOR % RAIBLOCKS_VERSION_MINOR), response1.json.get <std::string> ("node_vendor"));
 	auto headers (response1.resp.find ("Access-Control-Allow-Origin"));
 	ASSERT_NE (response1.resp.end (), headers);
@@ -1556,6 +1591,57 @@ TEST (rpc, block_count)
 	ASSERT_EQ ("0", response1.json.get <std::string> ("unchecked"));
 }
 
+TEST (rpc, block_processor)
+{
+    rai::system system (24000, 1);
+    auto & node1 (*system.nodes [0]);
+	rai::keypair key1;
+	node1.block_processor.add (rai::block_processor_item (std::make_shared <rai::send_block> (rai::genesis ().hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0)));
+	node1.block_processor.flush ();
+    rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+    boost::property_tree::ptree request1;
+	request1.put ("action", "block_processor");
+	test_response response1 (request1, rpc, system.service);
+	while (response1.status == 0)
+	{
+		system.poll ();
+	}
+    ASSERT_EQ (200, response1.status);
+	for (auto stage : { "hash", "verify", "dependencies", "commit" })
+	{
+		auto & entry (response1.json.get_child (stage));
+		ASSERT_EQ ("0", entry.get <std::string> ("queued"));
+		ASSERT_EQ ("1", entry.get <std::string> ("blocks"));
+		ASSERT_EQ ("1", entry.get <std::string> ("batches"));
+		entry.get <std::string> ("latency");
+	}
+}
+
+TEST (rpc, unchecked_pool)
+{
+    rai::system system (24000, 1);
+    auto & node1 (*system.nodes [0]);
+	rai::keypair key1;
+	// A send whose previous block is unknown waits in the pool
+	node1.block_processor.add (rai::block_processor_item (std::make_shared <rai::send_block> (1, key1.pub, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0)));
+	node1.block_processor.flush ();
+    rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+    boost::property_tree::ptree request1;
+	request1.put ("action", "unchecked_pool");
+	test_response response1 (request1, rpc, system.service);
+	while (response1.status == 0)
+	{
+		system.poll ();
+	}
+    ASSERT_EQ (200, response1.status);
+	ASSERT_EQ ("1", response1.json.get <std::string> ("memory"));
+	ASSERT_EQ ("0", response1.json.get <std::string> ("stored"));
+	ASSERT_EQ ("0", response1.json.get <std::string> ("spilled"));
+	ASSERT_EQ (std::to_string (node1.config.unchecked_pool_max), response1.json.get <std::string> ("max"));
+}
+
 TEST (rpc, frontier_count)
 {
     rai::system system (24000, 1);
@@ -1801,6 +1887,45 @@ TEST (rpc, bootstrap)
 	}
 }
 
+TEST (rpc, bootstrap_status)
+{
+    rai::system system (24000, 1);
+	auto node (system.nodes [0]);
+    rai::rpc rpc (system.service, *node, rai::rpc_config (true));
+	rpc.start ();
+    boost::property_tree::ptree request;
+	request.put ("action", "bootstrap_status");
+	test_response response1 (request, rpc, system.service);
+	while (response1.status == 0)
+	{
+		system.poll ();
+	}
+    ASSERT_EQ (200, response1.status);
+	ASSERT_EQ ("false", response1.json.get <std::string> ("bootstrapping"));
+	auto attempt (std::make_shared <rai::bootstrap_attempt> (node));
+	auto client (std::make_shared <rai::bootstrap_client> (node, attempt, rai::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24001)));
+	client->block_count = 30;
+	client->streamed_count = 30;
+	client->pull_time = 3000000;
+	attempt->clients.push_back (client);
+	node->bootstrap_initiator.attempt = attempt;
+	test_response response2 (request, rpc, system.service);
+	while (response2.status == 0)
+	{
+		system.poll ();
+	}
+    ASSERT_EQ (200, response2.status);
+	node->bootstrap_initiator.attempt.reset ();
+	ASSERT_EQ ("true", response2.json.get <std::string> ("bootstrapping"));
+	ASSERT_EQ ("0", response2.json.get <std::string> ("pulls"));
+	auto & peers (response2.json.get_child ("peers"));
+	ASSERT_EQ (1, peers.size ());
+	auto & peer (peers.begin ()->second);
+	ASSERT_EQ ("30", peer.get <std::string> ("blocks"));
+	ASSERT_DOUBLE_EQ (10.0, std::stod (peer.get <std::string> ("blocks_per_second")));
+	ASSERT_EQ ("false", peer.get <std::string> ("pulling"));
+}
+
 TEST (rpc, account_remove)
 {
     rai::system system0 (24000, 1);
@@ -44,9 +44,60 @@ std::string rai::block::to_json ()
 	return result;
 }
 
+std::atomic <uint64_t> rai::block::hashes_computed (0);
+
+rai::block::block () :
+hash_state (hash_empty)
+{
+}
+
+rai::block::block (rai::block const & other_a) :
+hash_state (hash_empty)
+{
+	*this = other_a;
+}
+
+rai::block & rai::block::operator = (rai::block const & other_a)
+{
+	if (other_a.hash_state.load (std::memory_order_acquire) == hash_cached)
+	{
+		cached_hash = other_a.cached_hash;
+		hash_state.store (hash_cached, std::memory_order_release);
+	}
+	else
+	{
+		hash_state.store (hash_empty, std::memory_order_relaxed);
+	}
+	return *this;
+}
+
 rai::block_hash rai::block::hash () const
 {
-	rai::uint256_union result;
+	rai::block_hash result;
+	if (hash_state.load (std::memory_order_acquire) == hash_cached)
+	{
+		result = cached_hash;
+		// Catches hashables changed without a refresh, compiled out along with the other asserts
+		assert (result == compute_hash ());
+	}
+	else
+	{
+		++hashes_computed;
+		result = compute_hash ();
+		// Only one thread fills in the cache, others racing with it return their own copy
+		uint8_t expected (hash_empty);
+		if (hash_state.compare_exchange_strong (expected, hash_filling, std::memory_order_acquire))
+		{
+			cached_hash = result;
+			hash_state.store (hash_cached, std::memory_order_release);
+		}
+	}
+	return result;
+}
+
+rai::block_hash rai::block::compute_hash () const
+{
+	rai::block_hash result;
 	blake2b_state hash_l;
 	auto status (blake2b_init (&hash_l, sizeof (result.bytes)));
 	assert (status == 0);
@@ -56,6 +107,11 @@ rai::block_hash rai::block::hash () const
 	return result;
 }
 
+void rai::block::refresh ()
+{
+	hash_state.store (hash_empty, std::memory_order_release);
+}
+
 void rai::send_block::visit (rai::block_visitor & visitor_a) const
 {
 	visitor_a.send_block (*this);
@@ -74,6 +130,7 @@ uint64_t rai::send_block::block_work () const
 void rai::send_block::block_work_set (uint64_t work_a)
 {
 	work = work_a;
+	refresh ();
 }
 
 rai::send_hashables::send_hashables (rai::block_hash const & previous_a, rai::account const & destination_a, rai::amount const & balance_a) :
@@ -160,6 +217,7 @@ void rai::send_block::serialize_json (std::string & string_a) const
 
 bool rai::send_block::deserialize (rai::stream & stream_a)
 {
+	refresh ();
 	auto result (false);
 	result = read (stream_a, hashables.previous.bytes);
 	if (!result)
@@ -183,6 +241,7 @@ bool rai::send_block::deserialize (rai::stream & stream_a)
 
 bool rai::send_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
+	refresh ();
 	auto result (false);
 	try
 	{
@@ -301,9 +360,15 @@ rai::account rai::send_block::representative () const
 	return 0;
 }
 
+rai::signature rai::send_block::block_signature () const
+{
+	return signature;
+}
+
 void rai::send_block::signature_set (rai::uint512_union const & signature_a)
 {
 	signature = signature_a;
+	refresh ();
 }
 
 rai::open_hashables::open_hashables (rai::block_hash const & source_a, rai::account const & representative_a, rai::account const & account_a) :
@@ -419,6 +484,7 @@ uint64_t rai::open_block::block_work () const
 void rai::open_block::block_work_set (uint64_t work_a)
 {
 	work = work_a;
+	refresh ();
 }
 
 rai::block_hash rai::open_block::previous () const
@@ -454,6 +520,7 @@ void rai::open_block::serialize_json (std::string & string_a) const
 
 bool rai::open_block::deserialize (rai::stream & stream_a)
 {
+	refresh ();
 	auto result (read (stream_a, hashables.source));
 	if (!result)
 	{
@@ -476,6 +543,7 @@ bool rai::open_block::deserialize (rai::stream & stream_a)
 
 bool rai::open_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
+	refresh ();
 	auto result (false);
 	try
 	{
@@ -551,9 +619,15 @@ rai::account rai::open_block::representative () const
 	return hashables.representative;
 }
 
+rai::signature rai::open_block::block_signature () const
+{
+	return signature;
+}
+
 void rai::open_block::signature_set (rai::uint512_union const & signature_a)
 {
 	signature = signature_a;
+	refresh ();
 }
 
 rai::change_hashables::change_hashables (rai::block_hash const & previous_a, rai::account const & representative_a) :
@@ -650,6 +724,7 @@ uint64_t rai::change_block::block_work () const
 void rai::change_block::block_work_set (uint64_t work_a)
 {
 	work = work_a;
+	refresh ();
 }
 
 rai::block_hash rai::change_block::previous () const
@@ -682,6 +757,7 @@ void rai::change_block::serialize_json (std::string & string_a) const
 
 bool rai::change_block::deserialize (rai::stream & stream_a)
 {
+	refresh ();
 	auto result (read (stream_a, hashables.previous));
 	if (!result)
 	{
@@ -700,6 +776,7 @@ bool rai::change_block::deserialize (rai::stream & stream_a)
 
 bool rai::change_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
+	refresh ();
 	auto result (false);
 	try
 	{
@@ -770,9 +847,15 @@ rai::account rai::change_block::representative () const
 	return hashables.representative;
 }
 
+rai::signature rai::change_block::block_signature () const
+{
+	return signature;
+}
+
 void rai::change_block::signature_set (rai::uint512_union const & signature_a)
 {
 	signature = signature_a;
+	refresh ();
 }
 
 std::unique_ptr <rai::block> rai::deserialize_block_json (boost::property_tree::ptree const & tree_a)
@@ -836,6 +919,29 @@ std::unique_ptr <rai::block> rai::deserialize_block (rai::stream & stream_a)
 	return result;
 }
 
+size_t rai::block_size (rai::block_type type_a)
+{
+	size_t result (0);
+	switch (type_a)
+	{
+		case rai::block_type::send:
+			result = rai::send_block::size;
+			break;
+		case rai::block_type::receive:
+			result = rai::receive_block::size;
+			break;
+		case rai::block_type::open:
+			result = rai::open_block::size;
+			break;
+		case rai::block_type::change:
+			result = rai::change_block::size;
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
 std::unique_ptr <rai::block> rai::deserialize_block (rai::stream & stream_a, rai::block_type type_a)
 {
 	std::unique_ptr <rai::block> result;
@@ -901,6 +1007,7 @@ bool rai::receive_block::operator == (rai::receive_block const & other_a) const
 
 bool rai::receive_block::deserialize (rai::stream & stream_a)
 {
+	refresh ();
 	auto result (false);
 	result = read (stream_a, hashables.previous.bytes);
 	if (!result)
@@ -920,6 +1027,7 @@ bool rai::receive_block::deserialize (rai::stream & stream_a)
 
 bool rai::receive_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
+	refresh ();
 	auto result (false);
 	try
 	{
@@ -1031,6 +1139,7 @@ uint64_t rai::receive_block::block_work () const
 void rai::receive_block::block_work_set (uint64_t work_a)
 {
 	work = work_a;
+	refresh ();
 }
 
 bool rai::receive_block::operator == (rai::block const & other_a) const
@@ -1064,9 +1173,15 @@ rai::account rai::receive_block::representative () const
 	return 0;
 }
 
+rai::signature rai::receive_block::block_signature () const
+{
+	return signature;
+}
+
 void rai::receive_block::signature_set (rai::uint512_union const & signature_a)
 {
 	signature = signature_a;
+	refresh ();
 }
 
 rai::block_type rai::receive_block::type () const
@@ -3,6 +3,7 @@
 #include <rai/lib/numbers.hpp>
 
 #include <assert.h>
+#include <atomic>
 #include <blake2/blake2.h>
 #include <boost/property_tree/json_parser.hpp>
 #include <streambuf>
@@ -41,8 +42,13 @@ enum class block_type : uint8_t
 class block
 {
 public:
-	// Return a digest of the hashables in this block.
+	block ();
+	block (rai::block const &);
+	rai::block & operator = (rai::block const &);
+	// Return a digest of the hashables in this block, computed once and cached until the block is modified
 	rai::block_hash hash () const;
+	// Discard the cached hash, needed after modifying hashables directly, debug builds assert if it's missed
+	void refresh ();
 	std::string to_json ();
 	virtual void hash (blake2b_state &) const = 0;
 	virtual uint64_t block_work () const = 0;
@@ -59,7 +65,17 @@ public:
 	virtual void visit (rai::block_visitor &) const = 0;
 	virtual bool operator == (rai::block const &) const = 0;
 	virtual rai::block_type type () const = 0;
+	virtual rai::signature block_signature () const = 0;
 	virtual void signature_set (rai::uint512_union const &) = 0;
+	// Number of times a block hash has been computed rather than read from the cache
+	static std::atomic <uint64_t> hashes_computed;
+private:
+	rai::block_hash compute_hash () const;
+	static uint8_t constexpr hash_empty = 0;
+	static uint8_t constexpr hash_filling = 1;
+	static uint8_t constexpr hash_cached = 2;
+	mutable std::atomic <uint8_t> hash_state;
+	mutable rai::block_hash cached_hash;
 };
 class send_hashables
 {
@@ -92,6 +108,7 @@ public:
 	bool deserialize_json (boost::property_tree::ptree const &);
 	void visit (rai::block_visitor &) const override;
 	rai::block_type type () const override;
+	rai::signature block_signature () const override;
 	void signature_set (rai::uint512_union const &) override;
 	bool operator == (rai::block const &) const override;
 	bool operator == (rai::send_block const &) const;
@@ -130,6 +147,7 @@ public:
 	bool deserialize_json (boost::property_tree::ptree const &);
 	void visit (rai::block_visitor &) const override;
 	rai::block_type type () const override;
+	rai::signature block_signature () const override;
 	void signature_set (rai::uint512_union const &) override;
 	bool operator == (rai::block const &) const override;
 	bool operator == (rai::receive_block const &) const;
@@ -170,6 +188,7 @@ public:
 	bool deserialize_json (boost::property_tree::ptree const &);
 	void visit (rai::block_visitor &) const override;
 	rai::block_type type () const override;
+	rai::signature block_signature () const override;
 	void signature_set (rai::uint512_union const &) override;
 	bool operator == (rai::block const &) const override;
 	bool operator == (rai::open_block const &) const;
@@ -208,6 +227,7 @@ public:
 	bool deserialize_json (boost::property_tree::ptree const &);
 	void visit (rai::block_visitor &) const override;
 	rai::block_type type () const override;
+	rai::signature block_signature () const override;
 	void signature_set (rai::uint512_union const &) override;
 	bool operator == (rai::block const &) const override;
 	bool operator == (rai::change_block const &) const;
@@ -228,4 +248,6 @@ std::unique_ptr <rai::block> deserialize_block (rai::stream &);
 std::unique_ptr <rai::block> deserialize_block (rai::stream &, rai::block_type);
 std::unique_ptr <rai::block> deserialize_block_json (boost::property_tree::ptree const &);
 void serialize_block (rai::stream &, rai::block const &);
+// Serialized size of a block of this type, zero if the type has no block
+size_t block_size (rai::block_type);
 }
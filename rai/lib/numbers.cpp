@@ -462,6 +462,13 @@ bool rai::validate_message (rai::public_key const & public_key, rai::uint256_uni
 	return result;
 }
 
+// Verifies `size' signatures at once, valid_a [i] is set to 1 for each valid signature and 0 otherwise
+bool rai::validate_message_batch (unsigned char const ** messages_a, size_t * message_lengths_a, unsigned char const ** public_keys_a, unsigned char const ** signatures_a, size_t size_a, int * valid_a)
+{
+	auto result (0 != ed25519_sign_open_batch (messages_a, message_lengths_a, public_keys_a, signatures_a, size_a, valid_a));
+	return result;
+}
+
 rai::uint128_union::uint128_union (std::string const & string_a)
 {
 	decode_hex (string_a);
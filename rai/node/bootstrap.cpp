@@ -5,6 +5,22 @@
 
 #include <boost/log/trivial.hpp>
 
+std::chrono::seconds constexpr rai::bootstrap_attempt::steal_cutoff;
+double constexpr rai::bootstrap_attempt::minimum_blocks_per_second;
+std::chrono::seconds constexpr rai::bootstrap_attempt::minimum_rate_time;
+std::chrono::seconds constexpr rai::bootstrap_attempt::frontier_connection_wait;
+size_t constexpr rai::frontier_req_client::frontier_size;
+size_t constexpr rai::frontier_req_client::frontiers_per_read;
+size_t constexpr rai::frontier_req_server::frontiers_per_write;
+
+namespace
+{
+int64_t steady_microseconds ()
+{
+	return std::chrono::duration_cast <std::chrono::microseconds> (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+}
+
 rai::block_synchronization::block_synchronization (boost::log::sources::logger_mt & log_a) :
 log (log_a)
 {
@@ -151,7 +167,12 @@ node (node_a),
 attempt (attempt_a),
 socket (node_a->service),
 endpoint (endpoint_a),
-timeout (node_a->service)
+timeout (node_a->service),
+block_count (0),
+streamed_count (0),
+pull_time (0),
+pull_start (0),
+pull_active (false)
 {
 	++attempt->connections;
 }
@@ -188,6 +209,55 @@ void rai::bootstrap_client::stop_timeout ()
 	(void) killed;
 }
 
+void rai::bootstrap_client::start_pull ()
+{
+	pull_start = 0;
+	pull_active = true;
+}
+
+void rai::bootstrap_client::end_pull ()
+{
+	pull_active = false;
+	auto start (pull_start.exchange (0));
+	if (start != 0)
+	{
+		pull_time += steady_microseconds () - start;
+	}
+}
+
+void rai::bootstrap_client::pulled_block ()
+{
+	++block_count;
+	// Short pulls are mostly the peer looking up the account, timing from the first block keeps them from reading as a slow connection
+	int64_t expected (0);
+	if (!pull_start.compare_exchange_strong (expected, steady_microseconds ()))
+	{
+		++streamed_count;
+	}
+}
+
+double rai::bootstrap_client::pull_seconds ()
+{
+	auto start (pull_start.load ());
+	auto result (pull_time.load ());
+	if (start != 0)
+	{
+		result += steady_microseconds () - start;
+	}
+	return result / 1000000.0;
+}
+
+double rai::bootstrap_client::block_rate ()
+{
+	auto seconds (pull_seconds ());
+	return seconds > 0 ? streamed_count / seconds : 0.0;
+}
+
+bool rai::bootstrap_client::pulling ()
+{
+	return pull_active;
+}
+
 void rai::bootstrap_client::run ()
 {
     auto this_l (shared_from_this ());
@@ -222,7 +292,7 @@ void rai::bootstrap_client::run ()
 void rai::frontier_req_client::run ()
 {
 	std::unique_ptr <rai::frontier_req> request (new rai::frontier_req);
-	request->start.clear ();
+	request->start = start;
 	request->age = std::numeric_limits <decltype (request->age)>::max ();
 	request->count = std::numeric_limits <decltype (request->age)>::max ();
 	auto send_buffer (std::make_shared <std::vector <uint8_t>> ());
@@ -254,13 +324,18 @@ std::shared_ptr <rai::bootstrap_client> rai::bootstrap_client::shared ()
 	return shared_from_this ();
 }
 
-rai::frontier_req_client::frontier_req_client (std::shared_ptr <rai::bootstrap_client> connection_a) :
+rai::frontier_req_client::frontier_req_client (std::shared_ptr <rai::bootstrap_client> connection_a, rai::account const & start_a, rai::account const & end_a) :
 connection (connection_a),
-current (0),
+start (start_a),
+end (end_a),
+current (start_a.number () - 1),
 count (0),
 landing ("059F68AAB29DE0D3A27443625C7EA9CDDB6517A8B76FE37727EF6A4D76832AD5"),
 faucet ("8E319CE6F3025E5B2DF66DA7AB1467FE48F1679C13DD43BFDB29FA2E9FC40D3B"),
-next_report (std::chrono::system_clock::now () + std::chrono::seconds (15))
+next_report (std::chrono::system_clock::now () + std::chrono::seconds (15)),
+receive_buffer (frontier_size * frontiers_per_read),
+received (0),
+priority_pulls (0)
 {
 	rai::transaction transaction (connection->node->store.environment, nullptr, false);
 	next (transaction);
@@ -274,7 +349,9 @@ void rai::frontier_req_client::receive_frontier ()
 {
     auto this_l (shared_from_this ());
 	connection->start_timeout ();
-    boost::asio::async_read (connection->socket, boost::asio::buffer (connection->receive_buffer.data (), sizeof (rai::uint256_union) + sizeof (rai::uint256_union)), [this_l] (boost::system::error_code const & ec, size_t size_a)
+	assert (received < frontier_size);
+	// Fill as much of the buffer as is available but wait for at least one whole frontier
+    boost::asio::async_read (connection->socket, boost::asio::buffer (receive_buffer.data () + received, receive_buffer.size () - received), boost::asio::transfer_at_least (frontier_size - received), [this_l] (boost::system::error_code const & ec, size_t size_a)
     {
 		this_l->connection->stop_timeout ();
         this_l->received_frontier (ec, size_a);
@@ -288,11 +365,12 @@ void rai::frontier_req_client::request_account (rai::account const & account_a,
 	rai::account account_2 ("FD6EE9E0E107A6A8584DB94A3F154799DD5C2A7D6ABED0889DA3B837B0E61663"); // xrb_3zdgx9ig43x8o3e6ugcc9wcnh8gxdio9ttoyt46buaxr8yrge7m5331qdwhk
 	if (account_a != landing && account_a != faucet && account_a != account_1 && account_a != account_2)
 	{
-		connection->attempt->pulls.push_back (rai::pull_info (account_a, latest_a, rai::block_hash (0)));
+		pulls.push_back (rai::pull_info (account_a, latest_a, rai::block_hash (0)));
 	}
 	else
 	{
-		connection->attempt->pulls.push_front (rai::pull_info (account_a, latest_a, rai::block_hash (0)));
+		pulls.push_front (rai::pull_info (account_a, latest_a, rai::block_hash (0)));
+		++priority_pulls;
 	}
 }
 
@@ -311,104 +389,98 @@ void rai::frontier_req_client::received_frontier (boost::system::error_code cons
 {
 	if (!ec)
 	{
-		assert (size_a == sizeof (rai::uint256_union) + sizeof (rai::uint256_union));
-		rai::account account;
-		rai::bufferstream account_stream (connection->receive_buffer.data (), sizeof (rai::uint256_union));
-		auto error1 (rai::read (account_stream, account));
-		assert (!error1);
-		rai::block_hash latest;
-		rai::bufferstream latest_stream (connection->receive_buffer.data () + sizeof (rai::uint256_union), sizeof (rai::uint256_union));
-		auto error2 (rai::read (latest_stream, latest));
-		assert (!error2);
-		++count;
-		auto now (std::chrono::system_clock::now ());
-		if (next_report < now)
-		{
-			next_report = now + std::chrono::seconds (15);
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Received %1% frontiers from %2%") % std::to_string (count) % connection->socket.remote_endpoint ());
-		}
-		if (!account.is_zero ())
+		received += size_a;
+		assert (received >= frontier_size);
+		auto finished (false);
+		auto range_end (false);
+		size_t offset (0);
 		{
-			while (!current.is_zero () && current < account)
+			// Compare the whole chunk against our accounts with one read transaction and cursor
+			rai::transaction transaction (connection->node->store.environment, nullptr, false);
+			auto i (current.is_zero () ? connection->node->store.latest_end () : connection->node->store.latest_begin (transaction, current));
+			next (i);
+			for (; !finished && offset + frontier_size <= received; offset += frontier_size)
 			{
-				// We know about an account they don't.
-				rai::transaction transaction (connection->node->store.environment, nullptr, true);
-				if (connection->node->wallets.exists (transaction, current))
+				rai::account account;
+				rai::bufferstream account_stream (receive_buffer.data () + offset, sizeof (rai::uint256_union));
+				auto error1 (rai::read (account_stream, account));
+				assert (!error1);
+				rai::block_hash latest;
+				rai::bufferstream latest_stream (receive_buffer.data () + offset + sizeof (rai::uint256_union), sizeof (rai::uint256_union));
+				auto error2 (rai::read (latest_stream, latest));
+				assert (!error2);
+				range_end = !account.is_zero () && !end.is_zero () && !(account < end);
+				if (!account.is_zero () && !range_end)
 				{
-					unsynced (transaction, info.head, 0);
+					++count;
+					process_frontier (transaction, i, account, latest);
 				}
-				next (transaction);
-			}
-			if (!current.is_zero ())
-			{
-				if (account == current)
+				else
 				{
-					rai::transaction transaction (connection->node->store.environment, nullptr, true);
-					if (latest == info.head)
+					while (!current.is_zero () && (end.is_zero () || current < end))
 					{
-						// In sync
-					}
-					else
-					{
-						if (connection->node->store.block_exists (transaction, latest))
-						{
-							// We know about a block they don't.
-							if (connection->node->wallets.exists (transaction, current))
-							{
-								unsynced (transaction, info.head, latest);
-							}
-						}
-						else
+						// We know about an account they don't.
+						if (connection->node->wallets.exists (transaction, current))
 						{
-							// They know about a block we don't.
-							if (account != rai::genesis_account && account != landing && account != faucet)
-							{
-								connection->attempt->pulls.push_back (rai::pull_info (account, latest, info.head));
-							}
-							else
-							{
-								connection->attempt->pulls.push_front (rai::pull_info (account, latest, info.head));
-							}
+							unsynced_pending.push_back (std::make_pair (info.head, rai::block_hash (0)));
 						}
+						++i;
+						next (i);
 					}
-					next (transaction);
-				}
-				else
-				{
-					assert (account < current);
-					request_account (account, latest);
+					finished = true;
 				}
 			}
-			else
+		}
+		if (!unsynced_pending.empty ())
+		{
+			rai::transaction transaction (connection->node->store.environment, nullptr, true);
+			for (auto & i : unsynced_pending)
 			{
-				request_account (account, latest);
+				unsynced (transaction, i.first, i.second);
 			}
+			unsynced_pending.clear ();
+		}
+		if (!pulls.empty ())
+		{
+			// Other ranges are merging into the same queue, take the attempt lock once per chunk
+			std::lock_guard <std::mutex> lock (connection->attempt->mutex);
+			auto & queue (connection->attempt->pulls);
+			queue.insert (queue.begin (), pulls.begin (), pulls.begin () + priority_pulls);
+			queue.insert (queue.end (), pulls.begin () + priority_pulls, pulls.end ());
+			pulls.clear ();
+			priority_pulls = 0;
+		}
+		auto now (std::chrono::system_clock::now ());
+		if (next_report < now)
+		{
+			next_report = now + std::chrono::seconds (15);
+			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Received %1% frontiers from %2%") % std::to_string (count) % connection->socket.remote_endpoint ());
+		}
+		if (!finished)
+		{
+			// Keep the partial frontier, if any, for the next read
+			std::copy (receive_buffer.begin () + offset, receive_buffer.begin () + received, receive_buffer.begin ());
+			received -= offset;
 			receive_frontier ();
 		}
 		else
 		{
+			try
 			{
-				rai::transaction transaction (connection->node->store.environment, nullptr, true);
-				while (!current.is_zero ())
-				{
-					// We know about an account they don't.
-					if (connection->node->wallets.exists (transaction, current))
-					{
-						unsynced (transaction, info.head, 0);
-					}
-					next (transaction);
-				}
+				promise.set_value (false);
 			}
+			catch (std::future_error &)
+			{
+			}
+			if (!range_end)
 			{
-				try
-				{
-					promise.set_value (false);
-				}
-				catch (std::future_error &)
-				{
-				}
 				connection->attempt->pool_connection (connection);
 			}
+			else
+			{
+				// The server keeps streaming past our range and the protocol has no way to stop it short of closing
+				connection->socket.close ();
+			}
 		}
 	}
 	else
@@ -420,13 +492,77 @@ void rai::frontier_req_client::received_frontier (boost::system::error_code cons
 	}
 }
 
+void rai::frontier_req_client::process_frontier (MDB_txn * transaction_a, rai::store_iterator & iterator_a, rai::account const & account_a, rai::block_hash const & latest_a)
+{
+	while (!current.is_zero () && current < account_a)
+	{
+		// We know about an account they don't.
+		if (connection->node->wallets.exists (transaction_a, current))
+		{
+			unsynced_pending.push_back (std::make_pair (info.head, rai::block_hash (0)));
+		}
+		++iterator_a;
+		next (iterator_a);
+	}
+	if (!current.is_zero ())
+	{
+		if (account_a == current)
+		{
+			if (latest_a == info.head)
+			{
+				// In sync
+			}
+			else
+			{
+				if (connection->node->store.block_exists (transaction_a, latest_a))
+				{
+					// We know about a block they don't.
+					if (connection->node->wallets.exists (transaction_a, current))
+					{
+						unsynced_pending.push_back (std::make_pair (info.head, latest_a));
+					}
+				}
+				else
+				{
+					// They know about a block we don't.
+					if (account_a != rai::genesis_account && account_a != landing && account_a != faucet)
+					{
+						pulls.push_back (rai::pull_info (account_a, latest_a, info.head));
+					}
+					else
+					{
+						pulls.push_front (rai::pull_info (account_a, latest_a, info.head));
+						++priority_pulls;
+					}
+				}
+			}
+			++iterator_a;
+			next (iterator_a);
+		}
+		else
+		{
+			assert (account_a < current);
+			request_account (account_a, latest_a);
+		}
+	}
+	else
+	{
+		request_account (account_a, latest_a);
+	}
+}
+
 void rai::frontier_req_client::next (MDB_txn * transaction_a)
 {
 	auto iterator (connection->node->store.latest_begin (transaction_a, rai::uint256_union (current.number () + 1)));
-	if (iterator != connection->node->store.latest_end ())
+	next (iterator);
+}
+
+void rai::frontier_req_client::next (rai::store_iterator & iterator_a)
+{
+	if (iterator_a != connection->node->store.latest_end ())
 	{
-		current = rai::account (iterator->first.uint256 ());
-		info = rai::account_info (iterator->second);
+		current = rai::account (iterator_a->first.uint256 ());
+		info = rai::account_info (iterator_a->second);
 	}
 	else
 	{
@@ -439,6 +575,7 @@ connection (connection_a)
 {
 	assert (!connection->attempt->mutex.try_lock ());
 	++connection->attempt->pulling;
+	connection->start_pull ();
 	connection->attempt->condition.notify_all ();
 }
 
@@ -447,6 +584,7 @@ rai::bulk_pull_client::~bulk_pull_client ()
 	{
 		std::lock_guard <std::mutex> mutex (connection->attempt->mutex);
 		--connection->attempt->pulling;
+		connection->attempt->running.erase (this);
 		connection->attempt->condition.notify_all ();
 	}
 	if (!pull.account.is_zero ())
@@ -557,9 +695,11 @@ void rai::bulk_pull_client::received_type ()
 		}
 		case rai::block_type::not_a_block:
 		{
+			connection->end_pull ();
 			connection->attempt->pool_connection (connection);
 			if (expected == pull.end)
 			{
+				*pull.completed = true;
 				pull = rai::pull_info ();
 			}
 			break;
@@ -581,6 +721,7 @@ void rai::bulk_pull_client::received_block (boost::system::error_code const & ec
 		if (block != nullptr)
 		{
 			auto hash (block->hash ());
+			connection->pulled_block ();
 			if (connection->node->config.logging.bulk_pull_logging ())
 			{
 				std::string block_l;
@@ -593,7 +734,7 @@ void rai::bulk_pull_client::received_block (boost::system::error_code const & ec
 			}
 			auto attempt_l (connection->attempt);
 			auto pull_l (pull);
-			attempt_l->node->block_processor.add (rai::block_processor_item (block, [attempt_l, pull_l] (MDB_txn * transaction_a, rai::process_return result_a, std::shared_ptr <rai::block> block_a)
+			rai::block_processor_item item (block, [attempt_l, pull_l] (MDB_txn * transaction_a, rai::process_return result_a, std::shared_ptr <rai::block> block_a)
 			{
 				switch (result_a.code)
 				{
@@ -615,8 +756,22 @@ void rai::bulk_pull_client::received_block (boost::system::error_code const & ec
 					default:
 						break;
 				}
-			}));
-			receive_block ();
+			});
+			item.bootstrap = true;
+			attempt_l->node->block_processor.add (item);
+			if (!*pull.completed)
+			{
+				receive_block ();
+			}
+			else
+			{
+				// Another connection finished this pull first, the rest of the stream isn't needed
+				if (connection->node->config.logging.bulk_pull_logging ())
+				{
+					BOOST_LOG (connection->node->log) << boost::str (boost::format ("Dropping %1%, account %2% was pulled from a faster peer") % connection->endpoint % pull.account.to_account ());
+				}
+				connection->socket.close ();
+			}
 		}
 		else
 		{
@@ -753,7 +908,8 @@ void rai::bulk_push_client::push_block (rai::block const & block_a)
 rai::pull_info::pull_info () :
 account (0),
 end (0),
-attempts (0)
+attempts (0),
+completed (std::make_shared <std::atomic <bool>> (false))
 {
 }
 
@@ -761,7 +917,8 @@ rai::pull_info::pull_info (rai::account const & account_a, rai::block_hash const
 account (account_a),
 head (head_a),
 end (end_a),
-attempts (0)
+attempts (0),
+completed (std::make_shared <std::atomic <bool>> (false))
 {
 }
 
@@ -786,17 +943,41 @@ bool rai::bootstrap_attempt::request_frontier (std::unique_lock <std::mutex> & l
 {
     auto result (true);
     auto connection_l (connection (lock_a));
-    if (connection_l)
+	auto ranges (std::max <size_t> (1, node->config.bootstrap_frontier_ranges));
+	if (connection_l)
+	{
+		// Give connections still being opened a moment so the scan can be split between them
+		condition.wait_for (lock_a, frontier_connection_wait, [this, ranges] () { return stopped || idle.size () + 1 >= std::min <size_t> (ranges, connections); });
+	}
+	// Nothing would resolve the frontier promises once stop has run
+    if (connection_l && !stopped)
     {
-        std::future <bool> future;
-        {
-            auto client (std::make_shared <rai::frontier_req_client> (connection_l));
-            client->run ();
-			frontiers = client;
-            future = client->promise.get_future ();
-        }
+		std::vector <std::shared_ptr <rai::bootstrap_client>> connections_l (1, connection_l);
+		while (!idle.empty () && connections_l.size () < ranges)
+		{
+			connections_l.push_back (idle.back ());
+			idle.pop_back ();
+		}
+		// Split the account space evenly, each connection compares its own range and merges pulls into the shared queue
+		std::vector <std::future <bool>> futures;
+		frontiers.clear ();
+		rai::uint256_t step (std::numeric_limits <rai::uint256_t>::max () / connections_l.size ());
+		for (size_t i (0), n (connections_l.size ()); i < n; ++i)
+		{
+			rai::account start (step * i);
+			rai::account end (i + 1 < n ? rai::account (step * (i + 1)) : rai::account (0));
+			auto client (std::make_shared <rai::frontier_req_client> (connections_l [i], start, end));
+			client->run ();
+			frontiers.push_back (client);
+			futures.push_back (client->promise.get_future ());
+		}
         lock_a.unlock ();
-        result = consume_future (future);
+		result = false;
+		for (auto & i : futures)
+		{
+			// Wait on every range even after a failure so none are still merging when the queue is cleared
+			result |= consume_future (i);
+		}
         lock_a.lock ();
         if (result)
         {
@@ -806,7 +987,7 @@ bool rai::bootstrap_attempt::request_frontier (std::unique_lock <std::mutex> & l
         {
             if (!result)
             {
-                BOOST_LOG (node->log) << boost::str (boost::format ("Completed frontier request, %1% out of sync accounts according to %2%") % pulls.size () % connection_l->endpoint);
+                BOOST_LOG (node->log) << boost::str (boost::format ("Completed frontier request, %1% out of sync accounts according to %2% connections starting with %3%") % pulls.size () % connections_l.size () % connection_l->endpoint);
             }
             else
             {
@@ -824,14 +1005,62 @@ void rai::bootstrap_attempt::request_pull (std::unique_lock <std::mutex> & lock_
 	{
 		auto pull (pulls.front ());
 		pulls.pop_front ();
-		auto client (std::make_shared <rai::bulk_pull_client> (connection_l));
-		// The bulk_pull_client destructor attempt to requeue_pull which can cause a deadlock if this is the last reference
-		// Dispatch request in an external thread in case it needs to be destroyed
-		node->background ([client, pull] ()
+		dispatch_pull (connection_l, pull, false);
+	}
+}
+
+void rai::bootstrap_attempt::dispatch_pull (std::shared_ptr <rai::bootstrap_client> connection_a, rai::pull_info const & pull_a, bool duplicated_a)
+{
+	assert (!mutex.try_lock ());
+	auto client (std::make_shared <rai::bulk_pull_client> (connection_a));
+	running [client.get ()] = rai::running_pull ({connection_a, pull_a, std::chrono::steady_clock::now (), duplicated_a});
+	// The bulk_pull_client destructor attempt to requeue_pull which can cause a deadlock if this is the last reference
+	// Dispatch request in an external thread in case it needs to be destroyed
+	node->background ([client, pull_a] ()
+	{
+		client->request (pull_a);
+	});
+}
+
+bool rai::bootstrap_attempt::steal_pull ()
+{
+	assert (!mutex.try_lock ());
+	auto result (false);
+	if (!idle.empty ())
+	{
+		auto now (std::chrono::steady_clock::now ());
+		auto slowest (running.end ());
+		auto slowest_rate (0.0);
+		for (auto i (running.begin ()), n (running.end ()); i != n; ++i)
 		{
-			client->request (pull);
-		});
+			if (!i->second.duplicated && !*i->second.pull.completed && now - i->second.start > steal_cutoff)
+			{
+				if (auto connection_l = i->second.connection.lock ())
+				{
+					auto rate (connection_l->block_rate ());
+					if (slowest == n || rate < slowest_rate)
+					{
+						slowest = i;
+						slowest_rate = rate;
+					}
+				}
+			}
+		}
+		if (slowest != running.end ())
+		{
+			slowest->second.duplicated = true;
+			auto pull (slowest->second.pull);
+			auto connection_l (idle.back ());
+			idle.pop_back ();
+			if (node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (node->log) << boost::str (boost::format ("Also pulling account %1% from %2%") % pull.account.to_account () % connection_l->endpoint);
+			}
+			dispatch_pull (connection_l, pull, true);
+			result = true;
+		}
 	}
+	return result;
 }
 
 bool rai::bootstrap_attempt::request_push (std::unique_lock <std::mutex> & lock_a)
@@ -888,14 +1117,18 @@ void rai::bootstrap_attempt::run ()
 			{
 				request_pull (lock);
 			}
-			else
+			else if (!steal_pull ())
 			{
-				condition.wait (lock);
+				// Wake up periodically so stragglers can be handed to idle connections
+				condition.wait_for (lock, std::chrono::seconds (1));
 			}
 		}
 		// Flushing may resolve forks which can add more pulls
 		BOOST_LOG (node->log) << "Flushing unchecked blocks";
+		// Fork callbacks requeue pulls from the block processor thread and need the attempt lock
+		lock.unlock ();
 		node->block_processor.flush ();
+		lock.lock ();
 		BOOST_LOG (node->log) << "Finished flushing unchecked blocks";
 	}
 	if (!stopped)
@@ -941,9 +1174,48 @@ bool rai::bootstrap_attempt::consume_future (std::future <bool> & future_a)
     return result;
 }
 
+void rai::bootstrap_attempt::drop_slow_clients ()
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	for (auto i (clients.begin ()), n (clients.end ()); i != n;)
+	{
+		if (auto client = i->lock ())
+		{
+			// The pull is requeued for another connection once this one closes
+			if (client->pulling () && client->pull_seconds () > minimum_rate_time.count () && client->block_rate () < minimum_blocks_per_second)
+			{
+				BOOST_LOG (node->log) << boost::str (boost::format ("Dropping slow bootstrap connection %1% at %2% blocks per second") % client->endpoint % client->block_rate ());
+				client->socket.close ();
+			}
+			++i;
+		}
+		else
+		{
+			i = clients.erase (i);
+		}
+	}
+}
+
+std::vector <std::shared_ptr <rai::bootstrap_client>> rai::bootstrap_attempt::active_clients ()
+{
+	std::vector <std::shared_ptr <rai::bootstrap_client>> result;
+	std::lock_guard <std::mutex> lock (mutex);
+	for (auto & i : clients)
+	{
+		if (auto client = i.lock ())
+		{
+			result.push_back (client);
+		}
+	}
+	return result;
+}
+
 void rai::bootstrap_attempt::populate_connections ()
 {
-	if (connections < node->config.bootstrap_connections)
+	drop_slow_clients ();
+	// Open enough connections at once for the frontier ranges, after that grow by one per call
+	unsigned target (connections < node->config.bootstrap_frontier_ranges ? node->config.bootstrap_frontier_ranges - connections : 1);
+	for (unsigned i (0); i < target && !stopped && connections < node->config.bootstrap_connections; ++i)
 	{
 		auto peer (node->peers.bootstrap_peer ());
 		if (peer != rai::endpoint (boost::asio::ip::address_v6::any (), 0))
@@ -977,6 +1249,8 @@ void rai::bootstrap_attempt::add_connection (rai::endpoint const & endpoint_a)
 {
 	auto client (std::make_shared <rai::bootstrap_client> (node, shared_from_this (), rai::tcp_endpoint (endpoint_a.address (), endpoint_a.port ())));
 	client->run ();
+	std::lock_guard <std::mutex> lock (mutex);
+	clients.push_back (client);
 }
 
 void rai::bootstrap_attempt::pool_connection (std::shared_ptr <rai::bootstrap_client> client_a)
@@ -998,14 +1272,17 @@ void rai::bootstrap_attempt::stop ()
 			client->socket.close ();
 		}
 	}
-	if (auto i = frontiers.lock ())
+	for (auto & frontier : frontiers)
 	{
-		try
-		{
-			i->promise.set_value (true);
-		}
-		catch (std::future_error &)
+		if (auto i = frontier.lock ())
 		{
+			try
+			{
+				i->promise.set_value (true);
+			}
+			catch (std::future_error &)
+			{
+			}
 		}
 	}
 	if (auto i = push.lock ())
@@ -1023,7 +1300,11 @@ void rai::bootstrap_attempt::stop ()
 void rai::bootstrap_attempt::requeue_pull (rai::pull_info const & pull_a)
 {
 	auto pull (pull_a);
-	if (++pull.attempts < 4)
+	if (*pull.completed)
+	{
+		// Finished by another connection
+	}
+	else if (++pull.attempts < 4)
 	{
 		std::lock_guard <std::mutex> lock (mutex);
 		pulls.push_front (pull);
@@ -1089,6 +1370,12 @@ bool rai::bootstrap_initiator::in_progress ()
 	return attempt != nullptr;
 }
 
+std::shared_ptr <rai::bootstrap_attempt> rai::bootstrap_initiator::current_attempt ()
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	return attempt;
+}
+
 void rai::bootstrap_initiator::stop ()
 {
 	std::unique_lock <std::mutex> lock (mutex);
@@ -1434,37 +1721,52 @@ void rai::bulk_pull_server::set_current_end ()
 
 void rai::bulk_pull_server::send_next ()
 {
-    std::unique_ptr <rai::block> block (get_next ());
-    if (block != nullptr)
-    {
-        {
-            send_buffer.clear ();
-            rai::vectorstream stream (send_buffer);
-            rai::serialize_block (stream, *block);
-        }
-        auto this_l (shared_from_this ());
-        if (connection->node->config.logging.bulk_pull_logging ())
-        {
-            BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending block: %1%") % block->hash ().to_string ());
-        }
-        async_write (*connection->socket, boost::asio::buffer (send_buffer.data (), send_buffer.size ()), [this_l] (boost::system::error_code const & ec, size_t size_a)
-        {
-            this_l->sent_action (ec, size_a);
-        });
-    }
-    else
-    {
-        send_finished ();
-    }
+	send_buffer.clear ();
+	size_t count (0);
+	{
+		// Read up to a batch of blocks under one transaction and send them with a single write
+		rai::vectorstream stream (send_buffer);
+		rai::transaction transaction (connection->node->store.environment, nullptr, false);
+		auto batch_size (connection->node->config.bulk_pull_batch_size);
+		for (auto block (get_next (transaction)); block != nullptr; block = count < batch_size ? get_next (transaction) : nullptr)
+		{
+			if (connection->node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending block: %1%") % block->hash ().to_string ());
+			}
+			rai::serialize_block (stream, *block);
+			++count;
+		}
+		finished = current == request->end;
+		if (finished)
+		{
+			// Terminate the pull in the same write rather than a separate one-byte send
+			rai::write (stream, rai::block_type::not_a_block);
+		}
+	}
+	if (finished && connection->node->config.logging.bulk_pull_logging ())
+	{
+		BOOST_LOG (connection->node->log) << "Bulk sending finished";
+	}
+	auto this_l (shared_from_this ());
+	async_write (*connection->socket, boost::asio::buffer (send_buffer.data (), send_buffer.size ()), [this_l] (boost::system::error_code const & ec, size_t size_a)
+	{
+		this_l->sent_action (ec, size_a);
+	});
 }
 
 std::unique_ptr <rai::block> rai::bulk_pull_server::get_next ()
+{
+	rai::transaction transaction (connection->node->store.environment, nullptr, false);
+	return get_next (transaction);
+}
+
+std::unique_ptr <rai::block> rai::bulk_pull_server::get_next (MDB_txn * transaction_a)
 {
     std::unique_ptr <rai::block> result;
     if (current != request->end)
     {
-		rai::transaction transaction (connection->node->store.environment, nullptr, false);
-        result = connection->node->store.block_get (transaction, current);
+        result = connection->node->store.block_get (transaction_a, current);
         assert (result != nullptr);
         auto previous (result->previous ());
         if (!previous.is_zero ())
@@ -1483,7 +1785,15 @@ void rai::bulk_pull_server::sent_action (boost::system::error_code const & ec, s
 {
     if (!ec)
     {
-        send_next ();
+		assert (size_a == send_buffer.size ());
+		if (finished)
+		{
+			connection->finish_request ();
+		}
+		else
+		{
+			send_next ();
+		}
     }
 	else
 	{
@@ -1491,37 +1801,10 @@ void rai::bulk_pull_server::sent_action (boost::system::error_code const & ec, s
 	}
 }
 
-void rai::bulk_pull_server::send_finished ()
-{
-    send_buffer.clear ();
-    send_buffer.push_back (static_cast <uint8_t> (rai::block_type::not_a_block));
-    auto this_l (shared_from_this ());
-    if (connection->node->config.logging.bulk_pull_logging ())
-    {
-        BOOST_LOG (connection->node->log) << "Bulk sending finished";
-    }
-    async_write (*connection->socket, boost::asio::buffer (send_buffer.data (), 1), [this_l] (boost::system::error_code const & ec, size_t size_a)
-    {
-        this_l->no_block_sent (ec, size_a);
-    });
-}
-
-void rai::bulk_pull_server::no_block_sent (boost::system::error_code const & ec, size_t size_a)
-{
-    if (!ec)
-    {
-        assert (size_a == 1);
-		connection->finish_request ();
-    }
-	else
-	{
-		BOOST_LOG (connection->node->log) << "Unable to send not-a-block";
-	}
-}
-
 rai::bulk_pull_server::bulk_pull_server (std::shared_ptr <rai::bootstrap_server> const & connection_a, std::unique_ptr <rai::bulk_pull> request_a) :
 connection (connection_a),
-request (std::move (request_a))
+request (std::move (request_a)),
+finished (false)
 {
     set_current_end ();
 }
@@ -1623,7 +1906,8 @@ rai::frontier_req_server::frontier_req_server (std::shared_ptr <rai::bootstrap_s
 connection (connection_a),
 current (request_a->start.number () - 1),
 info (0, 0, 0, 0, 0, 0),
-request (std::move (request_a))
+request (std::move (request_a)),
+finished (false)
 {
 	next ();
     skip_old ();
@@ -1643,71 +1927,67 @@ void rai::frontier_req_server::skip_old ()
 
 void rai::frontier_req_server::send_next ()
 {
-    if (!current.is_zero ())
-    {
-        {
-            send_buffer.clear ();
-            rai::vectorstream stream (send_buffer);
-            write (stream, current.bytes);
-            write (stream, info.head.bytes);
-        }
-        auto this_l (shared_from_this ());
-        if (connection->node->config.logging.bulk_pull_logging ())
-        {
-            BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending frontier for %1% %2%") % current.to_account () % info.head.to_string ());
-        }
-		next ();
-        async_write (*connection->socket, boost::asio::buffer (send_buffer.data (), send_buffer.size ()), [this_l] (boost::system::error_code const & ec, size_t size_a)
-        {
-            this_l->sent_action (ec, size_a);
-        });
-    }
-    else
-    {
-        send_finished ();
-    }
-}
-
-void rai::frontier_req_server::send_finished ()
-{
-    {
-        send_buffer.clear ();
-        rai::vectorstream stream (send_buffer);
-        rai::uint256_union zero (0);
-        write (stream, zero.bytes);
-        write (stream, zero.bytes);
-    }
-    auto this_l (shared_from_this ());
-    if (connection->node->config.logging.network_logging ())
-    {
-        BOOST_LOG (connection->node->log) << "Frontier sending finished";
-    }
-    async_write (*connection->socket, boost::asio::buffer (send_buffer.data (), send_buffer.size ()), [this_l] (boost::system::error_code const & ec, size_t size_a)
-    {
-        this_l->no_block_sent (ec, size_a);
-    });
-}
-
-void rai::frontier_req_server::no_block_sent (boost::system::error_code const & ec, size_t size_a)
-{
-    if (!ec)
-    {
-		connection->finish_request ();
-    }
-    else
-    {
-        if (connection->node->config.logging.network_logging ())
-        {
-            BOOST_LOG (connection->node->log) << boost::str (boost::format ("Error sending frontier finish %1%") % ec.message ());
-        }
-    }
+	send_buffer.clear ();
+	{
+		// Walk the accounts table with one cursor and send up to a batch of frontiers per write
+		rai::vectorstream stream (send_buffer);
+		rai::transaction transaction (connection->node->store.environment, nullptr, false);
+		auto age_limited (request->age != std::numeric_limits<decltype (request->age)>::max ());
+		auto now (connection->node->store.now ());
+		size_t sent (0);
+		auto i (current.is_zero () ? connection->node->store.latest_end () : connection->node->store.latest_begin (transaction, current));
+		for (auto n (connection->node->store.latest_end ()); i != n && sent < frontiers_per_write; ++i)
+		{
+			rai::account account (i->first.uint256 ());
+			rai::account_info info_l (i->second);
+			if (!age_limited || (now - info_l.modified) < request->age)
+			{
+				if (connection->node->config.logging.bulk_pull_logging ())
+				{
+					BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending frontier for %1% %2%") % account.to_account () % info_l.head.to_string ());
+				}
+				write (stream, account.bytes);
+				write (stream, info_l.head.bytes);
+				++sent;
+			}
+		}
+		if (i != connection->node->store.latest_end ())
+		{
+			current = rai::account (i->first.uint256 ());
+			info = rai::account_info (i->second);
+		}
+		else
+		{
+			current.clear ();
+			finished = true;
+			rai::uint256_union zero (0);
+			write (stream, zero.bytes);
+			write (stream, zero.bytes);
+		}
+	}
+	if (finished && connection->node->config.logging.network_logging ())
+	{
+		BOOST_LOG (connection->node->log) << "Frontier sending finished";
+	}
+	auto this_l (shared_from_this ());
+	async_write (*connection->socket, boost::asio::buffer (send_buffer.data (), send_buffer.size ()), [this_l] (boost::system::error_code const & ec, size_t size_a)
+	{
+		this_l->sent_action (ec, size_a);
+	});
 }
 
 void rai::frontier_req_server::sent_action (boost::system::error_code const & ec, size_t size_a)
 {
     if (!ec)
     {
-        send_next ();
+		if (finished)
+		{
+			connection->finish_request ();
+		}
+		else
+		{
+			send_next ();
+		}
     }
     else
     {
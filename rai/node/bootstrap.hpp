@@ -6,6 +6,7 @@
 #include <atomic>
 #include <future>
 #include <queue>
+#include <unordered_map>
 #include <unordered_set>
 #include <stack>
 
@@ -58,6 +59,19 @@ public:
 	rai::block_hash head;
 	rai::block_hash end;
 	unsigned attempts;
+	// Shared by every copy of the pull, set by the first connection to finish it
+	std::shared_ptr <std::atomic <bool>> completed;
+};
+class bulk_pull_client;
+// A pull being received by a connection
+class running_pull
+{
+public:
+	std::weak_ptr <rai::bootstrap_client> connection;
+	rai::pull_info pull;
+	std::chrono::steady_clock::time_point start;
+	// Already given to a second connection
+	bool duplicated;
 };
 class frontier_req_client;
 class bulk_push_client;
@@ -72,16 +86,23 @@ public:
 	void populate_connections ();
     bool request_frontier (std::unique_lock <std::mutex> &);
     void request_pull (std::unique_lock <std::mutex> &);
+	// Give the slowest long running pull to an idle connection as well, returns true if there was one
+	bool steal_pull ();
+	void dispatch_pull (std::shared_ptr <rai::bootstrap_client>, rai::pull_info const &, bool);
     bool request_push (std::unique_lock <std::mutex> &);
 	void add_connection (rai::endpoint const &);
 	void pool_connection (std::shared_ptr <rai::bootstrap_client>);
 	void stop ();
 	void requeue_pull (rai::pull_info const &);
 	bool still_pulling ();
+	// Close connections that keep a pull busy while streaming fewer than minimum_blocks_per_second
+	void drop_slow_clients ();
+	std::vector <std::shared_ptr <rai::bootstrap_client>> active_clients ();
 	std::deque <std::weak_ptr <rai::bootstrap_client>> clients;
-	std::weak_ptr <rai::frontier_req_client> frontiers;
+	std::vector <std::weak_ptr <rai::frontier_req_client>> frontiers;
 	std::weak_ptr <rai::bulk_push_client> push;
     std::deque <rai::pull_info> pulls;
+	std::unordered_map <rai::bulk_pull_client *, rai::running_pull> running;
 	std::vector <std::shared_ptr <rai::bootstrap_client>> idle;
 	std::atomic <unsigned> connections;
     std::atomic <unsigned> pulling;
@@ -90,19 +111,31 @@ public:
 	bool stopped;
 	std::mutex mutex;
 	std::condition_variable condition;
+	// Pulls running this long are duplicated onto idle connections once nothing else is queued
+	static std::chrono::seconds constexpr steal_cutoff = std::chrono::seconds (5);
+	static double constexpr minimum_blocks_per_second = 10.0;
+	// Pulling time before a connection's rate is trusted
+	static std::chrono::seconds constexpr minimum_rate_time = std::chrono::seconds (30);
+	// How long the frontier request waits for enough connections to split the account space between them
+	static std::chrono::seconds constexpr frontier_connection_wait = std::chrono::seconds (1);
 };
 class frontier_req_client : public std::enable_shared_from_this <rai::frontier_req_client>
 {
 public:
-    frontier_req_client (std::shared_ptr <rai::bootstrap_client>);
+	// Compare frontiers for accounts from start up to but excluding end, a zero end runs to the end of the account space
+    frontier_req_client (std::shared_ptr <rai::bootstrap_client>, rai::account const &, rai::account const &);
     ~frontier_req_client ();
 	void run ();
     void receive_frontier ();
     void received_frontier (boost::system::error_code const &, size_t);
+	void process_frontier (MDB_txn *, rai::store_iterator &, rai::account const &, rai::block_hash const &);
     void request_account (rai::account const &, rai::block_hash const &);
 	void unsynced (MDB_txn *, rai::account const &, rai::block_hash const &);
 	void next (MDB_txn *);
+	void next (rai::store_iterator &);
     std::shared_ptr <rai::bootstrap_client> connection;
+	rai::account start;
+	rai::account end;
 	rai::account current;
 	rai::account_info info;
 	unsigned count;
@@ -110,6 +143,16 @@ public:
 	rai::account faucet;
 	std::chrono::system_clock::time_point next_report;
 	std::promise <bool> promise;
+	// Frontiers are read in chunks, a partial frontier at the end of a chunk stays at the front of the buffer
+	std::vector <uint8_t> receive_buffer;
+	size_t received;
+	// Our chains to mark unsynced, written in one transaction once a chunk has been compared
+	std::vector <std::pair <rai::block_hash, rai::block_hash>> unsynced_pending;
+	// Pulls found in the current chunk, the first priority_pulls of them go to the front of the attempt's queue
+	std::deque <rai::pull_info> pulls;
+	size_t priority_pulls;
+	static size_t constexpr frontier_size = sizeof (rai::account) + sizeof (rai::block_hash);
+	static size_t constexpr frontiers_per_read = 1024;
 };
 class bulk_pull_client : public std::enable_shared_from_this <rai::bulk_pull_client>
 {
@@ -134,12 +177,27 @@ public:
 	std::shared_ptr <rai::bootstrap_client> shared ();
 	void start_timeout ();
 	void stop_timeout ();
+	void start_pull ();
+	void end_pull ();
+	// Count a block received by the current pull
+	void pulled_block ();
+	// Seconds spent streaming blocks, from the first block of each pull to its end, so request round trips and time in the idle pool don't count
+	double pull_seconds ();
+	double block_rate ();
+	bool pulling ();
     std::shared_ptr <rai::node> node;
 	std::shared_ptr <rai::bootstrap_attempt> attempt;
     boost::asio::ip::tcp::socket socket;
     std::array <uint8_t, 200> receive_buffer;
 	rai::tcp_endpoint endpoint;
 	boost::asio::deadline_timer timeout;
+	std::atomic <uint64_t> block_count;
+	// Blocks received after the first of each pull, the ones the streaming time covers
+	std::atomic <uint64_t> streamed_count;
+	// Microseconds spent streaming finished pulls and steady clock time of the current pull's first block, zero until it arrives
+	std::atomic <int64_t> pull_time;
+	std::atomic <int64_t> pull_start;
+	std::atomic <bool> pull_active;
 };
 class bulk_push_client : public std::enable_shared_from_this <rai::bulk_push_client>
 {
@@ -164,6 +222,7 @@ public:
 	void notify_listeners (bool);
 	void add_observer (std::function <void (bool)> const &);
 	bool in_progress ();
+	std::shared_ptr <rai::bootstrap_attempt> current_attempt ();
 	void stop ();
 	rai::node & node;
 	std::shared_ptr <rai::bootstrap_attempt> attempt;
@@ -220,14 +279,16 @@ public:
     bulk_pull_server (std::shared_ptr <rai::bootstrap_server> const &, std::unique_ptr <rai::bulk_pull>);
     void set_current_end ();
     std::unique_ptr <rai::block> get_next ();
+    std::unique_ptr <rai::block> get_next (MDB_txn *);
     void send_next ();
     void sent_action (boost::system::error_code const &, size_t);
-    void send_finished ();
-    void no_block_sent (boost::system::error_code const &, size_t);
     std::shared_ptr <rai::bootstrap_server> connection;
     std::unique_ptr <rai::bulk_pull> request;
+    // Serialized blocks for the write in flight, reused between batches
     std::vector <uint8_t> send_buffer;
     rai::block_hash current;
+    // Whether send_buffer ends with the not_a_block terminator
+    bool finished;
 };
 class bulk_push_server : public std::enable_shared_from_this <rai::bulk_push_server>
 {
@@ -248,8 +309,6 @@ public:
     void skip_old ();
     void send_next ();
     void sent_action (boost::system::error_code const &, size_t);
-    void send_finished ();
-    void no_block_sent (boost::system::error_code const &, size_t);
 	void next ();
     std::shared_ptr <rai::bootstrap_server> connection;
 	rai::account current;
@@ -257,5 +316,8 @@ public:
     std::unique_ptr <rai::frontier_req> request;
     std::vector <uint8_t> send_buffer;
     size_t count;
+	// Whether send_buffer ends with the zero frontier terminator
+	bool finished;
+	static size_t constexpr frontiers_per_write = 1024;
 };
 }
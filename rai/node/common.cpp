@@ -7,6 +7,15 @@ std::array <uint8_t, 2> constexpr rai::message::magic_number;
 size_t constexpr rai::message::ipv4_only_position;
 size_t constexpr rai::message::bootstrap_server_position;
 std::bitset <16> constexpr rai::message::block_type_mask;
+size_t constexpr rai::message::header_size;
+
+namespace
+{
+size_t constexpr header_type_offset = sizeof (rai::message::magic_number) + 3 * sizeof (uint8_t);
+size_t constexpr header_extensions_offset = header_type_offset + sizeof (rai::message_type);
+// Votes carry the account, signature and sequence ahead of their block
+size_t constexpr confirm_ack_block_offset = rai::message::header_size + sizeof (rai::account) + sizeof (rai::signature) + sizeof (uint64_t);
+}
 
 rai::message::message (rai::message_type type_a) :
 version_max (0x05),
@@ -88,26 +97,75 @@ bool rai::message::read_header (rai::stream & stream_a, uint8_t & version_max_a,
 	return result;
 }
 
-rai::message_parser::message_parser (rai::message_visitor & visitor_a, rai::work_pool & pool_a) :
+rai::digest_filter::digest_filter (size_t size_a) :
+checked (0),
+hits (0),
+seed (rai::random_pool.GenerateWord32 ()),
+items (size_a)
+{
+	assert (size_a > 0);
+	for (auto & i : items)
+	{
+		i = 0;
+	}
+}
+
+uint64_t rai::digest_filter::digest (uint8_t const * data_a, size_t size_a) const
+{
+	assert (size_a > header_type_offset);
+	// Peers running different versions send the same block, so the version bytes are left out of the digest
+	auto result (XXH64 (data_a + header_type_offset, size_a - header_type_offset, seed));
+	// Zero marks an empty slot
+	result += result == 0;
+	return result;
+}
+
+bool rai::digest_filter::check (uint64_t digest_a)
+{
+	auto result (items [digest_a % items.size ()] == digest_a);
+	++checked;
+	if (result)
+	{
+		++hits;
+	}
+	return result;
+}
+
+void rai::digest_filter::insert (uint64_t digest_a)
+{
+	items [digest_a % items.size ()] = digest_a;
+}
+
+void rai::digest_filter::erase (rai::message & message_a)
+{
+	std::vector <uint8_t> bytes;
+	{
+		rai::vectorstream stream (bytes);
+		message_a.serialize (stream);
+	}
+	auto digest_l (digest (bytes.data (), bytes.size ()));
+	// Only clear the slot if a later packet hasn't taken it over
+	items [digest_l % items.size ()].compare_exchange_strong (digest_l, 0);
+}
+
+rai::message_parser::message_parser (rai::message_visitor & visitor_a, rai::work_pool & pool_a, rai::digest_filter * filter_a) :
 visitor (visitor_a),
 pool (pool_a),
+filter (filter_a),
+digest (0),
 error (false),
-insufficient_work (false)
+insufficient_work (false),
+duplicate (false)
 {
 }
 
 void rai::message_parser::deserialize_buffer (uint8_t const * buffer_a, size_t size_a)
 {
 	error = false;
-	rai::bufferstream header_stream (buffer_a, size_a);
-	uint8_t version_max;
-	uint8_t version_using;
-	uint8_t version_min;
-	rai::message_type type;
-	std::bitset <16> extensions;
-	if (!rai::message::read_header (header_stream, version_max, version_using, version_min, type, extensions))
+	duplicate = false;
+	if (size_a >= rai::message::header_size && std::equal (rai::message::magic_number.begin (), rai::message::magic_number.end (), buffer_a))
 	{
-		switch (type)
+		switch (static_cast <rai::message_type> (buffer_a [header_type_offset]))
 		{
 			case rai::message_type::keepalive:
 			{
@@ -159,68 +217,114 @@ void rai::message_parser::deserialize_keepalive (uint8_t const * buffer_a, size_
 
 void rai::message_parser::deserialize_publish (uint8_t const * buffer_a, size_t size_a)
 {
-	rai::publish incoming;
-	rai::bufferstream stream (buffer_a, size_a);
-	auto error_l (incoming.deserialize (stream));
-	if (!error_l && at_end (stream))
+	if (!reject_duplicate (buffer_a, size_a) && !reject_block (buffer_a, size_a, rai::message::header_size))
 	{
-		if (!rai::work_validate (*incoming.block))
+		rai::publish incoming;
+		rai::bufferstream stream (buffer_a, size_a);
+		auto error_l (incoming.deserialize (stream));
+		if (!error_l)
 		{
 			visitor.publish (incoming);
+			remember ();
 		}
 		else
 		{
-			insufficient_work = true;
+			error = true;
 		}
 	}
-	else
-	{
-		error = true;
-	}
 }
 
 void rai::message_parser::deserialize_confirm_req (uint8_t const * buffer_a, size_t size_a)
 {
-	rai::confirm_req incoming;
-	rai::bufferstream stream (buffer_a, size_a);
-	auto error_l (incoming.deserialize (stream));
-	if (!error_l && at_end (stream))
+	if (!reject_block (buffer_a, size_a, rai::message::header_size))
 	{
-		if (!rai::work_validate (*incoming.block))
+		rai::confirm_req incoming;
+		rai::bufferstream stream (buffer_a, size_a);
+		auto error_l (incoming.deserialize (stream));
+		if (!error_l)
 		{
 			visitor.confirm_req (incoming);
 		}
 		else
 		{
-			insufficient_work = true;
+			error = true;
 		}
 	}
-	else
-	{
-		error = true;
-	}
 }
 
 void rai::message_parser::deserialize_confirm_ack (uint8_t const * buffer_a, size_t size_a)
 {
-	bool error_l;
-	rai::bufferstream stream (buffer_a, size_a);
-	rai::confirm_ack incoming (error_l, stream);
-	if (!error_l && at_end (stream))
+	if (!reject_duplicate (buffer_a, size_a) && !reject_block (buffer_a, size_a, confirm_ack_block_offset))
 	{
-		if (!rai::work_validate (*incoming.vote->block))
+		bool error_l;
+		rai::bufferstream stream (buffer_a, size_a);
+		rai::confirm_ack incoming (error_l, stream);
+		if (!error_l)
 		{
 			visitor.confirm_ack (incoming);
+			remember ();
 		}
 		else
 		{
-			insufficient_work = true;
+			error = true;
+		}
+	}
+}
+
+bool rai::message_parser::reject_duplicate (uint8_t const * buffer_a, size_t size_a)
+{
+	auto result (false);
+	digest = 0;
+	if (filter != nullptr && size_a > header_type_offset)
+	{
+		digest = filter->digest (buffer_a, size_a);
+		result = filter->check (digest);
+		duplicate = result;
+	}
+	return result;
+}
+
+void rai::message_parser::remember ()
+{
+	if (digest != 0)
+	{
+		filter->insert (digest);
+	}
+}
+
+bool rai::message_parser::reject_block (uint8_t const * buffer_a, size_t size_a, size_t offset_a)
+{
+	auto result (true);
+	if (size_a >= rai::message::header_size)
+	{
+		uint16_t extensions_l;
+		std::copy (buffer_a + header_extensions_offset, buffer_a + header_extensions_offset + sizeof (extensions_l), reinterpret_cast <uint8_t *> (&extensions_l));
+		auto type (static_cast <rai::block_type> (((std::bitset <16> (extensions_l) & rai::message::block_type_mask) >> 8).to_ullong ()));
+		auto size (rai::block_size (type));
+		if (size != 0 && size_a == offset_a + size)
+		{
+			// Open blocks are rooted on their account, every other block on the previous hash it starts with, and all of them end with the work
+			auto root_offset (offset_a + (type == rai::block_type::open ? sizeof (rai::block_hash) + sizeof (rai::account) : 0));
+			rai::block_hash root;
+			std::copy (buffer_a + root_offset, buffer_a + root_offset + sizeof (root), root.bytes.begin ());
+			uint64_t work;
+			std::copy (buffer_a + size_a - sizeof (work), buffer_a + size_a, reinterpret_cast <uint8_t *> (&work));
+			result = rai::work_validate (root, work);
+			if (result)
+			{
+				insufficient_work = true;
+			}
+		}
+		else
+		{
+			error = true;
 		}
 	}
 	else
 	{
 		error = true;
 	}
+	return result;
 }
 
 bool rai::message_parser::at_end (rai::bufferstream & stream_a)
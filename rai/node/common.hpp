@@ -119,22 +119,55 @@ public:
     static size_t constexpr ipv4_only_position = 1;
     static size_t constexpr bootstrap_server_position = 2;
     static std::bitset <16> constexpr block_type_mask = std::bitset <16> (0x0f00);
+	// Magic number, three version bytes, message type and extensions
+	static size_t constexpr header_size = sizeof (magic_number) + 3 * sizeof (uint8_t) + sizeof (rai::message_type) + sizeof (uint16_t);
 };
 class work_pool;
+// Fixed size table of recently seen payload digests, shared by the receive threads without locking.
+// A digest is remembered until another one lands in its slot so old entries age out on their own.
+class digest_filter
+{
+public:
+	digest_filter (size_t);
+	// Digest of a whole packet leaving out the version bytes
+	uint64_t digest (uint8_t const *, size_t) const;
+	// Returns true if the digest was seen recently
+	bool check (uint64_t);
+	// Remembers a digest once its message has been accepted
+	void insert (uint64_t);
+	// Forgets a message that was dropped before being handled so a resend isn't refused
+	void erase (rai::message &);
+	std::atomic <uint64_t> checked;
+	std::atomic <uint64_t> hits;
+private:
+	// Random per filter so peers can't line up collisions to get other packets dropped
+	uint64_t seed;
+	std::vector <std::atomic <uint64_t>> items;
+};
 class message_parser
 {
 public:
-    message_parser (rai::message_visitor &, rai::work_pool &);
+    message_parser (rai::message_visitor &, rai::work_pool &, rai::digest_filter * = nullptr);
     void deserialize_buffer (uint8_t const *, size_t);
     void deserialize_keepalive (uint8_t const *, size_t);
     void deserialize_publish (uint8_t const *, size_t);
     void deserialize_confirm_req (uint8_t const *, size_t);
     void deserialize_confirm_ack (uint8_t const *, size_t);
     bool at_end (rai::bufferstream &);
+	// Checks the size and work of the block ending a packet directly in the receive buffer so bad packets never get allocated, returns true if the packet was rejected
+	bool reject_block (uint8_t const *, size_t, size_t);
+	// Looks the payload up in the duplicate filter before any validation is done, returns true if it's a repeat
+	bool reject_duplicate (uint8_t const *, size_t);
+	// Adds the checked digest to the filter after the message has been handed to the visitor
+	void remember ();
     rai::message_visitor & visitor;
 	rai::work_pool & pool;
+	rai::digest_filter * filter;
+	// Digest of the last packet checked against the filter, only inserted once the visitor has taken the message
+	uint64_t digest;
     bool error;
     bool insufficient_work;
+    bool duplicate;
 };
 class keepalive : public message
 {
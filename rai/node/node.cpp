@@ -23,14 +23,34 @@
 
 #include <ed25519-donna/ed25519.h>
 
+#if defined (__linux__)
+#include <sys/socket.h>
+#endif
+
 double constexpr rai::node::price_max;
 double constexpr rai::node::free_cutoff;
 std::chrono::seconds constexpr rai::node::period;
 std::chrono::seconds constexpr rai::node::cutoff;
 std::chrono::minutes constexpr rai::node::backup_interval;
+std::chrono::minutes constexpr rai::node::peer_cache_interval;
+std::chrono::hours constexpr rai::node::peer_cache_cutoff;
 int constexpr rai::port_mapping::mapping_timeout;
 int constexpr rai::port_mapping::check_timeout;
 unsigned constexpr rai::active_transactions::announce_interval_ms;
+size_t constexpr rai::signature_checker::batch_size;
+size_t constexpr rai::vote_processor::max_votes;
+size_t constexpr rai::vote_processor::batch_size;
+size_t constexpr rai::message_processor::max_queue;
+size_t constexpr rai::block_processor::batch_size;
+size_t constexpr rai::block_processor::max_queue;
+size_t constexpr rai::network::batch_size;
+size_t constexpr rai::network::duplicate_filter_size;
+size_t constexpr rai::send_queue::max_queued_bytes;
+size_t constexpr rai::send_queue::max_peer_buckets;
+std::chrono::milliseconds constexpr rai::send_queue::drain_interval;
+size_t constexpr rai::peer_container::peers_per_crawl;
+uint32_t constexpr rai::peer_container::empty_slot;
+size_t constexpr rai::block_processor::max_signers;
 
 rai::message_statistics::message_statistics () :
 keepalive (0),
@@ -40,37 +60,205 @@ confirm_ack (0)
 {
 }
 
+namespace
+{
+#if defined (__linux__) && defined (SO_REUSEPORT)
+using reuse_port = boost::asio::detail::socket_option::boolean <SOL_SOCKET, SO_REUSEPORT>;
+bool const reuse_port_supported (true);
+#else
+bool const reuse_port_supported (false);
+#endif
+#if defined (__linux__)
+bool const batching_supported (true);
+#else
+bool const batching_supported (false);
+#endif
+}
+
 rai::network::network (rai::node & node_a, uint16_t port) :
-socket (node_a.service, rai::endpoint (boost::asio::ip::address_v6::any (), port)),
+socket (node_a.service),
 resolver (node_a.service),
 node (node_a),
 bad_sender_count (0),
 on (true),
 insufficient_work_count (0),
-error_count (0)
-{
+error_count (0),
+batching (node_a.config.network_batching && batching_supported),
+send_batches (0),
+duplicate_filter (duplicate_filter_size),
+send_queue (*this)
+{
+	rai::endpoint local (boost::asio::ip::address_v6::any (), port);
+	auto count (std::max <unsigned> (1, node_a.config.network_receivers));
+	auto reuse (count > 1 && reuse_port_supported);
+	socket.open (local.protocol ());
+#if defined (__linux__) && defined (SO_REUSEPORT)
+	if (reuse)
+	{
+		// Another process that set SO_REUSEPORT could join the group and take a share of our packets, a plain bind fails with address in use if anything holds the port
+		boost::asio::ip::udp::socket probe (node_a.service, local.protocol ());
+		probe.bind (local);
+		local.port (probe.local_endpoint ().port ());
+		probe.close ();
+		socket.set_option (reuse_port (true));
+	}
+#endif
+	socket.bind (local);
+	receivers.push_back (std::unique_ptr <rai::udp_receiver> (new rai::udp_receiver (*this, socket)));
+	for (auto i (1u); i < count; ++i)
+	{
+		if (reuse)
+		{
+			std::unique_ptr <boost::asio::ip::udp::socket> socket_l (new boost::asio::ip::udp::socket (node_a.service, local.protocol ()));
+#if defined (__linux__) && defined (SO_REUSEPORT)
+			socket_l->set_option (reuse_port (true));
+#endif
+			// Bind to the port actually assigned to the first socket in case an ephemeral port was requested
+			socket_l->bind (rai::endpoint (boost::asio::ip::address_v6::any (), socket.local_endpoint ().port ()));
+			receivers.push_back (std::unique_ptr <rai::udp_receiver> (new rai::udp_receiver (*this, *socket_l)));
+			reuse_sockets.push_back (std::move (socket_l));
+		}
+		else
+		{
+			// Receivers share the one socket, each keeps its own receive outstanding
+			receivers.push_back (std::unique_ptr <rai::udp_receiver> (new rai::udp_receiver (*this, socket)));
+		}
+	}
 }
 
 void rai::network::receive ()
 {
-    if (node.config.logging.network_packet_logging ())
-    {
-        BOOST_LOG (node.log) << "Receiving packet";
-    }
-    std::unique_lock <std::mutex> lock (socket_mutex);
-    socket.async_receive_from (boost::asio::buffer (buffer.data (), buffer.size ()), remote, [this] (boost::system::error_code const & error, size_t size_a)
+	for (auto & i : receivers)
 	{
-		receive_action (error, size_a);
-	});
+		i->receive ();
+	}
 }
 
 void rai::network::stop ()
 {
     on = false;
-    socket.close ();
+    {
+        std::lock_guard <std::mutex> lock (socket_mutex);
+        socket.close ();
+        for (auto & i : reuse_sockets)
+        {
+            i->close ();
+        }
+    }
     resolver.cancel ();
 }
 
+rai::udp_receiver::udp_receiver (rai::network & network_a, boost::asio::ip::udp::socket & socket_a) :
+network (network_a),
+socket (socket_a),
+batch_buffers (network_a.batching ? rai::network::batch_size : 0),
+packets (0),
+bytes (0),
+batches (0)
+{
+}
+
+void rai::udp_receiver::receive ()
+{
+    if (network.node.config.logging.network_packet_logging ())
+    {
+        BOOST_LOG (network.node.log) << "Receiving packet";
+    }
+    std::unique_lock <std::mutex> lock (network.socket_mutex);
+    if (network.batching)
+    {
+        // A null buffer receive completes once a datagram is readable without consuming it, recvmmsg then drains the socket
+        socket.async_receive (boost::asio::null_buffers (), [this] (boost::system::error_code const & error, size_t)
+        {
+            receive_batch (error);
+        });
+    }
+    else
+    {
+        socket.async_receive_from (boost::asio::buffer (buffer.data (), buffer.size ()), remote, [this] (boost::system::error_code const & error, size_t size_a)
+        {
+            receive_action (error, size_a);
+        });
+    }
+}
+
+void rai::udp_receiver::receive_batch (boost::system::error_code const & error)
+{
+    auto error_l (error);
+#if defined (__linux__)
+    if (!error && network.on)
+    {
+        std::array <mmsghdr, rai::network::batch_size> messages;
+        std::array <iovec, rai::network::batch_size> vectors;
+        std::array <sockaddr_in6, rai::network::batch_size> addresses;
+        for (size_t i (0); i < messages.size (); ++i)
+        {
+            vectors [i].iov_base = batch_buffers [i].data ();
+            vectors [i].iov_len = batch_buffers [i].size ();
+            messages [i].msg_hdr = msghdr ();
+            messages [i].msg_hdr.msg_name = &addresses [i];
+            messages [i].msg_hdr.msg_namelen = sizeof (addresses [i]);
+            messages [i].msg_hdr.msg_iov = &vectors [i];
+            messages [i].msg_hdr.msg_iovlen = 1;
+        }
+        auto count (recvmmsg (socket.native_handle (), messages.data (), messages.size (), MSG_DONTWAIT, nullptr));
+        if (count > 0)
+        {
+            ++batches;
+            for (auto i (0); i < count; ++i)
+            {
+                auto & header (messages [i].msg_hdr);
+                rai::endpoint remote_l;
+                assert (header.msg_namelen <= remote_l.capacity ());
+                std::memcpy (remote_l.data (), header.msg_name, header.msg_namelen);
+                remote_l.resize (header.msg_namelen);
+                ++packets;
+                bytes += messages [i].msg_len;
+                network.process_packet (remote_l, batch_buffers [i].data (), messages [i].msg_len);
+            }
+        }
+        else if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            error_l = boost::system::error_code (errno, boost::system::system_category ());
+        }
+    }
+#endif
+    if (!error_l && network.on)
+    {
+        // Nothing read means another receiver sharing the socket drained it first
+        receive ();
+    }
+    else
+    {
+        receive_action (error_l, 0);
+    }
+}
+
+void rai::udp_receiver::receive_action (boost::system::error_code const & error, size_t size_a)
+{
+    if (!error && network.on)
+    {
+        ++packets;
+        bytes += size_a;
+        network.process_packet (remote, buffer.data (), size_a);
+        receive ();
+    }
+	else
+	{
+		if (error)
+		{
+			if (network.node.config.logging.network_logging ())
+			{
+				BOOST_LOG (network.node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
+			}
+		}
+		if (network.on)
+		{
+			network.node.alarm.add (std::chrono::system_clock::now () + std::chrono::seconds (5), [this] () { receive (); });
+		}
+	}
+}
+
 void rai::network::send_keepalive (rai::endpoint const & endpoint_a)
 {
     assert (endpoint_a.address ().is_v6 ());
@@ -87,16 +275,13 @@ void rai::network::send_keepalive (rai::endpoint const & endpoint_a)
     }
     ++outgoing.keepalive;
 	std::weak_ptr <rai::node> node_w (node.shared ());
-    send_buffer (bytes->data (), bytes->size (), endpoint_a, [bytes, node_w, endpoint_a] (boost::system::error_code const & ec, size_t)
+    send (bytes, std::vector <rai::endpoint> (1, endpoint_a), rai::send_priority::keepalive, [node_w] (boost::system::error_code const & ec, rai::endpoint const & endpoint_a)
 	{
 		if (auto node_l = node_w.lock ())
 		{
 			if (node_l->config.logging.network_keepalive_logging ())
 			{
-				if (ec)
-				{
-					BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending keepalive to %1% %2%") % endpoint_a % ec.message ());
-				}
+				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending keepalive to %1% %2%") % endpoint_a % ec.message ());
 			}
 		}
 	});
@@ -134,16 +319,36 @@ void rai::network::republish (rai::block_hash const & hash_a, std::shared_ptr <s
 		BOOST_LOG (node.log) << boost::str (boost::format ("Publishing %1% to %2%") % hash_a.to_string () % endpoint_a);
 	}
     std::weak_ptr <rai::node> node_w (node.shared ());
-	send_buffer (buffer_a->data (), buffer_a->size (), endpoint_a, [buffer_a, node_w, endpoint_a] (boost::system::error_code const & ec, size_t size)
+	send (buffer_a, std::vector <rai::endpoint> (1, endpoint_a), rai::send_priority::publish, [node_w] (boost::system::error_code const & ec, rai::endpoint const & endpoint_a)
 	{
 		if (auto node_l = node_w.lock ())
 		{
 			if (node_l->config.logging.network_logging ())
 			{
-				if (ec)
-				{
-					BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending publish: %1% to %2%") % ec.message () % endpoint_a);
-				}
+				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending publish: %1% to %2%") % ec.message () % endpoint_a);
+			}
+		}
+	});
+}
+
+void rai::network::republish (rai::block_hash const & hash_a, std::shared_ptr <std::vector <uint8_t>> buffer_a, std::vector <rai::endpoint> const & endpoints_a)
+{
+	outgoing.publish += endpoints_a.size ();
+	if (node.config.logging.network_publish_logging ())
+	{
+		for (auto & i : endpoints_a)
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Publishing %1% to %2%") % hash_a.to_string () % i);
+		}
+	}
+    std::weak_ptr <rai::node> node_w (node.shared ());
+	send (buffer_a, endpoints_a, rai::send_priority::publish, [node_w] (boost::system::error_code const & ec, rai::endpoint const & endpoint_a)
+	{
+		if (auto node_l = node_w.lock ())
+		{
+			if (node_l->config.logging.network_logging ())
+			{
+				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending publish: %1% to %2%") % ec.message () % endpoint_a);
 			}
 		}
 	});
@@ -159,10 +364,13 @@ void rai::network::rebroadcast_reps (std::shared_ptr <rai::block> block_a)
 		message.serialize (stream);
 	}
 	auto representatives (node.peers.representatives (2 * node.peers.size_sqrt ()));
-	for (auto i : representatives)
+	std::vector <rai::endpoint> endpoints;
+	endpoints.reserve (representatives.size ());
+	for (auto & i : representatives)
 	{
-		republish (hash, bytes, i.endpoint);
+		endpoints.push_back (i.endpoint);
 	}
+	republish (hash, bytes, endpoints);
 }
 
 template <typename T>
@@ -181,10 +389,7 @@ bool confirm_block (MDB_txn * transaction_a, rai::node & node_a, T & list_a, std
 				rai::vectorstream stream (*bytes);
 				confirm.serialize (stream);
 			}
-			for (auto j (list_a.begin ()), m (list_a.end ()); j != m; ++j)
-			{
-				node_a.network.confirm_send (confirm, bytes, *j);
-			}
+			node_a.network.confirm_send (confirm, bytes, std::vector <rai::endpoint> (list_a.begin (), list_a.end ()));
 		});
 	}
     return result;
@@ -214,10 +419,7 @@ void rai::network::republish_block (MDB_txn * transaction, std::shared_ptr <rai:
             message.serialize (stream);
         }
 		auto hash (block->hash ());
-        for (auto i (list.begin ()), n (list.end ()); i != n; ++i)
-        {
-			republish (hash, bytes, *i);
-        }
+		republish (hash, bytes, list);
 		if (node.config.logging.network_logging ())
 		{
 			BOOST_LOG (node.log) << boost::str (boost::format ("Block %1% was republished to peers") % hash.to_string ());
@@ -248,11 +450,7 @@ void rai::network::republish_vote (std::chrono::system_clock::time_point const &
 				rai::vectorstream stream (*bytes);
 				confirm.serialize (stream);
 			}
-			auto list (node.peers.list_sqrt ());
-			for (auto j (list.begin ()), m (list.end ()); j != m; ++j)
-			{
-				node.network.confirm_send (confirm, bytes, *j);
-			}
+			node.network.confirm_send (confirm, bytes, node.peers.list_sqrt ());
 		}
 	}
 }
@@ -260,10 +458,34 @@ void rai::network::republish_vote (std::chrono::system_clock::time_point const &
 void rai::network::broadcast_confirm_req (std::shared_ptr <rai::block> block_a)
 {
 	auto list (node.peers.representatives (std::numeric_limits <size_t>::max ()));
-	for (auto i (list.begin ()), j (list.end ()); i != j; ++i)
+	rai::confirm_req message (block_a);
+	std::shared_ptr <std::vector <uint8_t>> bytes (new std::vector <uint8_t>);
+	{
+		rai::vectorstream stream (*bytes);
+		message.serialize (stream);
+	}
+	std::vector <rai::endpoint> endpoints;
+	endpoints.reserve (list.size ());
+	for (auto & i : list)
 	{
-		node.network.send_confirm_req (i->endpoint, block_a);
+		if (node.config.logging.network_message_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm req to %1%") % i.endpoint);
+		}
+		endpoints.push_back (i.endpoint);
 	}
+	outgoing.confirm_req += endpoints.size ();
+	std::weak_ptr <rai::node> node_w (node.shared ());
+	send (bytes, endpoints, rai::send_priority::publish, [node_w] (boost::system::error_code const & ec, rai::endpoint const &)
+	{
+		if (auto node_l = node_w.lock ())
+		{
+			if (node_l->config.logging.network_logging ())
+			{
+				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending confirm request: %1%") % ec.message ());
+			}
+		}
+	});
     if (node.config.logging.network_logging ())
     {
         BOOST_LOG (node.log) << boost::str (boost::format ("Broadcasted confirm req to %1% representatives") % list.size ());
@@ -284,16 +506,13 @@ void rai::network::send_confirm_req (rai::endpoint const & endpoint_a, std::shar
     }
     std::weak_ptr <rai::node> node_w (node.shared ());
 	++outgoing.confirm_req;
-    send_buffer (bytes->data (), bytes->size (), endpoint_a, [bytes, node_w] (boost::system::error_code const & ec, size_t size)
+    send (bytes, std::vector <rai::endpoint> (1, endpoint_a), rai::send_priority::publish, [node_w] (boost::system::error_code const & ec, rai::endpoint const &)
 	{
 		if (auto node_l = node_w.lock ())
 		{
 			if (node_l->config.logging.network_logging ())
 			{
-				if (ec)
-				{
-					BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending confirm request: %1%") % ec.message ());
-				}
+				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error sending confirm request: %1%") % ec.message ());
 			}
 		}
 	});
@@ -386,23 +605,10 @@ public:
         node.peers.contacted (sender, message_a.version_using);
         node.peers.insert (sender, message_a.version_using);
         node.process_active (message_a.vote->block);
-		auto vote (node.vote_processor.vote (message_a.vote, sender));
-		if (vote.code == rai::vote_code::replay)
+		if (node.vote_processor.add (message_a.vote, sender))
 		{
-			assert (vote.vote->sequence > message_a.vote->sequence);
-			// This tries to assist rep nodes that have lost track of their highest sequence number by replaying our highest known vote back to them
-			// Only do this if the sequence number is significantly different to account for network reordering
-			// Amplify attack considerations: We're sending out a confirm_ack in response to a confirm_ack for no net traffic increase
-			if (vote.vote->sequence - message_a.vote->sequence > 10000)
-			{
-				rai::confirm_ack confirm (vote.vote);
-				std::shared_ptr <std::vector <uint8_t>> bytes (new std::vector <uint8_t>);
-				{
-					rai::vectorstream stream (*bytes);
-					confirm.serialize (stream);
-				}
-				node.network.confirm_send (confirm, bytes, sender);
-			}
+			auto message_l (message_a);
+			node.network.duplicate_filter.erase (message_l);
 		}
     }
     void bulk_pull (rai::bulk_pull const &) override
@@ -420,53 +626,76 @@ public:
     rai::node & node;
     rai::endpoint sender;
 };
+
+// Hands parsed messages to the message processor instead of handling them on the receive thread
+class message_queue_visitor : public rai::message_visitor
+{
+public:
+	message_queue_visitor (rai::node & node_a, rai::endpoint const & sender_a) :
+	node (node_a),
+	sender (sender_a)
+	{
+	}
+	void keepalive (rai::keepalive const & message_a) override
+	{
+		node.message_processor.add (message_a, sender);
+	}
+	void publish (rai::publish const & message_a) override
+	{
+		node.message_processor.add (message_a, sender);
+	}
+	void confirm_req (rai::confirm_req const & message_a) override
+	{
+		node.message_processor.add (message_a, sender);
+	}
+	void confirm_ack (rai::confirm_ack const & message_a) override
+	{
+		node.message_processor.add (message_a, sender);
+	}
+	void bulk_pull (rai::bulk_pull const &) override
+	{
+		assert (false);
+	}
+	void bulk_push (rai::bulk_push const &) override
+	{
+		assert (false);
+	}
+	void frontier_req (rai::frontier_req const &) override
+	{
+		assert (false);
+	}
+	rai::node & node;
+	rai::endpoint sender;
+};
 }
 
-void rai::network::receive_action (boost::system::error_code const & error, size_t size_a)
+void rai::network::process_packet (rai::endpoint const & remote_a, uint8_t const * data_a, size_t size_a)
 {
-    if (!error && on)
-    {
-        if (!rai::reserved_address (remote) && remote != endpoint ())
-        {
-            network_message_visitor visitor (node, remote);
-            rai::message_parser parser (visitor, node.work);
-            parser.deserialize_buffer (buffer.data (), size_a);
-            if (parser.error)
-            {
-                ++error_count;
-            }
-            else if (parser.insufficient_work)
-            {
-                if (node.config.logging.insufficient_work_logging ())
-                {
-                    BOOST_LOG (node.log) << "Insufficient work in message";
-                }
-                ++insufficient_work_count;
-            }
-        }
-        else
-        {
-            if (node.config.logging.network_logging ())
-            {
-                BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % remote.address ().to_string ());
-            }
-            ++bad_sender_count;
-        }
-        receive ();
-    }
-	else
+	if (!rai::reserved_address (remote_a) && remote_a != endpoint ())
 	{
-		if (error)
+		message_queue_visitor visitor (node, remote_a);
+		rai::message_parser parser (visitor, node.work, &duplicate_filter);
+		parser.deserialize_buffer (data_a, size_a);
+		if (parser.error)
+		{
+			++error_count;
+		}
+		else if (parser.insufficient_work)
 		{
-			if (node.config.logging.network_logging ())
+			if (node.config.logging.insufficient_work_logging ())
 			{
-				BOOST_LOG (node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
+				BOOST_LOG (node.log) << "Insufficient work in message";
 			}
+			++insufficient_work_count;
 		}
-		if (on)
+	}
+	else
+	{
+		if (node.config.logging.network_logging ())
 		{
-			node.alarm.add (std::chrono::system_clock::now () + std::chrono::seconds (5), [this] () { receive (); });
+			BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % remote_a.address ().to_string ());
 		}
+		++bad_sender_count;
 	}
 }
 
@@ -754,12 +983,27 @@ io_threads (std::max <unsigned> (4, std::thread::hardware_concurrency ())),
 work_threads (std::max <unsigned> (4, std::thread::hardware_concurrency ())),
 enable_voting (true),
 bootstrap_connections (16),
+bootstrap_frontier_ranges (4),
+signature_checker_threads (std::max <unsigned> (1, std::thread::hardware_concurrency ()) - 1),
+vote_processor_threads (std::max <unsigned> (1, std::thread::hardware_concurrency () / 2)),
+message_processor_threads (std::max <unsigned> (1, std::thread::hardware_concurrency () / 2)),
+group_commit_interval (0),
+group_commit_blocks (16384),
+network_receivers (std::max <unsigned> (1, std::thread::hardware_concurrency () / 2)),
+network_batching (true),
+bandwidth_limit (5 * 1024 * 1024),
+peer_bandwidth_limit (0),
+bulk_pull_batch_size (128),
+unchecked_pool_max (65536),
+unchecked_pool_age (60),
 callback_port (0)
 {
 	switch (rai::rai_network)
 	{
 		case rai::rai_networks::rai_test_network:
 			preconfigured_representatives.push_back (rai::genesis_account);
+			// Test ledgers hold a handful of accounts, splitting them only churns connections
+			bootstrap_frontier_ranges = 1;
 			break;
 		case rai::rai_networks::rai_beta_network:
 			preconfigured_peers.push_back ("rai.raiblocks.net");
@@ -787,7 +1031,7 @@ callback_port (0)
 
 void rai::node_config::serialize_json (boost::property_tree::ptree & tree_a) const
 {
-	tree_a.put ("version", "7");
+	tree_a.put ("version", "18");
 	tree_a.put ("peering_port", std::to_string (peering_port));
 	tree_a.put ("bootstrap_fraction_numerator", std::to_string (bootstrap_fraction_numerator));
 	tree_a.put ("receive_minimum", receive_minimum.to_string_dec ());
@@ -824,6 +1068,22 @@ void rai::node_config::serialize_json (boost::property_tree::ptree & tree_a) con
 	tree_a.put ("work_threads", std::to_string (work_threads));
 	tree_a.put ("enable_voting", enable_voting);
 	tree_a.put ("bootstrap_connections", bootstrap_connections);
+	tree_a.put ("bootstrap_frontier_ranges", bootstrap_frontier_ranges);
+	tree_a.put ("signature_checker_threads", signature_checker_threads);
+	tree_a.put ("vote_processor_threads", vote_processor_threads);
+	tree_a.put ("group_commit_interval", group_commit_interval);
+	tree_a.put ("group_commit_blocks", group_commit_blocks);
+	boost::property_tree::ptree lmdb_l;
+	lmdb.serialize_json (lmdb_l);
+	tree_a.add_child ("lmdb", lmdb_l);
+	tree_a.put ("network_receivers", network_receivers);
+	tree_a.put ("network_batching", network_batching);
+	tree_a.put ("message_processor_threads", message_processor_threads);
+	tree_a.put ("bandwidth_limit", bandwidth_limit);
+	tree_a.put ("peer_bandwidth_limit", peer_bandwidth_limit);
+	tree_a.put ("bulk_pull_batch_size", bulk_pull_batch_size);
+	tree_a.put ("unchecked_pool_max", unchecked_pool_max);
+	tree_a.put ("unchecked_pool_age", unchecked_pool_age);
 	tree_a.put ("callback_address", callback_address);
 	tree_a.put ("callback_port", std::to_string (callback_port));
 	tree_a.put ("callback_target", callback_target);
@@ -893,8 +1153,70 @@ bool rai::node_config::upgrade_json (unsigned version, boost::property_tree::ptr
 		tree_a.erase ("version");
 		tree_a.put ("version", "7");
 		result = true;
-		break;
 	case 7:
+		tree_a.put ("signature_checker_threads", signature_checker_threads);
+		tree_a.erase ("version");
+		tree_a.put ("version", "8");
+		result = true;
+	case 8:
+		tree_a.put ("vote_processor_threads", vote_processor_threads);
+		tree_a.erase ("version");
+		tree_a.put ("version", "9");
+		result = true;
+	case 9:
+		tree_a.put ("group_commit_interval", group_commit_interval);
+		tree_a.put ("group_commit_blocks", group_commit_blocks);
+		tree_a.erase ("version");
+		tree_a.put ("version", "10");
+		result = true;
+	case 10:
+	{
+		boost::property_tree::ptree lmdb_l;
+		lmdb.serialize_json (lmdb_l);
+		tree_a.add_child ("lmdb", lmdb_l);
+		tree_a.erase ("version");
+		tree_a.put ("version", "11");
+		result = true;
+	}
+	case 11:
+		tree_a.put ("network_receivers", network_receivers);
+		tree_a.erase ("version");
+		tree_a.put ("version", "12");
+		result = true;
+	case 12:
+		tree_a.put ("network_batching", network_batching);
+		tree_a.erase ("version");
+		tree_a.put ("version", "13");
+		result = true;
+	case 13:
+		tree_a.put ("message_processor_threads", message_processor_threads);
+		tree_a.erase ("version");
+		tree_a.put ("version", "14");
+		result = true;
+	case 14:
+		tree_a.put ("bandwidth_limit", bandwidth_limit);
+		tree_a.put ("peer_bandwidth_limit", peer_bandwidth_limit);
+		tree_a.erase ("version");
+		tree_a.put ("version", "15");
+		result = true;
+	case 15:
+		tree_a.put ("bulk_pull_batch_size", bulk_pull_batch_size);
+		tree_a.erase ("version");
+		tree_a.put ("version", "16");
+		result = true;
+	case 16:
+		tree_a.put ("bootstrap_frontier_ranges", bootstrap_frontier_ranges);
+		tree_a.erase ("version");
+		tree_a.put ("version", "17");
+		result = true;
+	case 17:
+		tree_a.put ("unchecked_pool_max", unchecked_pool_max);
+		tree_a.put ("unchecked_pool_age", unchecked_pool_age);
+		tree_a.erase ("version");
+		tree_a.put ("version", "18");
+		result = true;
+		break;
+	case 18:
 		break;
 	default:
 		throw std::runtime_error ("Unknown node_config version");
@@ -962,6 +1284,20 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 		auto work_threads_l (tree_a.get <std::string> ("work_threads"));
 		enable_voting = tree_a.get <bool> ("enable_voting");
 		auto bootstrap_connections_l (tree_a.get <std::string> ("bootstrap_connections"));
+		auto bootstrap_frontier_ranges_l (tree_a.get <std::string> ("bootstrap_frontier_ranges"));
+		auto signature_checker_threads_l (tree_a.get <std::string> ("signature_checker_threads"));
+		auto vote_processor_threads_l (tree_a.get <std::string> ("vote_processor_threads"));
+		auto group_commit_interval_l (tree_a.get <std::string> ("group_commit_interval"));
+		auto group_commit_blocks_l (tree_a.get <std::string> ("group_commit_blocks"));
+		auto & lmdb_l (tree_a.get_child ("lmdb"));
+		auto network_receivers_l (tree_a.get <std::string> ("network_receivers"));
+		network_batching = tree_a.get <bool> ("network_batching");
+		auto message_processor_threads_l (tree_a.get <std::string> ("message_processor_threads"));
+		auto bandwidth_limit_l (tree_a.get <std::string> ("bandwidth_limit"));
+		auto peer_bandwidth_limit_l (tree_a.get <std::string> ("peer_bandwidth_limit"));
+		auto bulk_pull_batch_size_l (tree_a.get <std::string> ("bulk_pull_batch_size"));
+		auto unchecked_pool_max_l (tree_a.get <std::string> ("unchecked_pool_max"));
+		auto unchecked_pool_age_l (tree_a.get <std::string> ("unchecked_pool_age"));
 		callback_address = tree_a.get <std::string> ("callback_address");
 		auto callback_port_l (tree_a.get <std::string> ("callback_port"));
 		callback_target = tree_a.get <std::string> ("callback_target");
@@ -974,14 +1310,33 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 			io_threads = std::stoul (io_threads_l);
 			work_threads = std::stoul (work_threads_l);
 			bootstrap_connections = std::stoul (bootstrap_connections_l);
+			bootstrap_frontier_ranges = std::stoul (bootstrap_frontier_ranges_l);
+			signature_checker_threads = std::stoul (signature_checker_threads_l);
+			vote_processor_threads = std::stoul (vote_processor_threads_l);
+			group_commit_interval = std::stoul (group_commit_interval_l);
+			group_commit_blocks = std::stoul (group_commit_blocks_l);
+			network_receivers = std::stoul (network_receivers_l);
+			message_processor_threads = std::stoul (message_processor_threads_l);
+			bandwidth_limit = std::stoull (bandwidth_limit_l);
+			peer_bandwidth_limit = std::stoull (peer_bandwidth_limit_l);
+			bulk_pull_batch_size = std::stoul (bulk_pull_batch_size_l);
+			unchecked_pool_max = std::stoul (unchecked_pool_max_l);
+			unchecked_pool_age = std::stoul (unchecked_pool_age_l);
 			result |= peering_port > std::numeric_limits <uint16_t>::max ();
 			result |= logging.deserialize_json (upgraded_a, logging_l);
+			result |= lmdb.deserialize_json (lmdb_l);
 			result |= receive_minimum.decode_dec (receive_minimum_l);
 			result |= inactive_supply.decode_dec (inactive_supply_l);
 			result |= password_fanout < 16;
 			result |= password_fanout > 1024 * 1024;
 			result |= io_threads == 0;
 			result |= work_threads == 0;
+			result |= vote_processor_threads == 0;
+			result |= group_commit_blocks == 0;
+			result |= network_receivers == 0;
+			result |= message_processor_threads == 0;
+			result |= bulk_pull_batch_size == 0;
+			result |= bootstrap_frontier_ranges == 0;
 		}
 		catch (std::logic_error const &)
 		{
@@ -1004,68 +1359,398 @@ rai::account rai::node_config::random_representative ()
 }
 
 rai::vote_processor::vote_processor (rai::node & node_a) :
-node (node_a)
+node (node_a),
+verified (0),
+invalid (0),
+dropped (0),
+stopped (false),
+active (0)
 {
+	for (auto i (0u); i < node_a.config.vote_processor_threads; ++i)
+	{
+		threads.push_back (std::thread ([this] () { process_votes (); }));
+	}
 }
 
-rai::vote_result rai::vote_processor::vote (std::shared_ptr <rai::vote> vote_a, rai::endpoint endpoint_a)
+rai::vote_processor::~vote_processor ()
+{
+	stop ();
+}
+
+void rai::vote_processor::stop ()
 {
-	rai::vote_result result;
 	{
-		rai::transaction transaction (node.store.environment, nullptr, false);
-		result = node.store.vote_validate (transaction, vote_a);
+		std::lock_guard <std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
 	}
-	if (node.config.logging.vote_logging ())
+	for (auto & i : threads)
 	{
-		char const * status;
-		switch (result.code)
+		if (i.joinable ())
 		{
-			case rai::vote_code::invalid:
-				status = "Invalid";
-				break;
-			case rai::vote_code::replay:
-				status = "Replay";
-				break;
-			case rai::vote_code::vote:
-				status = "Vote";
-				break;
+			i.join ();
 		}
-		BOOST_LOG (node.log) << boost::str (boost::format ("Vote from: %1% sequence: %2% block: %3% status: %4%") % vote_a->account.to_account () % std::to_string (vote_a->sequence) % vote_a->block->hash ().to_string () % status);
-	}
-	switch (result.code)
-	{
-		case rai::vote_code::vote:
-			node.observers.vote (vote_a, endpoint_a);
-		case rai::vote_code::replay:
-		case rai::vote_code::invalid:
-			break;
 	}
-	return result;
-}
-
-void rai::rep_crawler::add (rai::block_hash const & hash_a)
-{
-	std::lock_guard <std::mutex> lock (mutex);
-	active.insert (hash_a);
 }
 
-void rai::rep_crawler::remove (rai::block_hash const & hash_a)
+void rai::vote_processor::flush ()
 {
-	std::lock_guard <std::mutex> lock (mutex);
-	active.erase (hash_a);
+	std::unique_lock <std::mutex> lock (mutex);
+	while (!stopped && (!votes.empty () || active > 0))
+	{
+		condition.wait (lock);
+	}
 }
 
-bool rai::rep_crawler::exists (rai::block_hash const & hash_a)
+size_t rai::vote_processor::size ()
 {
 	std::lock_guard <std::mutex> lock (mutex);
-	return active.count (hash_a) != 0;
+	return votes.size ();
 }
 
-rai::block_processor_item::block_processor_item (std::shared_ptr <rai::block> block_a) :
-block_processor_item (block_a, nullptr, false)
+bool rai::vote_processor::add (std::shared_ptr <rai::vote> vote_a, rai::endpoint const & endpoint_a)
 {
-}
-
+	auto result (false);
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		if (!stopped && votes.size () < max_votes)
+		{
+			votes.push_back (std::make_pair (vote_a, endpoint_a));
+			condition.notify_all ();
+		}
+		else
+		{
+			result = true;
+		}
+	}
+	if (result)
+	{
+		++dropped;
+		if (node.config.logging.vote_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Vote processor queue full, dropping vote from: %1%") % vote_a->account.to_account ());
+		}
+	}
+	return result;
+}
+
+void rai::vote_processor::process_votes ()
+{
+	std::unique_lock <std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!votes.empty ())
+		{
+			std::deque <std::pair <std::shared_ptr <rai::vote>, rai::endpoint>> votes_processing;
+			// Split the queue between verifier threads instead of letting one thread take everything
+			auto count (std::min (batch_size, votes.size ()));
+			votes_processing.assign (votes.begin (), votes.begin () + count);
+			votes.erase (votes.begin (), votes.begin () + count);
+			++active;
+			lock.unlock ();
+			verify_votes (votes_processing);
+			lock.lock ();
+			--active;
+			condition.notify_all ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+rai::message_processor::message_processor (rai::node & node_a) :
+node (node_a),
+priority_votes (0),
+stopped (false),
+active (0)
+{
+	for (auto i (0u); i < node_a.config.message_processor_threads; ++i)
+	{
+		threads.push_back (std::thread ([this] () { process_messages (); }));
+	}
+}
+
+rai::message_processor::~message_processor ()
+{
+	stop ();
+}
+
+void rai::message_processor::stop ()
+{
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	for (auto & i : threads)
+	{
+		if (i.joinable ())
+		{
+			i.join ();
+		}
+	}
+}
+
+void rai::message_processor::flush ()
+{
+	std::unique_lock <std::mutex> lock (mutex);
+	while (!stopped && (!priority_acks.empty () || !confirm_acks.empty () || !confirm_reqs.empty () || !keepalives.empty () || !publishes.empty () || active > 0))
+	{
+		condition.wait (lock);
+	}
+}
+
+size_t rai::message_processor::size ()
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	return priority_acks.size () + confirm_acks.size () + confirm_reqs.size () + keepalives.size () + publishes.size ();
+}
+
+template <typename T>
+void rai::message_processor::push (std::deque <std::pair <T, rai::endpoint>> & queue_a, T const & message_a, rai::endpoint const & endpoint_a, std::atomic <uint64_t> & dropped_a)
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	if (!stopped)
+	{
+		if (queue_a.size () >= max_queue)
+		{
+			// The oldest message is the most likely to be stale by the time a worker gets to it
+			node.network.duplicate_filter.erase (queue_a.front ().first);
+			queue_a.pop_front ();
+			++dropped_a;
+		}
+		queue_a.push_back (std::make_pair (message_a, endpoint_a));
+		condition.notify_one ();
+	}
+	else
+	{
+		++dropped_a;
+	}
+}
+
+void rai::message_processor::add (rai::keepalive const & message_a, rai::endpoint const & endpoint_a)
+{
+	push (keepalives, message_a, endpoint_a, dropped.keepalive);
+}
+
+void rai::message_processor::add (rai::publish const & message_a, rai::endpoint const & endpoint_a)
+{
+	push (publishes, message_a, endpoint_a, dropped.publish);
+}
+
+void rai::message_processor::add (rai::confirm_req const & message_a, rai::endpoint const & endpoint_a)
+{
+	push (confirm_reqs, message_a, endpoint_a, dropped.confirm_req);
+}
+
+void rai::message_processor::add (rai::confirm_ack const & message_a, rai::endpoint const & endpoint_a)
+{
+	bool priority;
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		priority = representatives.find (message_a.vote->account) != representatives.end ();
+	}
+	push (priority ? priority_acks : confirm_acks, message_a, endpoint_a, dropped.confirm_ack);
+}
+
+void rai::message_processor::process_messages ()
+{
+	std::unique_lock <std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!priority_acks.empty ())
+		{
+			++priority_votes;
+			process_front (lock, priority_acks);
+		}
+		else if (!confirm_acks.empty ())
+		{
+			process_front (lock, confirm_acks);
+		}
+		else if (!confirm_reqs.empty ())
+		{
+			process_front (lock, confirm_reqs);
+		}
+		else if (!keepalives.empty ())
+		{
+			process_front (lock, keepalives);
+		}
+		else if (!publishes.empty ())
+		{
+			process_front (lock, publishes);
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+template <typename T>
+void rai::message_processor::process_front (std::unique_lock <std::mutex> & lock_a, std::deque <std::pair <T, rai::endpoint>> & queue_a)
+{
+	auto item (std::move (queue_a.front ()));
+	queue_a.pop_front ();
+	++active;
+	lock_a.unlock ();
+	network_message_visitor visitor (node, item.second);
+	item.first.visit (visitor);
+	processed (item.first);
+	lock_a.lock ();
+	--active;
+	condition.notify_all ();
+}
+
+void rai::message_processor::processed (rai::message const &)
+{
+}
+
+void rai::message_processor::processed (rai::confirm_ack const & message_a)
+{
+	// Same weight cutoff republish_vote uses to decide a representative is worth relaying
+	auto high_weight (node.weight (message_a.vote->account) > rai::Mxrb_ratio * 256);
+	std::lock_guard <std::mutex> lock (mutex);
+	if (high_weight)
+	{
+		representatives.insert (message_a.vote->account);
+	}
+	else
+	{
+		representatives.erase (message_a.vote->account);
+	}
+}
+
+void rai::vote_processor::verify_votes (std::deque <std::pair <std::shared_ptr <rai::vote>, rai::endpoint>> & votes_a)
+{
+	auto size (votes_a.size ());
+	std::vector <rai::uint256_union> hashes;
+	hashes.reserve (size);
+	std::vector <unsigned char const *> messages;
+	messages.reserve (size);
+	std::vector <size_t> lengths (size, sizeof (rai::uint256_union));
+	std::vector <unsigned char const *> pub_keys;
+	pub_keys.reserve (size);
+	std::vector <unsigned char const *> signatures;
+	signatures.reserve (size);
+	std::vector <int> verifications (size, 0);
+	for (auto & i : votes_a)
+	{
+		hashes.push_back (i.first->hash ());
+		messages.push_back (hashes.back ().bytes.data ());
+		pub_keys.push_back (i.first->account.bytes.data ());
+		signatures.push_back (i.first->signature.bytes.data ());
+	}
+	rai::validate_message_batch (messages.data (), lengths.data (), pub_keys.data (), signatures.data (), size, verifications.data ());
+	std::vector <rai::vote_result> results (size, rai::vote_result ({rai::vote_code::invalid, 0}));
+	{
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		for (size_t i (0); i < size; ++i)
+		{
+			if (verifications [i] == 1)
+			{
+				results [i] = node.store.vote_sequence (transaction, votes_a [i].first);
+			}
+		}
+	}
+	for (size_t i (0); i < size; ++i)
+	{
+		auto & vote_l (votes_a [i].first);
+		auto & endpoint_l (votes_a [i].second);
+		auto & result (results [i]);
+		if (result.code == rai::vote_code::invalid)
+		{
+			++invalid;
+		}
+		else
+		{
+			++verified;
+		}
+		process_result (result, vote_l, endpoint_l);
+		if (result.code == rai::vote_code::replay)
+		{
+			assert (result.vote->sequence > vote_l->sequence);
+			// This tries to assist rep nodes that have lost track of their highest sequence number by replaying our highest known vote back to them
+			// Only do this if the sequence number is significantly different to account for network reordering
+			// Amplify attack considerations: We're sending out a confirm_ack in response to a confirm_ack for no net traffic increase
+			if (result.vote->sequence - vote_l->sequence > 10000)
+			{
+				rai::confirm_ack confirm (result.vote);
+				std::shared_ptr <std::vector <uint8_t>> bytes (new std::vector <uint8_t>);
+				{
+					rai::vectorstream stream (*bytes);
+					confirm.serialize (stream);
+				}
+				node.network.confirm_send (confirm, bytes, endpoint_l);
+			}
+		}
+	}
+}
+
+rai::vote_result rai::vote_processor::vote (std::shared_ptr <rai::vote> vote_a, rai::endpoint endpoint_a)
+{
+	rai::vote_result result;
+	{
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		result = node.store.vote_validate (transaction, vote_a);
+	}
+	process_result (result, vote_a, endpoint_a);
+	return result;
+}
+
+void rai::vote_processor::process_result (rai::vote_result const & result_a, std::shared_ptr <rai::vote> vote_a, rai::endpoint const & endpoint_a)
+{
+	if (node.config.logging.vote_logging ())
+	{
+		char const * status;
+		switch (result_a.code)
+		{
+			case rai::vote_code::invalid:
+				status = "Invalid";
+				break;
+			case rai::vote_code::replay:
+				status = "Replay";
+				break;
+			case rai::vote_code::vote:
+				status = "Vote";
+				break;
+		}
+		BOOST_LOG (node.log) << boost::str (boost::format ("Vote from: %1% sequence: %2% block: %3% status: %4%") % vote_a->account.to_account () % std::to_string (vote_a->sequence) % vote_a->block->hash ().to_string () % status);
+	}
+	switch (result_a.code)
+	{
+		case rai::vote_code::vote:
+			node.observers.vote (vote_a, endpoint_a);
+		case rai::vote_code::replay:
+		case rai::vote_code::invalid:
+			break;
+	}
+}
+
+void rai::rep_crawler::add (rai::block_hash const & hash_a)
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	active.insert (hash_a);
+}
+
+void rai::rep_crawler::remove (rai::block_hash const & hash_a)
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	active.erase (hash_a);
+}
+
+bool rai::rep_crawler::exists (rai::block_hash const & hash_a)
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	return active.count (hash_a) != 0;
+}
+
+rai::block_processor_item::block_processor_item (std::shared_ptr <rai::block> block_a) :
+block_processor_item (block_a, nullptr, false)
+{
+}
+
 rai::block_processor_item::block_processor_item (std::shared_ptr <rai::block> block_a, bool force_a) :
 block_processor_item (block_a, nullptr, force_a)
 {
@@ -1079,15 +1764,157 @@ block_processor_item (block_a, callback_a, false)
 rai::block_processor_item::block_processor_item (std::shared_ptr <rai::block> block_a, std::function <void (MDB_txn *, rai::process_return, std::shared_ptr <rai::block>)> callback_a, bool force_a) :
 block (block_a),
 callback (callback_a),
-force (force_a)
+force (force_a),
+bootstrap (false),
+verified (0),
+hash (0)
+{
+}
+
+rai::signature_checker::signature_checker (unsigned threads_a) :
+stopped (false)
+{
+	for (auto i (0u); i < threads_a; ++i)
+	{
+		threads.push_back (std::thread ([this] () { run (); }));
+	}
+}
+
+rai::signature_checker::~signature_checker ()
+{
+	stop ();
+}
+
+void rai::signature_checker::stop ()
+{
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	for (auto & i : threads)
+	{
+		if (i.joinable ())
+		{
+			i.join ();
+		}
+	}
+}
+
+void rai::signature_checker::run ()
+{
+	std::unique_lock <std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!tasks.empty ())
+		{
+			auto task (tasks.front ());
+			tasks.pop_front ();
+			lock.unlock ();
+			task ();
+			lock.lock ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+void rai::signature_checker::verify (rai::signature_check_set & check_a)
+{
+	auto verify_range ([&check_a] (size_t begin_a, size_t size_a)
+	{
+		rai::validate_message_batch (check_a.messages + begin_a, check_a.message_lengths + begin_a, check_a.pub_keys + begin_a, check_a.signatures + begin_a, size_a, check_a.verifications + begin_a);
+	});
+	if (threads.empty () || check_a.size <= batch_size)
+	{
+		verify_range (0, check_a.size);
+	}
+	else
+	{
+		// Workers take every batch after the first, the calling thread verifies the first and then helps drain the queue
+		size_t remaining (0);
+		std::unique_lock <std::mutex> lock (mutex);
+		for (size_t i (batch_size); i < check_a.size; i += batch_size)
+		{
+			auto size (std::min (batch_size, check_a.size - i));
+			++remaining;
+			tasks.push_back ([this, &verify_range, &remaining, i, size] ()
+			{
+				verify_range (i, size);
+				std::lock_guard <std::mutex> lock (mutex);
+				--remaining;
+				condition.notify_all ();
+			});
+		}
+		condition.notify_all ();
+		lock.unlock ();
+		verify_range (0, batch_size);
+		lock.lock ();
+		while (remaining > 0)
+		{
+			if (!tasks.empty ())
+			{
+				auto task (tasks.front ());
+				tasks.pop_front ();
+				lock.unlock ();
+				task ();
+				lock.lock ();
+			}
+			else
+			{
+				condition.wait (lock);
+			}
+		}
+	}
+}
+
+rai::block_processor_stats::block_processor_stats () :
+queued (0),
+blocks (0),
+batches (0),
+time (0)
 {
 }
 
 rai::block_processor::block_processor (rai::node & node_a) :
 stopped (false),
-idle (true),
+active (0),
 node (node_a)
 {
+	stage_stats [static_cast <size_t> (rai::block_processor_stage::hash)].name = "hash";
+	stage_stats [static_cast <size_t> (rai::block_processor_stage::verify)].name = "verify";
+	stage_stats [static_cast <size_t> (rai::block_processor_stage::dependencies)].name = "dependencies";
+	stage_stats [static_cast <size_t> (rai::block_processor_stage::commit)].name = "commit";
+	threads.push_back (std::thread ([this] ()
+	{
+		run_stage (rai::block_processor_stage::hash, blocks, &hashed, [] (std::deque <rai::block_processor_item> & items_a)
+		{
+			for (auto & i : items_a)
+			{
+				i.hash = i.block->hash ();
+			}
+		});
+	}));
+	threads.push_back (std::thread ([this] ()
+	{
+		run_stage (rai::block_processor_stage::verify, hashed, &verified, [this] (std::deque <rai::block_processor_item> & items_a)
+		{
+			if (signers.size () > max_signers)
+			{
+				signers.clear ();
+			}
+			verify_signatures (items_a, signers);
+		});
+	}));
+	threads.push_back (std::thread ([this] ()
+	{
+		run_stage (rai::block_processor_stage::dependencies, verified, &checked, [this] (std::deque <rai::block_processor_item> & items_a)
+		{
+			check_dependencies (items_a);
+		});
+	}));
 }
 
 rai::block_processor::~block_processor ()
@@ -1097,15 +1924,24 @@ rai::block_processor::~block_processor ()
 
 void rai::block_processor::stop ()
 {
-	std::lock_guard <std::mutex> lock (mutex);
-	stopped = true;
-	condition.notify_all ();
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	for (auto & i : threads)
+	{
+		if (i.joinable ())
+		{
+			i.join ();
+		}
+	}
 }
 
 void rai::block_processor::flush ()
 {
     std::unique_lock <std::mutex> lock (mutex);
-    while (!stopped && (!blocks.empty () || !idle))
+    while (!stopped && (!blocks.empty () || !hashed.empty () || !verified.empty () || !checked.empty () || active != 0))
     {
         condition.wait (lock);
     }
@@ -1120,49 +1956,197 @@ void rai::block_processor::add (rai::block_processor_item const & item_a)
 
 void rai::block_processor::process_blocks ()
 {
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		commit_thread = std::this_thread::get_id ();
+	}
+	run_stage (rai::block_processor_stage::commit, checked, nullptr, [this] (std::deque <rai::block_processor_item> & items_a)
+	{
+		process_receive_many (items_a, group_commit ());
+		// Let other threads get an opportunity to transaction lock
+		std::this_thread::yield ();
+	});
+}
+
+void rai::block_processor::run_stage (rai::block_processor_stage stage_a, std::deque <rai::block_processor_item> & input_a, std::deque <rai::block_processor_item> * output_a, std::function <void (std::deque <rai::block_processor_item> &)> action_a)
+{
+	auto & stats (stage_stats [static_cast <size_t> (stage_a)]);
 	std::unique_lock <std::mutex> lock (mutex);
 	while (!stopped)
 	{
-		if (!blocks.empty ())
+		// Wait for room downstream rather than letting fast stages queue unbounded work in front of slow ones
+		if (!input_a.empty () && (output_a == nullptr || output_a->size () < max_queue))
 		{
-			std::deque <rai::block_processor_item> blocks_processing;
-			std::swap (blocks, blocks_processing);
+			std::deque <rai::block_processor_item> items;
+			while (!input_a.empty () && items.size () < batch_size)
+			{
+				items.push_back (std::move (input_a.front ()));
+				input_a.pop_front ();
+			}
+			++active;
+			condition.notify_all ();
 			lock.unlock ();
-			process_receive_many (blocks_processing);
-			// Let other threads get an opportunity to transaction lock
-			std::this_thread::yield ();
+			auto size (items.size ());
+			auto start (std::chrono::steady_clock::now ());
+			action_a (items);
+			auto elapsed (std::chrono::duration_cast <std::chrono::microseconds> (std::chrono::steady_clock::now () - start));
 			lock.lock ();
+			stats.blocks += size;
+			++stats.batches;
+			stats.time += elapsed.count ();
+			if (output_a != nullptr)
+			{
+				output_a->insert (output_a->end (), std::make_move_iterator (items.begin ()), std::make_move_iterator (items.end ()));
+			}
+			--active;
+			condition.notify_all ();
 		}
 		else
 		{
-            idle = true;
-            condition.notify_all ();
 			condition.wait (lock);
-            idle = false;
 		}
 	}
 }
 
+std::vector <rai::block_processor_stats> rai::block_processor::stats ()
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	std::vector <rai::block_processor_stats> result (stage_stats.begin (), stage_stats.end ());
+	result [static_cast <size_t> (rai::block_processor_stage::hash)].queued = blocks.size ();
+	result [static_cast <size_t> (rai::block_processor_stage::verify)].queued = hashed.size ();
+	result [static_cast <size_t> (rai::block_processor_stage::dependencies)].queued = verified.size ();
+	result [static_cast <size_t> (rai::block_processor_stage::commit)].queued = checked.size ();
+	// Sorted writes of bootstrap blocks, batches are flushes
+	rai::block_processor_stats ingest;
+	ingest.name = "ingest";
+	ingest.blocks = node.store.block_buffer.written;
+	ingest.batches = node.store.block_buffer.flushes;
+	ingest.time = node.store.block_buffer.time;
+	result.push_back (ingest);
+	return result;
+}
+
 void rai::block_processor::process_receive_many (rai::block_processor_item const & item_a)
 {
-	std::deque <rai::block_processor_item> blocks_processing;
-	blocks_processing.push_back (item_a);
-	process_receive_many (blocks_processing);
+	if (group_commit ())
+	{
+		process_wait (item_a);
+	}
+	else
+	{
+		std::deque <rai::block_processor_item> blocks_processing;
+		blocks_processing.push_back (item_a);
+		process_receive_many (blocks_processing);
+	}
 }
 
 void rai::block_processor::process_receive_many (std::deque <rai::block_processor_item> & blocks_processing)
 {
+	process_receive_many (blocks_processing, false);
+}
+
+bool rai::block_processor::group_commit () const
+{
+	return node.config.group_commit_interval != 0;
+}
+
+rai::process_return rai::block_processor::process_wait (rai::block_processor_item const & item_a)
+{
+	auto promise (std::make_shared <std::promise <rai::process_return>> ());
+	auto once (std::make_shared <std::once_flag> ());
+	auto item (item_a);
+	auto completed (item_a.completed);
+	item.completed = [promise, once, completed] (rai::process_return const & result_a, std::shared_ptr <rai::block> block_a)
+	{
+		std::call_once (*once, [&] ()
+		{
+			if (completed)
+			{
+				completed (result_a, block_a);
+			}
+			promise->set_value (result_a);
+		});
+	};
+	auto direct (false);
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		// The commit thread can't wait on itself and nothing drains the queues once stopped
+		direct = stopped || std::this_thread::get_id () == commit_thread;
+		if (!direct)
+		{
+			blocks.push_back (item);
+			condition.notify_all ();
+		}
+	}
+	auto future (promise->get_future ());
+	while (!direct && future.wait_for (std::chrono::milliseconds (100)) != std::future_status::ready)
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		// Blocks still queued are dropped on shutdown
+		direct = stopped;
+	}
+	if (direct)
+	{
+		std::deque <rai::block_processor_item> blocks_processing;
+		blocks_processing.push_back (item);
+		process_receive_many (blocks_processing);
+	}
+	return future.get ();
+}
+
+void rai::block_processor::group_wait (std::deque <rai::block_processor_item> & items_a, size_t target_a, std::chrono::system_clock::time_point const & deadline_a)
+{
+	std::unique_lock <std::mutex> lock (mutex);
+	size_t count (0);
+	while (!stopped && items_a.size () < target_a && std::chrono::system_clock::now () < deadline_a)
+	{
+		if (checked.empty ())
+		{
+			condition.wait_until (lock, deadline_a);
+		}
+		while (!checked.empty () && items_a.size () < target_a)
+		{
+			items_a.push_back (std::move (checked.front ()));
+			checked.pop_front ();
+			++count;
+		}
+	}
+	if (count > 0)
+	{
+		stage_stats [static_cast <size_t> (rai::block_processor_stage::commit)].blocks += count;
+		condition.notify_all ();
+	}
+}
+
+void rai::block_processor::process_receive_many (std::deque <rai::block_processor_item> & blocks_processing, bool group_a)
+{
+	if (group_a)
+	{
+		// Gather blocks from other producers before taking the write lock so they share one commit
+		group_wait (blocks_processing, node.config.group_commit_blocks, std::chrono::system_clock::now () + std::chrono::milliseconds (node.config.group_commit_interval));
+	}
 	while (!blocks_processing.empty ())
 	{
 		std::deque <std::pair <std::shared_ptr <rai::block>, rai::process_return>> progress;
+		std::deque <std::pair <rai::block_processor_item, rai::process_return>> completed;
+		std::vector <rai::block_hash> committed;
+		// Check signatures up front so the write transaction is only held for ledger updates
+		verify_signatures (blocks_processing);
 		{
 			rai::transaction transaction (node.store.environment, nullptr, true);
+			if (std::any_of (blocks_processing.begin (), blocks_processing.end (), [] (rai::block_processor_item const & item_a) { return item_a.bootstrap; }))
+			{
+				// Bootstrap batches are large and their hashes random, sorting the block writes turns them in to one pass over the table
+				node.store.block_buffer_begin (transaction);
+			}
+			// The dependency stage pools gaps without a write transaction
+			node.store.unchecked_trim (transaction);
 			auto cutoff (std::chrono::system_clock::now () + rai::transaction_timeout);
 			while (!blocks_processing.empty () && std::chrono::system_clock::now () < cutoff)
 			{
 				auto item (blocks_processing.front ());
 				blocks_processing.pop_front ();
-				auto hash (item.block->hash ());
+				auto hash (item.hash.is_zero () ? item.block->hash () : item.hash);
 				if (item.force)
 				{
 					auto successor (node.ledger.successor (transaction, item.block->root ()));
@@ -1173,11 +2157,15 @@ void rai::block_processor::process_receive_many (std::deque <rai::block_processo
 						node.ledger.rollback (transaction, successor->hash ());
 					}
 				}
-				auto process_result (process_receive_one (transaction, item.block));
+				auto process_result (process_receive_one (transaction, item.block, item.verified));
 				if (item.callback)
 				{
 					item.callback (transaction, process_result, item.block);
 				}
+				if (item.completed)
+				{
+					completed.push_back (std::make_pair (item, process_result));
+				}
 				switch (process_result.code)
 				{
 					case rai::process_result::progress:
@@ -1186,6 +2174,7 @@ void rai::block_processor::process_receive_many (std::deque <rai::block_processo
 					}
 					case rai::process_result::old:
 					{
+						committed.push_back (hash);
 						auto cached (node.store.unchecked_get (transaction, hash));
 						for (auto i (cached.begin ()), n (cached.end ()); i != n; ++i)
 						{
@@ -1201,17 +2190,215 @@ void rai::block_processor::process_receive_many (std::deque <rai::block_processo
 				}
 			}
 		}
+		{
+			// The dependency stage may have judged blocks against a snapshot from before this commit, the lock makes sure any it found missing one of these are pooled by now
+			std::lock_guard <std::mutex> lock (gaps_mutex);
+			for (auto & i : committed)
+			{
+				for (auto & block : node.store.unchecked_pool_take (i))
+				{
+					blocks_processing.push_back (rai::block_processor_item (block));
+				}
+			}
+		}
 		for (auto & i : progress)
 		{
 			node.observers.blocks (i.first, i.second.account, i.second.amount);
 		}
+		for (auto & i : completed)
+		{
+			i.first.completed (i.second, i.first.block);
+		}
+	}
+}
+
+void rai::block_processor::verify_signatures (std::deque <rai::block_processor_item> & items_a)
+{
+	std::unordered_map <rai::block_hash, rai::account> signers_l;
+	verify_signatures (items_a, signers_l);
+}
+
+void rai::block_processor::verify_signatures (std::deque <rai::block_processor_item> & items_a, std::unordered_map <rai::block_hash, rai::account> & signers_a)
+{
+	std::vector <rai::block_processor_item *> items;
+	std::vector <rai::block_hash> hashes;
+	std::vector <rai::account> accounts;
+	std::vector <rai::signature> signatures;
+	{
+		// Blocks usually extend each other, remember the signer of each so successors resolve without a lookup
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		for (auto & item : items_a)
+		{
+			if (item.hash.is_zero ())
+			{
+				item.hash = item.block->hash ();
+			}
+			auto & hash (item.hash);
+			rai::account account (0);
+			if (!item.verified.is_zero ())
+			{
+				account = item.verified;
+			}
+			else if (item.block->type () == rai::block_type::open)
+			{
+				account = static_cast <rai::open_block const &> (*item.block).hashables.account;
+			}
+			else
+			{
+				auto previous (item.block->previous ());
+				auto existing (signers_a.find (previous));
+				if (existing != signers_a.end ())
+				{
+					account = existing->second;
+				}
+				else
+				{
+					account = node.store.frontier_get (transaction, previous);
+				}
+			}
+			if (!account.is_zero ())
+			{
+				signers_a [hash] = account;
+				if (item.verified.is_zero ())
+				{
+					items.push_back (&item);
+					hashes.push_back (hash);
+					accounts.push_back (account);
+					signatures.push_back (item.block->block_signature ());
+				}
+			}
+		}
+	}
+	// Blocks whose signer isn't known yet are left for the ledger to check
+	if (!items.empty ())
+	{
+		auto size (items.size ());
+		std::vector <unsigned char const *> messages (size);
+		std::vector <size_t> lengths (size, sizeof (rai::block_hash));
+		std::vector <unsigned char const *> pub_keys (size);
+		std::vector <unsigned char const *> signatures_l (size);
+		std::vector <int> verifications (size, 0);
+		for (size_t i (0); i < size; ++i)
+		{
+			messages [i] = hashes [i].bytes.data ();
+			pub_keys [i] = accounts [i].bytes.data ();
+			signatures_l [i] = signatures [i].bytes.data ();
+		}
+		rai::signature_check_set check = { size, messages.data (), lengths.data (), pub_keys.data (), signatures_l.data (), verifications.data () };
+		node.checker.verify (check);
+		for (size_t i (0); i < size; ++i)
+		{
+			if (verifications [i] == 1)
+			{
+				items [i]->verified = accounts [i];
+			}
+		}
+	}
+}
+
+void rai::block_processor::check_dependencies (std::deque <rai::block_processor_item> & items_a)
+{
+	// Held from before the snapshot is taken until gaps are pooled, a commit landing in between drains the pool for its blocks once it can take the lock
+	std::unique_lock <std::mutex> gaps_lock (gaps_mutex);
+	std::unordered_set <rai::block_hash> batch;
+	std::deque <std::pair <rai::block_processor_item, rai::process_return>> finished;
+	// Callbacks for blocks finished here get this read transaction, writes through it fail the store's status asserts
+	rai::transaction transaction (node.store.environment, nullptr, false);
+	for (auto i (items_a.begin ()); i != items_a.end ();)
+	{
+		rai::process_return result;
+		result.code = rai::process_result::progress;
+		if (!i->force)
+		{
+			auto existing (node.store.block_get (transaction, i->hash));
+			if (existing != nullptr)
+			{
+				// Blocks with more work replace the stored copy and anything still waiting on this block needs the write transaction
+				auto root (i->block->root ());
+				if (rai::work_value (root, i->block->block_work ()) <= rai::work_value (root, existing->block_work ()) && node.store.unchecked_get (transaction, i->hash).empty ())
+				{
+					result.code = rai::process_result::old;
+				}
+			}
+			else
+			{
+				// Same order the ledger checks them in
+				auto missing ([&] (rai::block_hash const & hash_a)
+				{
+					return !hash_a.is_zero () && batch.find (hash_a) == batch.end () && !node.store.block_exists (transaction, hash_a);
+				});
+				if (missing (i->block->source ()))
+				{
+					result.code = rai::process_result::gap_source;
+				}
+				else if (missing (i->block->previous ()))
+				{
+					result.code = rai::process_result::gap_previous;
+				}
+			}
+		}
+		switch (result.code)
+		{
+			case rai::process_result::old:
+			{
+				if (node.config.logging.ledger_duplicate_logging ())
+				{
+					BOOST_LOG (node.log) << boost::str (boost::format ("Old for: %1%") % i->hash.to_string ());
+				}
+				std::lock_guard <std::mutex> lock (node.gap_cache.mutex);
+				node.gap_cache.blocks.get <1> ().erase (i->hash);
+				break;
+			}
+			case rai::process_result::gap_source:
+			case rai::process_result::gap_previous:
+			{
+				auto source (result.code == rai::process_result::gap_source);
+				if (node.config.logging.ledger_logging ())
+				{
+					BOOST_LOG (node.log) << boost::str (boost::format (source ? "Gap source for: %1%" : "Gap previous for: %1%") % i->hash.to_string ());
+				}
+				// Pooled without a write, the commit stage spills the pool when it grows past its limit
+				node.store.unchecked_pool_put (transaction, source ? i->block->source () : i->block->previous (), i->block);
+				node.gap_cache.add (transaction, i->block);
+				break;
+			}
+			default:
+				break;
+		}
+		if (result.code != rai::process_result::progress)
+		{
+			finished.push_back (std::make_pair (std::move (*i), result));
+			i = items_a.erase (i);
+		}
+		else
+		{
+			batch.insert (i->hash);
+			++i;
+		}
+	}
+	gaps_lock.unlock ();
+	for (auto & i : finished)
+	{
+		if (i.first.callback)
+		{
+			i.first.callback (transaction, i.second, i.first.block);
+		}
+		if (i.first.completed)
+		{
+			i.first.completed (i.second, i.first.block);
+		}
 	}
 }
 
 rai::process_return rai::block_processor::process_receive_one (MDB_txn * transaction_a, std::shared_ptr <rai::block> block_a)
+{
+	return process_receive_one (transaction_a, block_a, rai::account (0));
+}
+
+rai::process_return rai::block_processor::process_receive_one (MDB_txn * transaction_a, std::shared_ptr <rai::block> block_a, rai::account const & verified_a)
 {
 	rai::process_return result;
-	result = node.ledger.process (transaction_a, *block_a);
+	result = node.ledger.process (transaction_a, *block_a, verified_a);
 	switch (result.code)
 	{
 		case rai::process_result::progress:
@@ -1249,13 +2436,14 @@ rai::process_return rai::block_processor::process_receive_one (MDB_txn * transac
 			{
 				auto root (block_a->root ());
 				auto hash (block_a->hash ());
-				auto existing (node.store.block_get (transaction_a, hash));
+				rai::block_sideband sideband;
+				auto existing (node.store.block_get (transaction_a, hash, &sideband));
 				if (existing != nullptr)
 				{
 					// Replace block with one that has higher work value
 					if (rai::work_value (root, block_a->block_work ()) > rai::work_value (root, existing->block_work ()))
 					{
-						node.store.block_put (transaction_a, hash, *block_a, node.store.block_successor (transaction_a, hash));
+						node.store.block_put (transaction_a, hash, *block_a, node.store.block_successor (transaction_a, hash), sideband);
 					}
 				}
 				else
@@ -1334,7 +2522,7 @@ service (service_a),
 config (config_a),
 alarm (alarm_a),
 work (work_a),
-store (init_a.block_store_init, application_path_a / "data.ldb"),
+store (init_a.block_store_init, application_path_a / "data.ldb", config_a.lmdb),
 gap_cache (*this),
 ledger (store, config_a.inactive_supply.number ()),
 active (*this),
@@ -1343,13 +2531,17 @@ network (*this, config.peering_port),
 bootstrap_initiator (*this),
 bootstrap (service_a, config.peering_port, *this),
 peers (network.endpoint ()),
+peer_cache (init_a.block_store_init, store),
 application_path (application_path_a),
 port_mapping (*this),
 vote_processor (*this),
 warmed_up (0),
+checker (config.signature_checker_threads),
 block_processor (*this),
-block_processor_thread ([this] () { this->block_processor.process_blocks (); })
+block_processor_thread ([this] () { this->block_processor.process_blocks (); }),
+message_processor (*this)
 {
+	store.unchecked_pool.max = config.unchecked_pool_max;
 	wallets.observer = [this] (rai::account const & account_a, bool active)
 	{
 		observers.wallet (account_a, active);
@@ -1366,7 +2558,7 @@ block_processor_thread ([this] () { this->block_processor.process_blocks (); })
 	{
 		if (this->block_arrival.recent (block_a->hash ()))
 		{
-			rai::transaction transaction (store.environment, nullptr, true);
+			rai::transaction transaction (store.environment, nullptr, false);
 			active.start (transaction, block_a);
 		}
 	});
@@ -1627,16 +2819,36 @@ void rai::network::confirm_send (rai::confirm_ack const & confirm_a, std::shared
     }
     std::weak_ptr <rai::node> node_w (node.shared ());
 	++outgoing.confirm_ack;
-    node.network.send_buffer (bytes_a->data (), bytes_a->size (), endpoint_a, [bytes_a, node_w, endpoint_a] (boost::system::error_code const & ec, size_t size_a)
+    send (bytes_a, std::vector <rai::endpoint> (1, endpoint_a), rai::send_priority::vote, [node_w] (boost::system::error_code const & ec, rai::endpoint const & endpoint_a)
 	{
 		if (auto node_l = node_w.lock ())
 		{
 			if (node_l->config.logging.network_logging ())
 			{
-				if (ec)
-				{
-					BOOST_LOG (node_l->log) << boost::str (boost::format ("Error broadcasting confirm_ack to %1%: %2%") % endpoint_a % ec.message ());
-				}
+				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error broadcasting confirm_ack to %1%: %2%") % endpoint_a % ec.message ());
+			}
+		}
+	});
+}
+
+void rai::network::confirm_send (rai::confirm_ack const & confirm_a, std::shared_ptr <std::vector <uint8_t>> bytes_a, std::vector <rai::endpoint> const & endpoints_a)
+{
+    if (node.config.logging.network_publish_logging ())
+    {
+		for (auto & i : endpoints_a)
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm_ack for block %1% to %2% sequence %3%") % confirm_a.vote->block->hash ().to_string () % i % std::to_string (confirm_a.vote->sequence));
+		}
+    }
+    std::weak_ptr <rai::node> node_w (node.shared ());
+	outgoing.confirm_ack += endpoints_a.size ();
+    send (bytes_a, endpoints_a, rai::send_priority::vote, [node_w] (boost::system::error_code const & ec, rai::endpoint const & endpoint_a)
+	{
+		if (auto node_l = node_w.lock ())
+		{
+			if (node_l->config.logging.network_logging ())
+			{
+				BOOST_LOG (node_l->log) << boost::str (boost::format ("Error broadcasting confirm_ack to %1%: %2%") % endpoint_a % ec.message ());
 			}
 		}
 	});
@@ -1681,6 +2893,12 @@ std::vector <rai::endpoint> rai::peer_container::list ()
     return result;
 }
 
+std::vector <rai::peer_information> rai::peer_container::list_information ()
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	return peers;
+}
+
 std::map <rai::endpoint, unsigned> rai::peer_container::list_version ()
 {
 	std::map <rai::endpoint, unsigned> result;
@@ -1696,23 +2914,20 @@ rai::endpoint rai::peer_container::bootstrap_peer ()
 {
     rai::endpoint result (boost::asio::ip::address_v6::any (), 0);
     std::lock_guard <std::mutex> lock (mutex);
-	;
-	for (auto i (peers.get <4> ().begin ()), n (peers.get <4> ().end ()); i != n;)
+	// Least recently attempted peer that can bootstrap
+	auto best (peers.end ());
+	for (auto i (peers.begin ()), n (peers.end ()); i != n; ++i)
 	{
-		if (i->network_version >= 0x5)
-		{
-			result = i->endpoint;
-			peers.get <4> ().modify (i, [] (rai::peer_information & peer_a)
-			{
-				peer_a.last_bootstrap_attempt = std::chrono::system_clock::now ();
-			});
-			i = n;
-		}
-		else
+		if (i->network_version >= 0x5 && (best == n || i->last_bootstrap_attempt < best->last_bootstrap_attempt))
 		{
-			++i;
+			best = i;
 		}
-    }
+	}
+	if (best != peers.end ())
+	{
+		result = best->endpoint;
+		best->last_bootstrap_attempt = std::chrono::system_clock::now ();
+	}
     return result;
 }
 
@@ -1793,11 +3008,13 @@ bool rai::parse_tcp_endpoint (std::string const & string, rai::tcp_endpoint & en
 
 void rai::node::start ()
 {
+	restore_peers ();
     network.receive ();
     ongoing_keepalive ();
 	ongoing_bootstrap ();
 	ongoing_store_flush ();
 	ongoing_rep_crawl ();
+	ongoing_peer_cache ();
     bootstrap.start ();
 	backup_wallet ();
 	active.announce_votes ();
@@ -1809,11 +3026,20 @@ void rai::node::start ()
 void rai::node::stop ()
 {
     BOOST_LOG (log) << "Node stopping";
+	save_peers ();
+	message_processor.stop ();
 	block_processor.stop ();
 	if (block_processor_thread.joinable ())
 	{
 		block_processor_thread.join ();
 	}
+	if (store.unchecked_pool_size () != 0)
+	{
+		// Keep blocks still waiting on dependencies across restarts
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.unchecked_spill (transaction, std::chrono::system_clock::time_point::max ());
+	}
+	vote_processor.stop ();
 	active.stop ();
     network.stop ();
 	bootstrap_initiator.stop ();
@@ -1940,8 +3166,9 @@ void rai::node::ongoing_bootstrap ()
 void rai::node::ongoing_store_flush ()
 {
 	{
+		// Unchecked blocks stay in memory until they age out or the pool fills
 		rai::transaction transaction (store.environment, nullptr, true);
-		store.flush (transaction);
+		store.flush (transaction, std::chrono::system_clock::now () - std::chrono::seconds (config.unchecked_pool_age));
 	}
 	std::weak_ptr <rai::node> node_w (shared_from_this ());
 	alarm.add (std::chrono::system_clock::now () + std::chrono::seconds (5), [node_w] ()
@@ -1953,6 +3180,56 @@ void rai::node::ongoing_store_flush ()
 	});
 }
 
+void rai::node::ongoing_peer_cache ()
+{
+	save_peers ();
+	std::weak_ptr <rai::node> node_w (shared_from_this ());
+	alarm.add (std::chrono::system_clock::now () + peer_cache_interval, [node_w] ()
+	{
+		if (auto node_l = node_w.lock ())
+		{
+			node_l->ongoing_peer_cache ();
+		}
+	});
+}
+
+void rai::node::save_peers ()
+{
+	auto peers_l (peers.list_information ());
+	rai::transaction transaction (store.environment, nullptr, true);
+	peer_cache.save (transaction, peers_l);
+}
+
+void rai::node::restore_peers ()
+{
+	std::vector <rai::peer_information> cached;
+	{
+		rai::transaction transaction (store.environment, nullptr, false);
+		cached = peer_cache.load (transaction);
+	}
+	auto now (std::chrono::system_clock::now ());
+	size_t restored (0);
+	for (auto & i : cached)
+	{
+		if (i.last_contact > now - peer_cache_cutoff && !peers.not_a_peer (i.endpoint))
+		{
+			// The peer gets one purge cutoff to answer and is sent a keepalive on the first round
+			auto saved (i.last_contact);
+			i.last_contact = now;
+			i.last_attempt = std::chrono::system_clock::time_point ();
+			if (!peers.insert (i))
+			{
+				peer_cache.restored (i.endpoint, saved, now);
+				++restored;
+			}
+		}
+	}
+	if (config.logging.network_logging ())
+	{
+		BOOST_LOG (log) << boost::str (boost::format ("Restored %1% of %2% cached peers") % restored % cached.size ());
+	}
+}
+
 void rai::node::backup_wallet ()
 {
 	rai::transaction transaction (store.environment, nullptr, false);
@@ -2337,13 +3614,26 @@ std::unordered_set <rai::endpoint> rai::peer_container::random_set (size_t count
 		for (auto i (0); i < random_cutoff && result.size () < count_a; ++i)
 		{
 			auto index (random_pool.GenerateWord32 (0, peers_size - 1));
-			result.insert (peers.get <3> () [index].endpoint);
+			result.insert (peers [index].endpoint);
 		}
 	}
-	// Fill the remainder with most recent contact
-	for (auto i (peers.get <1> ().begin ()), n (peers.get <1> ().end ()); i != n && result.size () < count_a; ++i)
+	if (result.size () < count_a)
 	{
-		result.insert (i->endpoint);
+		// Fill the remainder with most recent contact
+		std::vector <rai::peer_information const *> recent;
+		recent.reserve (peers.size ());
+		for (auto & i : peers)
+		{
+			recent.push_back (&i);
+		}
+		std::sort (recent.begin (), recent.end (), [] (rai::peer_information const * lhs, rai::peer_information const * rhs)
+		{
+			return lhs->last_contact > rhs->last_contact;
+		});
+		for (auto i (recent.begin ()), n (recent.end ()); i != n && result.size () < count_a; ++i)
+		{
+			result.insert ((*i)->endpoint);
+		}
 	}
 	return result;
 }
@@ -2370,12 +3660,25 @@ std::vector <rai::peer_information> rai::peer_container::representatives (size_t
 	std::vector <peer_information> result;
 	result.reserve (std::min (count_a, size_t (16)));
 	std::lock_guard <std::mutex> lock (mutex);
-	for (auto i (peers.get <6> ().begin ()), n (peers.get <6> ().end ()); i != n && result.size () < count_a; ++i)
+	if (representatives_stale)
 	{
-		if (!i->rep_weight.is_zero ())
+		representatives_cache.clear ();
+		for (auto & i : peers)
 		{
-			result.push_back (*i);
+			if (!i.rep_weight.is_zero ())
+			{
+				representatives_cache.push_back (i);
+			}
 		}
+		std::stable_sort (representatives_cache.begin (), representatives_cache.end (), [] (rai::peer_information const & lhs, rai::peer_information const & rhs)
+		{
+			return lhs.rep_weight.number () > rhs.rep_weight.number ();
+		});
+		representatives_stale = false;
+	}
+	for (auto i (representatives_cache.begin ()), n (representatives_cache.end ()); i != n && result.size () < count_a; ++i)
+	{
+		result.push_back (*i);
 	}
 	return result;
 }
@@ -2384,13 +3687,23 @@ std::vector <rai::peer_information> rai::peer_container::purge_list (std::chrono
 {
 	std::vector <rai::peer_information> result;
 	{
+		auto now (std::chrono::system_clock::now ());
 		std::lock_guard <std::mutex> lock (mutex);
-		auto pivot (peers.get <1> ().lower_bound (cutoff));
-		result.assign (pivot, peers.get <1> ().end ());
-		peers.get <1> ().erase (peers.get <1> ().begin (), pivot);
-		for (auto i (peers.begin ()), n (peers.end ()); i != n; ++i)
+		auto pivot (std::remove_if (peers.begin (), peers.end (), [&cutoff] (rai::peer_information const & peer_a)
+		{
+			return peer_a.last_contact < cutoff;
+		}));
+		if (pivot != peers.end ())
 		{
-			peers.modify (i, [] (rai::peer_information & info) {info.last_attempt = std::chrono::system_clock::now ();});
+			peers.erase (pivot, peers.end ());
+			rehash ();
+			representatives_stale = true;
+		}
+		// Callers see when each peer was last attempted before this purge
+		result = peers;
+		for (auto & i : peers)
+		{
+			i.last_attempt = now;
 		}
 	}
 	if (result.empty ())
@@ -2402,14 +3715,22 @@ std::vector <rai::peer_information> rai::peer_container::purge_list (std::chrono
 
 std::vector <rai::endpoint> rai::peer_container::rep_crawl ()
 {
+	std::vector <std::pair <std::chrono::system_clock::time_point, size_t>> requests;
 	std::vector <rai::endpoint> result;
-	result.reserve (8);
+	result.reserve (peers_per_crawl);
 	std::lock_guard <std::mutex> lock (mutex);
-	auto count (0);
-	for (auto i (peers.get <5> ().begin ()), n (peers.get <5> ().end ()); i != n && count < 8; ++i, ++count)
+	requests.reserve (peers.size ());
+	for (size_t i (0), n (peers.size ()); i < n; ++i)
 	{
-		result.push_back (i->endpoint);
-	};
+		requests.push_back (std::make_pair (peers [i].last_rep_request, i));
+	}
+	// Peers asked longest ago
+	auto count (std::min (peers_per_crawl, requests.size ()));
+	std::partial_sort (requests.begin (), requests.begin () + count, requests.end ());
+	for (auto i (requests.begin ()), n (requests.begin () + count); i != n; ++i)
+	{
+		result.push_back (peers [i->second].endpoint);
+	}
 	return result;
 }
 
@@ -2451,33 +3772,31 @@ bool rai::peer_container::not_a_peer (rai::endpoint const & endpoint_a)
 bool rai::peer_container::rep_response (rai::endpoint const & endpoint_a, rai::amount const & weight_a)
 {
 	auto updated (false);
+	auto hash (std::hash <rai::endpoint> () (endpoint_a));
     std::lock_guard <std::mutex> lock (mutex);
-    auto existing (peers.find (endpoint_a));
-    if (existing != peers.end ())
+    auto existing (find (endpoint_a, hash));
+    if (existing != peers.size ())
     {
-		peers.modify (existing, [weight_a, &updated] (rai::peer_information & info)
+		auto & info (peers [existing]);
+		info.last_rep_response = std::chrono::system_clock::now ();
+		if (info.rep_weight < weight_a)
 		{
-			info.last_rep_response = std::chrono::system_clock::now ();
-			if (info.rep_weight < weight_a)
-			{
-				updated = true;
-				info.rep_weight = weight_a;
-			}
-		});
+			updated = true;
+			info.rep_weight = weight_a;
+			representatives_stale = true;
+		}
     }
 	return updated;
 }
 
 void rai::peer_container::rep_request (rai::endpoint const & endpoint_a)
 {
+	auto hash (std::hash <rai::endpoint> () (endpoint_a));
     std::lock_guard <std::mutex> lock (mutex);
-    auto existing (peers.find (endpoint_a));
-    if (existing != peers.end ())
+    auto existing (find (endpoint_a, hash));
+    if (existing != peers.size ())
     {
-		peers.modify (existing, [] (rai::peer_information & info)
-		{
-			info.last_rep_request = std::chrono::system_clock::now ();
-		});
+		peers [existing].last_rep_request = std::chrono::system_clock::now ();
     }
 }
 
@@ -2487,19 +3806,20 @@ bool rai::peer_container::insert (rai::endpoint const & endpoint_a, unsigned ver
     auto result (not_a_peer (endpoint_a));
     if (!result)
     {
+		// Hash outside the lock, every inbound packet comes through here
+		auto hash (std::hash <rai::endpoint> () (endpoint_a));
+		auto now (std::chrono::system_clock::now ());
         std::lock_guard <std::mutex> lock (mutex);
-        auto existing (peers.find (endpoint_a));
-        if (existing != peers.end ())
+        auto existing (find (endpoint_a, hash));
+        if (existing != peers.size ())
         {
-            peers.modify (existing, [] (rai::peer_information & info)
-            {
-                info.last_contact = std::chrono::system_clock::now ();
-            });
+			peers [existing].last_contact = now;
             result = true;
         }
         else
         {
-            peers.insert (rai::peer_information (endpoint_a, version_a));
+            peers.push_back (rai::peer_information (endpoint_a, version_a));
+			index (hash);
 			unknown = true;
         }
     }
@@ -2510,6 +3830,77 @@ bool rai::peer_container::insert (rai::endpoint const & endpoint_a, unsigned ver
     return result;
 }
 
+bool rai::peer_container::insert (rai::peer_information const & peer_a)
+{
+	auto hash (std::hash <rai::endpoint> () (peer_a.endpoint));
+	std::lock_guard <std::mutex> lock (mutex);
+	auto result (find (peer_a.endpoint, hash) != peers.size ());
+	if (!result)
+	{
+		peers.push_back (peer_a);
+		index (hash);
+		representatives_stale = representatives_stale || !peer_a.rep_weight.is_zero ();
+	}
+	return result;
+}
+
+size_t rai::peer_container::find (rai::endpoint const & endpoint_a, size_t hash_a)
+{
+	auto result (peers.size ());
+	if (!slots.empty ())
+	{
+		auto mask (slots.size () - 1);
+		for (auto i (hash_a & mask); result == peers.size () && slots [i] != empty_slot; i = (i + 1) & mask)
+		{
+			if (peers [slots [i]].endpoint == endpoint_a)
+			{
+				result = slots [i];
+			}
+		}
+	}
+	return result;
+}
+
+void rai::peer_container::index (size_t hash_a)
+{
+	assert (!peers.empty ());
+	// Keep the load factor at or below one half so probe sequences stay short
+	if (peers.size () * 2 > slots.size ())
+	{
+		rehash ();
+	}
+	else
+	{
+		auto mask (slots.size () - 1);
+		auto i (hash_a & mask);
+		while (slots [i] != empty_slot)
+		{
+			i = (i + 1) & mask;
+		}
+		slots [i] = peers.size () - 1;
+	}
+}
+
+void rai::peer_container::rehash ()
+{
+	size_t capacity (16);
+	while (capacity < peers.size () * 2)
+	{
+		capacity *= 2;
+	}
+	slots.assign (capacity, empty_slot);
+	auto mask (capacity - 1);
+	for (size_t position (0), n (peers.size ()); position < n; ++position)
+	{
+		auto i (std::hash <rai::endpoint> () (peers [position].endpoint) & mask);
+		while (slots [i] != empty_slot)
+		{
+			i = (i + 1) & mask;
+		}
+		slots [i] = position;
+	}
+}
+
 namespace {
 boost::asio::ip::address_v6 mapped_from_v4_bytes (unsigned long address_a)
 {
@@ -2558,117 +3949,547 @@ bool rai::reserved_address (rai::endpoint const & endpoint_a)
 	{
 		result = true;
 	}
-	else if (bytes >= ipv4_multicast_min && bytes <= ipv4_multicast_max)
+	else if (bytes >= ipv4_multicast_min && bytes <= ipv4_multicast_max)
+	{
+		result = true;
+	}
+	else if (bytes >= rfc6890_min && bytes <= rfc6890_max)
+	{
+		result = true;
+	}
+	else if (bytes >= rfc6666_min && bytes <= rfc6666_max)
+	{
+		result = true;
+	}
+	else if (bytes >= rfc3849_min && bytes <= rfc3849_max)
+	{
+		result = true;
+	}
+	else if (bytes >= ipv6_multicast_min && bytes <= ipv6_multicast_max)
+	{
+		result = true;
+	}
+	else if (bytes.is_loopback () && rai::rai_network != rai::rai_networks::rai_test_network)
+	{
+		result = true;
+	}
+	else if (bytes >= ipv4_loopback_min && bytes <= ipv4_loopback_max && rai::rai_network != rai::rai_networks::rai_test_network)
+	{
+		result = true;
+	}
+	return result;
+}
+
+rai::peer_information::peer_information (rai::endpoint const & endpoint_a, unsigned network_version_a) :
+endpoint (endpoint_a),
+last_contact (std::chrono::system_clock::now ()),
+last_attempt (last_contact),
+last_bootstrap_attempt (std::chrono::system_clock::time_point ()),
+last_rep_request (std::chrono::system_clock::time_point ()),
+last_rep_response (std::chrono::system_clock::time_point ()),
+rep_weight (0),
+network_version (network_version_a)
+{
+}
+
+rai::peer_information::peer_information (rai::endpoint const & endpoint_a, std::chrono::system_clock::time_point const & last_contact_a, std::chrono::system_clock::time_point const & last_attempt_a) :
+endpoint (endpoint_a),
+last_contact (last_contact_a),
+last_attempt (last_attempt_a),
+last_bootstrap_attempt (std::chrono::system_clock::time_point ()),
+last_rep_request (std::chrono::system_clock::time_point ()),
+last_rep_response (std::chrono::system_clock::time_point ()),
+rep_weight (0),
+network_version (0)
+{
+}
+
+rai::peer_container::peer_container (rai::endpoint const & self_a) :
+self (self_a),
+peer_observer ([] (rai::endpoint const &) {}),
+disconnect_observer ([] () {}),
+representatives_stale (false)
+{
+}
+
+void rai::peer_container::contacted (rai::endpoint const & endpoint_a, unsigned version_a)
+{
+    auto endpoint_l (endpoint_a);
+    if (endpoint_l.address ().is_v4 ())
+    {
+        endpoint_l = rai::endpoint (boost::asio::ip::address_v6::v4_mapped (endpoint_l.address ().to_v4 ()), endpoint_l.port ());
+    }
+    assert (endpoint_l.address ().is_v6 ());
+	insert (endpoint_l, version_a);
+}
+
+std::ostream & operator << (std::ostream & stream_a, std::chrono::system_clock::time_point const & time_a)
+{
+    time_t last_contact (std::chrono::system_clock::to_time_t (time_a));
+    std::string string (ctime (&last_contact));
+    string.pop_back ();
+    stream_a << string;
+    return stream_a;
+}
+
+void rai::network::send_buffer (uint8_t const * data_a, size_t size_a, rai::endpoint const & endpoint_a, std::function <void (boost::system::error_code const &, size_t)> callback_a)
+{
+	std::unique_lock <std::mutex> lock (socket_mutex);
+	if (node.config.logging.network_packet_logging ())
+	{
+		BOOST_LOG (node.log) << "Sending packet";
+	}
+	socket.async_send_to (boost::asio::buffer (data_a, size_a), endpoint_a, [this, callback_a] (boost::system::error_code const & ec, size_t size_a)
+	{
+		callback_a (ec, size_a);
+		if (this->node.config.logging.network_packet_logging ())
+		{
+			BOOST_LOG (this->node.log) << "Packet send complete";
+		}
+	});
+}
+
+void rai::network::send_buffer_many (std::shared_ptr <std::vector <uint8_t>> buffer_a, std::vector <rai::endpoint> const & endpoints_a, std::function <void (boost::system::error_code const &, rai::endpoint const &)> callback_a)
+{
+	size_t sent (0);
+#if defined (__linux__)
+	if (batching)
+	{
+		std::lock_guard <std::mutex> lock (socket_mutex);
+		std::array <mmsghdr, batch_size> messages;
+		iovec vector;
+		vector.iov_base = buffer_a->data ();
+		vector.iov_len = buffer_a->size ();
+		auto done (false);
+		while (!done && sent < endpoints_a.size ())
+		{
+			auto count (std::min (batch_size, endpoints_a.size () - sent));
+			for (size_t i (0); i < count; ++i)
+			{
+				auto & endpoint (endpoints_a [sent + i]);
+				messages [i].msg_hdr = msghdr ();
+				messages [i].msg_hdr.msg_name = const_cast <sockaddr *> (endpoint.data ());
+				messages [i].msg_hdr.msg_namelen = endpoint.size ();
+				messages [i].msg_hdr.msg_iov = &vector;
+				messages [i].msg_hdr.msg_iovlen = 1;
+			}
+			auto result (sendmmsg (socket.native_handle (), messages.data (), count, MSG_DONTWAIT));
+			if (result > 0)
+			{
+				++send_batches;
+				sent += result;
+			}
+			else
+			{
+				// The send buffer is full or the first datagram failed, the rest go out asynchronously and report their own errors
+				done = true;
+			}
+		}
+	}
+	if (sent != 0 && node.config.logging.network_packet_logging ())
+	{
+		BOOST_LOG (node.log) << boost::str (boost::format ("Sent %1% packets in batches") % sent);
+	}
+#endif
+	for (auto i (sent), n (endpoints_a.size ()); i < n; ++i)
+	{
+		auto endpoint (endpoints_a [i]);
+		send_buffer (buffer_a->data (), buffer_a->size (), endpoint, [buffer_a, callback_a, endpoint] (boost::system::error_code const & ec, size_t)
+		{
+			if (ec)
+			{
+				callback_a (ec, endpoint);
+			}
+		});
+	}
+}
+
+void rai::network::send (std::shared_ptr <std::vector <uint8_t>> buffer_a, std::vector <rai::endpoint> const & endpoints_a, rai::send_priority priority_a, std::function <void (boost::system::error_code const &, rai::endpoint const &)> callback_a)
+{
+	send_queue.add (buffer_a, endpoints_a, priority_a, callback_a);
+}
+
+rai::token_bucket::token_bucket (size_t rate_a) :
+rate (rate_a),
+tokens (rate_a),
+last (std::chrono::steady_clock::now ())
+{
+}
+
+void rai::token_bucket::refill (std::chrono::steady_clock::time_point const & now_a)
+{
+	if (now_a > last)
+	{
+		auto elapsed (std::chrono::duration_cast <std::chrono::duration <double>> (now_a - last).count ());
+		tokens = std::min <double> (rate, tokens + elapsed * rate);
+		last = now_a;
+	}
+}
+
+bool rai::token_bucket::try_consume (size_t size_a, std::chrono::steady_clock::time_point const & now_a)
+{
+	auto result (rate == 0);
+	if (!result)
+	{
+		refill (now_a);
+		// A packet larger than the whole bucket still goes out once the bucket is full
+		result = tokens >= std::min <double> (size_a, rate);
+		if (result)
+		{
+			tokens -= size_a;
+		}
+	}
+	return result;
+}
+
+bool rai::token_bucket::full (std::chrono::steady_clock::time_point const & now_a)
+{
+	refill (now_a);
+	return tokens >= rate;
+}
+
+rai::send_queue::send_queue (rai::network & network_a) :
+network (network_a),
+queued_bytes (0),
+dropped_bytes (0),
+coalesced (0),
+bucket (network_a.node.config.bandwidth_limit),
+bytes (0),
+drain_scheduled (false)
+{
+}
+
+bool rai::send_queue::consume_peer (rai::endpoint const & endpoint_a, size_t size_a, std::chrono::steady_clock::time_point const & now_a)
+{
+	auto result (true);
+	auto limit (network.node.config.peer_bandwidth_limit);
+	if (limit != 0)
+	{
+		auto existing (peer_buckets.find (endpoint_a));
+		if (existing == peer_buckets.end ())
+		{
+			if (peer_buckets.size () >= max_peer_buckets)
+			{
+				// A full bucket is the same as a new one, forget those peers
+				for (auto i (peer_buckets.begin ()), n (peer_buckets.end ()); i != n;)
+				{
+					if (i->second.full (now_a))
+					{
+						i = peer_buckets.erase (i);
+					}
+					else
+					{
+						++i;
+					}
+				}
+			}
+			existing = peer_buckets.insert (std::make_pair (endpoint_a, rai::token_bucket (limit))).first;
+		}
+		result = existing->second.try_consume (size_a, now_a);
+	}
+	return result;
+}
+
+bool rai::send_queue::consume (rai::endpoint const & endpoint_a, size_t size_a, std::chrono::steady_clock::time_point const & now_a)
+{
+	auto result (bucket.try_consume (size_a, now_a));
+	if (result)
 	{
-		result = true;
+		result = consume_peer (endpoint_a, size_a, now_a);
+		if (!result && bucket.rate != 0)
+		{
+			// Only this peer is over its limit, give the bandwidth back to everyone else
+			bucket.tokens += size_a;
+		}
 	}
-	else if (bytes >= rfc6890_min && bytes <= rfc6890_max)
+	return result;
+}
+
+void rai::send_queue::add (std::shared_ptr <std::vector <uint8_t>> buffer_a, std::vector <rai::endpoint> const & endpoints_a, rai::send_priority priority_a, std::function <void (boost::system::error_code const &, rai::endpoint const &)> callback_a)
+{
+	std::vector <rai::send_queue_item> ready;
+	std::vector <rai::send_queue_item> dropped;
+	std::vector <rai::endpoint> coalesced_l;
 	{
-		result = true;
+		std::lock_guard <std::mutex> lock (mutex);
+		auto now (std::chrono::steady_clock::now ());
+		auto index (static_cast <size_t> (priority_a));
+		auto size (buffer_a->size ());
+		auto hashed (false);
+		uint64_t digest (0);
+		for (auto & i : endpoints_a)
+		{
+			// Packets can't overtake anything already waiting for the same peer at the same or a higher priority
+			auto behind (false);
+			auto existing (waiting.find (i));
+			if (existing != waiting.end ())
+			{
+				for (size_t j (0); j <= index && !behind; ++j)
+				{
+					behind = existing->second [j] != 0;
+				}
+			}
+			if (!behind && consume (i, size, now))
+			{
+				ready.push_back (rai::send_queue_item ({buffer_a, i, callback_a, 0}));
+			}
+			else
+			{
+				if (!hashed)
+				{
+					digest = XXH64 (buffer_a->data (), size, 0);
+					hashed = true;
+				}
+				if (keys.insert (std::make_pair (digest, i)).second)
+				{
+					queues [index].push_back (rai::send_queue_item ({buffer_a, i, callback_a, digest}));
+					++waiting [i] [index];
+					bytes += size;
+					queued_bytes += size;
+				}
+				else
+				{
+					++coalesced;
+					coalesced_l.push_back (i);
+				}
+			}
+		}
+		evict (dropped);
+		schedule_drain ();
 	}
-	else if (bytes >= rfc6666_min && bytes <= rfc6666_max)
+	send (ready);
+	for (auto & i : coalesced_l)
 	{
-		result = true;
+		callback_a (boost::system::error_code (), i);
 	}
-	else if (bytes >= rfc3849_min && bytes <= rfc3849_max)
+	for (auto & i : dropped)
 	{
-		result = true;
+		i.callback (boost::system::errc::make_error_code (boost::system::errc::no_buffer_space), i.endpoint);
 	}
-	else if (bytes >= ipv6_multicast_min && bytes <= ipv6_multicast_max)
+}
+
+void rai::send_queue::remove (rai::send_queue_item const & item_a, size_t index_a)
+{
+	bytes -= item_a.buffer->size ();
+	keys.erase (std::make_pair (item_a.key, item_a.endpoint));
+	auto existing (waiting.find (item_a.endpoint));
+	assert (existing != waiting.end ());
+	auto & counts (existing->second);
+	assert (counts [index_a] > 0);
+	--counts [index_a];
+	if (std::all_of (counts.begin (), counts.end (), [] (size_t count_a) { return count_a == 0; }))
 	{
-		result = true;
+		waiting.erase (existing);
 	}
-	else if (bytes.is_loopback () && rai::rai_network != rai::rai_networks::rai_test_network)
+}
+
+void rai::send_queue::evict (std::vector <rai::send_queue_item> & dropped_a)
+{
+	for (auto i (queues.rbegin ()), n (queues.rend ()); i != n && bytes > max_queued_bytes; ++i)
 	{
-		result = true;
+		auto index (static_cast <size_t> (n - i - 1));
+		while (!i->empty () && bytes > max_queued_bytes)
+		{
+			auto & item (i->front ());
+			remove (item, index);
+			dropped_bytes += item.buffer->size ();
+			dropped_a.push_back (std::move (item));
+			i->pop_front ();
+		}
 	}
-	else if (bytes >= ipv4_loopback_min && bytes <= ipv4_loopback_max && rai::rai_network != rai::rai_networks::rai_test_network)
+}
+
+void rai::send_queue::drain ()
+{
+	std::vector <rai::send_queue_item> ready;
 	{
-		result = true;
+		std::lock_guard <std::mutex> lock (mutex);
+		drain_scheduled = false;
+		auto now (std::chrono::steady_clock::now ());
+		auto done (false);
+		for (auto i (queues.begin ()), n (queues.end ()); i != n && !done; ++i)
+		{
+			auto index (static_cast <size_t> (i - queues.begin ()));
+			std::deque <rai::send_queue_item> remaining;
+			for (auto & item : *i)
+			{
+				auto size (item.buffer->size ());
+				// Running out of global bandwidth ends the pass, a throttled peer only holds back its own packets
+				done = done || !bucket.try_consume (size, now);
+				if (!done && consume_peer (item.endpoint, size, now))
+				{
+					remove (item, index);
+					ready.push_back (std::move (item));
+				}
+				else
+				{
+					if (!done && bucket.rate != 0)
+					{
+						bucket.tokens += size;
+					}
+					remaining.push_back (std::move (item));
+				}
+			}
+			i->swap (remaining);
+		}
+		schedule_drain ();
 	}
-	return result;
+	send (ready);
 }
 
-rai::peer_information::peer_information (rai::endpoint const & endpoint_a, unsigned network_version_a) :
-endpoint (endpoint_a),
-last_contact (std::chrono::system_clock::now ()),
-last_attempt (last_contact),
-last_bootstrap_attempt (std::chrono::system_clock::time_point ()),
-last_rep_request (std::chrono::system_clock::time_point ()),
-last_rep_response (std::chrono::system_clock::time_point ()),
-rep_weight (0),
-network_version (network_version_a)
+void rai::send_queue::schedule_drain ()
 {
+	if (!drain_scheduled && bytes > 0)
+	{
+		drain_scheduled = true;
+		std::weak_ptr <rai::node> node_w (network.node.shared ());
+		network.node.alarm.add (std::chrono::system_clock::now () + drain_interval, [node_w] ()
+		{
+			if (auto node_l = node_w.lock ())
+			{
+				node_l->network.send_queue.drain ();
+			}
+		});
+	}
 }
 
-rai::peer_information::peer_information (rai::endpoint const & endpoint_a, std::chrono::system_clock::time_point const & last_contact_a, std::chrono::system_clock::time_point const & last_attempt_a) :
-endpoint (endpoint_a),
-last_contact (last_contact_a),
-last_attempt (last_attempt_a),
-last_bootstrap_attempt (std::chrono::system_clock::time_point ()),
-last_rep_request (std::chrono::system_clock::time_point ()),
-last_rep_response (std::chrono::system_clock::time_point ()),
-rep_weight (0)
+void rai::send_queue::send (std::vector <rai::send_queue_item> & items_a)
 {
+	// Endpoints sharing a buffer were queued together, send them as one batch
+	for (auto i (items_a.begin ()), n (items_a.end ()); i != n;)
+	{
+		auto buffer (i->buffer);
+		auto callback (i->callback);
+		std::vector <rai::endpoint> endpoints;
+		for (; i != n && i->buffer == buffer; ++i)
+		{
+			endpoints.push_back (i->endpoint);
+		}
+		if (endpoints.size () == 1)
+		{
+			auto endpoint (endpoints [0]);
+			network.send_buffer (buffer->data (), buffer->size (), endpoint, [buffer, callback, endpoint] (boost::system::error_code const & ec, size_t)
+			{
+				if (ec)
+				{
+					callback (ec, endpoint);
+				}
+			});
+		}
+		else
+		{
+			network.send_buffer_many (buffer, endpoints, callback);
+		}
+	}
 }
 
-rai::peer_container::peer_container (rai::endpoint const & self_a) :
-self (self_a),
-peer_observer ([] (rai::endpoint const &) {}),
-disconnect_observer ([] () {})
+size_t rai::send_queue::size ()
 {
+	std::lock_guard <std::mutex> lock (mutex);
+	return bytes;
 }
 
-void rai::peer_container::contacted (rai::endpoint const & endpoint_a, unsigned version_a)
+uint64_t rai::block_store::now ()
 {
-    auto endpoint_l (endpoint_a);
-    if (endpoint_l.address ().is_v4 ())
-    {
-        endpoint_l = rai::endpoint (boost::asio::ip::address_v6::v4_mapped (endpoint_l.address ().to_v4 ()), endpoint_l.port ());
-    }
-    assert (endpoint_l.address ().is_v6 ());
-	insert (endpoint_l, version_a);
+    boost::posix_time::ptime epoch (boost::gregorian::date (1970, 1, 1));
+    auto now (boost::posix_time::second_clock::universal_time ());
+    auto diff (now - epoch);
+    return diff.total_seconds ();
 }
 
-std::ostream & operator << (std::ostream & stream_a, std::chrono::system_clock::time_point const & time_a)
+bool rai::peer_container::known_peer (rai::endpoint const & endpoint_a)
 {
-    time_t last_contact (std::chrono::system_clock::to_time_t (time_a));
-    std::string string (ctime (&last_contact));
-    string.pop_back ();
-    stream_a << string;
-    return stream_a;
+	auto hash (std::hash <rai::endpoint> () (endpoint_a));
+	auto cutoff (std::chrono::system_clock::now () - rai::node::cutoff);
+    std::lock_guard <std::mutex> lock (mutex);
+    auto existing (find (endpoint_a, hash));
+    return existing != peers.size () && peers [existing].last_contact > cutoff;
 }
 
-void rai::network::send_buffer (uint8_t const * data_a, size_t size_a, rai::endpoint const & endpoint_a, std::function <void (boost::system::error_code const &, size_t)> callback_a)
+rai::peer_cache::peer_cache (bool & error_a, rai::block_store & store_a) :
+store (store_a),
+handle (0)
 {
-	std::unique_lock <std::mutex> lock (socket_mutex);
-	if (node.config.logging.network_packet_logging ())
+	if (!error_a)
 	{
-		BOOST_LOG (node.log) << "Sending packet";
+		rai::transaction transaction (store.environment, nullptr, true);
+		error_a |= mdb_dbi_open (transaction, "peers", MDB_CREATE, &handle) != 0;
 	}
-	socket.async_send_to (boost::asio::buffer (data_a, size_a), endpoint_a, [this, callback_a] (boost::system::error_code const & ec, size_t size_a)
+}
+
+void rai::peer_cache::save (MDB_txn * transaction_a, std::vector <rai::peer_information> const & peers_a)
+{
+	auto status (mdb_drop (transaction_a, handle, 0));
+	assert (status == 0);
+	std::lock_guard <std::mutex> lock (mutex);
+	for (auto & i : peers_a)
 	{
-		callback_a (ec, size_a);
-		if (this->node.config.logging.network_packet_logging ())
+		auto last_contact (i.last_contact);
+		auto existing (restored_contacts.find (i.endpoint));
+		if (existing != restored_contacts.end ())
 		{
-			BOOST_LOG (this->node.log) << "Packet send complete";
+			if (last_contact == existing->second.second)
+			{
+				// Not heard from since the restart
+				last_contact = existing->second.first;
+			}
+			else
+			{
+				restored_contacts.erase (existing);
+			}
 		}
-	});
+		// Address bytes followed by the port in network order
+		std::array <uint8_t, 18> key;
+		auto address (i.endpoint.address ().to_v6 ().to_bytes ());
+		std::copy (address.begin (), address.end (), key.begin ());
+		key [16] = i.endpoint.port () >> 8;
+		key [17] = i.endpoint.port () & 0xff;
+		std::vector <uint8_t> value;
+		{
+			rai::vectorstream stream (value);
+			rai::write (stream, static_cast <uint8_t> (i.network_version));
+			rai::write (stream, i.rep_weight);
+			rai::write (stream, static_cast <uint64_t> (std::chrono::system_clock::to_time_t (last_contact)));
+		}
+		auto status (mdb_put (transaction_a, handle, rai::mdb_val (key.size (), key.data ()), rai::mdb_val (value.size (), value.data ()), 0));
+		assert (status == 0);
+	}
 }
 
-uint64_t rai::block_store::now ()
+void rai::peer_cache::restored (rai::endpoint const & endpoint_a, std::chrono::system_clock::time_point const & saved_a, std::chrono::system_clock::time_point const & restored_a)
 {
-    boost::posix_time::ptime epoch (boost::gregorian::date (1970, 1, 1));
-    auto now (boost::posix_time::second_clock::universal_time ());
-    auto diff (now - epoch);
-    return diff.total_seconds ();
+	std::lock_guard <std::mutex> lock (mutex);
+	restored_contacts [endpoint_a] = std::make_pair (saved_a, restored_a);
 }
 
-bool rai::peer_container::known_peer (rai::endpoint const & endpoint_a)
+std::vector <rai::peer_information> rai::peer_cache::load (MDB_txn * transaction_a)
 {
-    std::lock_guard <std::mutex> lock (mutex);
-    auto existing (peers.find (endpoint_a));
-    return existing != peers.end () && existing->last_contact > std::chrono::system_clock::now () - rai::node::cutoff;
+	std::vector <rai::peer_information> result;
+	for (rai::store_iterator i (transaction_a, handle), n (nullptr); i != n; ++i)
+	{
+		if (i->first.size () == 18)
+		{
+			auto key (reinterpret_cast <uint8_t const *> (i->first.data ()));
+			boost::asio::ip::address_v6::bytes_type address;
+			std::copy (key, key + address.size (), address.begin ());
+			uint16_t port ((key [16] << 8) | key [17]);
+			uint8_t network_version;
+			rai::amount rep_weight;
+			uint64_t last_contact;
+			rai::bufferstream stream (reinterpret_cast <uint8_t const *> (i->second.data ()), i->second.size ());
+			auto error (rai::read (stream, network_version));
+			error = error || rai::read (stream, rep_weight);
+			error = error || rai::read (stream, last_contact);
+			if (!error)
+			{
+				rai::peer_information peer (rai::endpoint (boost::asio::ip::address_v6 (address), port), std::chrono::system_clock::from_time_t (last_contact), std::chrono::system_clock::time_point ());
+				peer.network_version = network_version;
+				peer.rep_weight = rep_weight;
+				result.push_back (peer);
+			}
+		}
+	}
+	return result;
 }
 
 std::shared_ptr <rai::node> rai::node::shared ()
@@ -2690,6 +4511,7 @@ last_winner (block_a)
 
 void rai::election::compute_rep_votes (MDB_txn * transaction_a)
 {
+	std::lock_guard <std::mutex> lock (mutex);
 	node.wallets.foreach_representative (transaction_a, [this, transaction_a] (rai::public_key const & pub_a, rai::raw_key const & prv_a)
 	{
 		auto vote (this->node.store.vote_generate (transaction_a, pub_a, prv_a, last_winner));
@@ -2699,37 +4521,41 @@ void rai::election::compute_rep_votes (MDB_txn * transaction_a)
 
 void rai::election::broadcast_winner ()
 {
+	// Generated vote sequence numbers are held in the store's vote cache and persisted by the periodic store flush, a read transaction is sufficient
+	rai::transaction transaction (node.store.environment, nullptr, false);
+	compute_rep_votes (transaction);
+	std::shared_ptr <rai::block> winner_l;
 	{
-		rai::transaction transaction (node.store.environment, nullptr, true);
-		compute_rep_votes (transaction);
+		std::lock_guard <std::mutex> lock (mutex);
+		winner_l = last_winner;
 	}
-	rai::transaction transaction_a (node.store.environment, nullptr, false);
-	node.network.republish_block (transaction_a, last_winner);
+	node.network.republish_block (transaction, winner_l);
 }
 
-rai::uint128_t rai::election::quorum_threshold (MDB_txn * transaction_a, rai::ledger & ledger_a)
+rai::uint128_t rai::election::quorum_threshold (rai::weight_snapshot const & weights_a)
 {
 	// Threshold over which unanimous voting implies confirmation
-    return ledger_a.supply (transaction_a) / 2;
+    return weights_a.supply / 2;
 }
 
-rai::uint128_t rai::election::minimum_treshold (MDB_txn * transaction_a, rai::ledger & ledger_a)
+rai::uint128_t rai::election::minimum_treshold (rai::weight_snapshot const & weights_a)
 {
 	// Minimum number of votes needed to change our ledger, underwhich we're probably disconnected
-	return ledger_a.supply (transaction_a) / 16;
+	return weights_a.supply / 16;
 }
 
-void rai::election::confirm_once (MDB_txn * transaction_a)
+void rai::election::confirm_once (rai::weight_snapshot const & weights_a)
 {
+	assert (!mutex.try_lock ());
 	if (!confirmed.test_and_set ())
 	{
-		auto tally_l (node.ledger.tally (transaction_a, votes));
+		auto tally_l (node.ledger.tally (weights_a, votes));
 		assert (tally_l.size () > 0);
 		auto winner (tally_l.begin ());
 		auto block_l (winner->second);
 		if (!(*block_l == *last_winner))
 		{
-			if (winner->first > minimum_treshold (transaction_a, node.ledger))
+			if (winner->first > minimum_treshold (weights_a))
 			{
 				auto node_l (node.shared ());
 				node.background ([node_l, block_l] ()
@@ -2754,25 +4580,26 @@ void rai::election::confirm_once (MDB_txn * transaction_a)
 	}
 }
 
-bool rai::election::have_quorum (MDB_txn * transaction_a)
+bool rai::election::have_quorum (rai::weight_snapshot const & weights_a)
 {
-	auto tally_l (node.ledger.tally (transaction_a, votes));
+	auto tally_l (node.ledger.tally (weights_a, votes));
 	assert (tally_l.size () > 0);
-	auto result (tally_l.begin ()->first > quorum_threshold (transaction_a, node.ledger));
+	auto result (tally_l.begin ()->first > quorum_threshold (weights_a));
 	return result;
 }
 
-void rai::election::confirm_if_quarum (MDB_txn * transaction_a)
+void rai::election::confirm_if_quarum (rai::weight_snapshot const & weights_a)
 {
-	auto quarum (have_quorum (transaction_a));
+	auto quarum (have_quorum (weights_a));
 	if (quarum)
 	{
-		confirm_once (transaction_a);
+		confirm_once (weights_a);
 	}
 }
 
-void rai::election::confirm_cutoff (MDB_txn * transaction_a)
+void rai::election::confirm_cutoff (rai::weight_snapshot const & weights_a)
 {
+	std::lock_guard <std::mutex> lock (mutex);
 	if (node.config.logging.vote_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Vote tally weight %2% for root %1%") % votes.id.to_string () % last_winner->root ().to_string ());
@@ -2781,23 +4608,65 @@ void rai::election::confirm_cutoff (MDB_txn * transaction_a)
 			BOOST_LOG (node.log) << boost::str (boost::format ("%1% %2%") % i->first.to_account () % i->second->hash ().to_string ());
 		}
 	}
-	confirm_once (transaction_a);
+	confirm_once (weights_a);
 }
 
 void rai::election::vote (std::shared_ptr <rai::vote> vote_a)
 {
-	node.network.republish_vote (last_vote, vote_a);
-	last_vote = std::chrono::system_clock::now ();
-	rai::transaction transaction (node.store.environment, nullptr, true);
-	assert (node.store.vote_validate (transaction, vote_a).code != rai::vote_code::invalid);
+	std::chrono::system_clock::time_point last_vote_l;
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		last_vote_l = last_vote;
+		last_vote = std::chrono::system_clock::now ();
+	}
+	node.network.republish_vote (last_vote_l, vote_a);
+	// Votes reaching here have been validated by the vote processor, tally them against the in-memory weights without touching the store
+	auto weights_l (node.active.weights ());
+	std::lock_guard <std::mutex> lock (mutex);
 	votes.vote (vote_a);
-	confirm_if_quarum (transaction);
+	confirm_if_quarum (*weights_l);
+}
+
+std::shared_ptr <rai::weight_snapshot> rai::active_transactions::weights ()
+{
+	std::shared_ptr <rai::weight_snapshot> result;
+	{
+		std::lock_guard <std::mutex> lock (weights_mutex);
+		result = snapshot;
+	}
+	if (result == nullptr)
+	{
+		update_weights ();
+		std::lock_guard <std::mutex> lock (weights_mutex);
+		result = snapshot;
+	}
+	// Supply only changes at the announcement interval but weights are published by the store as soon as a block commits
+	auto current (node.store.rep_weights.snapshot ());
+	if (current != result->weights)
+	{
+		auto updated (std::make_shared <rai::weight_snapshot> (*result));
+		updated->weights = current;
+		result = updated;
+	}
+	return result;
+}
+
+void rai::active_transactions::update_weights ()
+{
+	std::shared_ptr <rai::weight_snapshot> weights_l;
+	{
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		weights_l = node.ledger.weights (transaction);
+	}
+	std::lock_guard <std::mutex> lock (weights_mutex);
+	snapshot = weights_l;
 }
 
 void rai::active_transactions::announce_votes ()
 {
 	std::vector <rai::block_hash> inactive;
-	rai::transaction transaction (node.store.environment, nullptr, true);
+	update_weights ();
+	auto weights_l (weights ());
 	std::lock_guard <std::mutex> lock (mutex);
 	size_t announcements (0);
 	{
@@ -2811,7 +4680,7 @@ void rai::active_transactions::announce_votes ()
 			if (i->announcements >= contigious_announcements - 1)
 			{
 				// These blocks have reached the confirmation interval for forks
-				i->election->confirm_cutoff (transaction);
+				i->election->confirm_cutoff (*weights_l);
 				auto root_l (i->election->votes.id);
 				inactive.push_back (root_l);
 			}
@@ -2823,7 +4692,12 @@ void rai::active_transactions::announce_votes ()
 					announcements = ++info_a.announcements;
 				});
 				// If more than one full announcement interval has passed and no one has voted on this block, we need to synchronize
-				if (announcements > 1 && i->election->votes.rep_votes.size () <= 1)
+				size_t voters;
+				{
+					std::lock_guard <std::mutex> election_lock (i->election->mutex);
+					voters = i->election->votes.rep_votes.size ();
+				}
+				if (announcements > 1 && voters <= 1)
 				{
 					node.bootstrap_initiator.bootstrap ();
 				}
@@ -2949,6 +4823,8 @@ void rai::add_node_options (boost::program_options::options_description & descri
 	("diagnostics", "Run internal diagnostics")
 	("key_create", "Generates a adhoc random keypair and prints it to stdout")
 	("key_expand", "Derive public key and account number from <key>")
+	("snapshot_export", "Write a snapshot of the ledger to <file>")
+	("snapshot_import", "Load a ledger snapshot from <file> in to a node without a ledger")
 	("wallet_add_adhoc", "Insert <key> in to <wallet>")
 	("wallet_create", "Creates a new wallet and prints the ID")
 	("wallet_change_seed", "Changes seed for <wallet> to <key>")
@@ -3093,6 +4969,84 @@ bool rai::handle_node_options (boost::program_options::variables_map & vm)
 			result = true;
 		}
 	}
+	else if (vm.count ("snapshot_export"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			std::ofstream stream (vm ["file"].as <std::string> (), std::ios::binary);
+			if (!stream.fail ())
+			{
+				inactive_node node;
+				rai::transaction transaction (node.node->store.environment, nullptr, false);
+				auto start (std::chrono::steady_clock::now ());
+				if (!node.node->store.snapshot_export (transaction, stream))
+				{
+					auto elapsed (std::chrono::duration_cast <std::chrono::seconds> (std::chrono::steady_clock::now () - start));
+					std::cout << boost::str (boost::format ("Exported %1% blocks in %2% seconds\n") % node.node->store.block_count (transaction).sum () % elapsed.count ());
+				}
+				else
+				{
+					std::cerr << "Error writing snapshot\n";
+					result = true;
+				}
+			}
+			else
+			{
+				std::cerr << "Unable to open <file>\n";
+				result = true;
+			}
+		}
+		else
+		{
+			std::cerr << "snapshot_export requires one <file> option\n";
+			result = true;
+		}
+	}
+	else if (vm.count ("snapshot_import"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			std::ifstream stream (vm ["file"].as <std::string> (), std::ios::binary);
+			if (!stream.fail ())
+			{
+				// Open the store on its own, a node would put the genesis block in an empty ledger
+				auto path (rai::working_path ());
+				boost::filesystem::create_directories (path);
+				bool error (false);
+				rai::block_store store (error, path / "data.ldb");
+				if (!error)
+				{
+					auto start (std::chrono::steady_clock::now ());
+					if (!store.snapshot_import (stream))
+					{
+						auto elapsed (std::chrono::duration_cast <std::chrono::seconds> (std::chrono::steady_clock::now () - start));
+						rai::transaction transaction (store.environment, nullptr, false);
+						std::cout << boost::str (boost::format ("Imported %1% blocks in %2% seconds\n") % store.block_count (transaction).sum () % elapsed.count ());
+					}
+					else
+					{
+						std::cerr << "Snapshot is corrupt, from a different store version or the ledger isn't empty\n";
+						result = true;
+					}
+				}
+				else
+				{
+					std::cerr << "Unable to open ledger\n";
+					result = true;
+				}
+			}
+			else
+			{
+				std::cerr << "Unable to open <file>\n";
+				result = true;
+			}
+		}
+		else
+		{
+			std::cerr << "snapshot_import requires one <file> option\n";
+			result = true;
+		}
+	}
 	else if (vm.count ("wallet_add_adhoc"))
 	{
 		if (vm.count ("wallet") == 1 && vm.count ("key") == 1)
@@ -4,9 +4,12 @@
 #include <rai/node/bootstrap.hpp>
 #include <rai/node/wallet.hpp>
 
+#include <array>
+#include <unordered_map>
 #include <unordered_set>
 #include <memory>
 #include <queue>
+#include <set>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
@@ -40,27 +43,29 @@ class node;
 class election : public std::enable_shared_from_this <rai::election>
 {
 	std::function <void (std::shared_ptr <rai::block>)> confirmation_action;
-	void confirm_once (MDB_txn *);
+	void confirm_once (rai::weight_snapshot const &);
 public:
     election (MDB_txn *, rai::node &, std::shared_ptr <rai::block>, std::function <void (std::shared_ptr <rai::block>)> const &);
 	void vote (std::shared_ptr <rai::vote>);
 	// Check if we have vote quorum
-	bool have_quorum (MDB_txn *);
+	bool have_quorum (rai::weight_snapshot const &);
 	// Tell the network our view of the winner
 	void broadcast_winner ();
 	// Change our winner to agree with the network
 	void compute_rep_votes (MDB_txn *);
 	// Confirmation method 1, uncontested quarum
-	void confirm_if_quarum (MDB_txn *);
+	void confirm_if_quarum (rai::weight_snapshot const &);
 	// Confirmation method 2, settling time
-	void confirm_cutoff (MDB_txn *);
-    rai::uint128_t quorum_threshold (MDB_txn *, rai::ledger &);
-	rai::uint128_t minimum_treshold (MDB_txn *, rai::ledger &);
+	void confirm_cutoff (rai::weight_snapshot const &);
+    rai::uint128_t quorum_threshold (rai::weight_snapshot const &);
+	rai::uint128_t minimum_treshold (rai::weight_snapshot const &);
     rai::votes votes;
     rai::node & node;
     std::chrono::system_clock::time_point last_vote;
 	std::shared_ptr <rai::block> last_winner;
     std::atomic_flag confirmed;
+	// Guards votes, last_vote and last_winner, votes arrive concurrently from the vote processor threads
+	std::mutex mutex;
 };
 class conflict_info
 {
@@ -84,6 +89,9 @@ public:
 	bool active (rai::block const &);
 	void announce_votes ();
 	void stop ();
+	// Representative weights elections are tallied against, online supply is refreshed each announcement interval
+	std::shared_ptr <rai::weight_snapshot> weights ();
+	void update_weights ();
     boost::multi_index_container
 	<
 		rai::conflict_info,
@@ -94,6 +102,8 @@ public:
 	> roots;
     rai::node & node;
     std::mutex mutex;
+	std::mutex weights_mutex;
+	std::shared_ptr <rai::weight_snapshot> snapshot;
 	// Maximum number of conflicts to vote on per interval, lowest root hash first
 	static unsigned constexpr announcements_per_interval = 32;
 	// After this many successive vote announcements, block is confirmed
@@ -175,12 +185,16 @@ public:
 	bool known_peer (rai::endpoint const &);
 	// Notify of peer we received from
 	bool insert (rai::endpoint const &, unsigned);
+	// Insert a peer with its contact times as they are, returns true if the peer was already known
+	bool insert (rai::peer_information const &);
 	std::unordered_set <rai::endpoint> random_set (size_t);
 	void random_fill (std::array <rai::endpoint, 8> &);
 	// Request a list of the top known representatives
 	std::vector <peer_information> representatives (size_t);
 	// List of all peers
 	std::vector <rai::endpoint> list ();
+	// Copy of every peer with its contact times
+	std::vector <rai::peer_information> list_information ();
 	std::map <rai::endpoint, unsigned> list_version ();
 	// A list of random peers with size the square root of total peer count
 	std::vector <rai::endpoint> list_sqrt ();
@@ -196,25 +210,43 @@ public:
 	bool empty ();
 	std::mutex mutex;
 	rai::endpoint self;
-	boost::multi_index_container
-	<
-		peer_information,
-		boost::multi_index::indexed_by
-		<
-			boost::multi_index::hashed_unique <boost::multi_index::member <peer_information, rai::endpoint, &peer_information::endpoint>>,
-			boost::multi_index::ordered_non_unique <boost::multi_index::member <peer_information, std::chrono::system_clock::time_point, &peer_information::last_contact>>,
-			boost::multi_index::ordered_non_unique <boost::multi_index::member <peer_information, std::chrono::system_clock::time_point, &peer_information::last_attempt>, std::greater <std::chrono::system_clock::time_point>>,
-			boost::multi_index::random_access <>,
-			boost::multi_index::ordered_non_unique <boost::multi_index::member <peer_information, std::chrono::system_clock::time_point, &peer_information::last_bootstrap_attempt>>,
-			boost::multi_index::ordered_non_unique <boost::multi_index::member <peer_information, std::chrono::system_clock::time_point, &peer_information::last_rep_request>>,
-			boost::multi_index::ordered_non_unique <boost::multi_index::member <peer_information, rai::amount, &peer_information::rep_weight>, std::greater <rai::amount>>
-		>
-	> peers;
+	// Peers stored contiguously for random sampling and sweeps, positions change when peers are purged
+	std::vector <rai::peer_information> peers;
 	// Called when a new peer is observed
 	std::function <void (rai::endpoint const &)> peer_observer;
 	std::function <void ()> disconnect_observer;
 	// Number of peers to crawl for being a rep every period
 	static size_t constexpr peers_per_crawl = 8;
+private:
+	// Position of the endpoint in peers or peers.size () if it isn't known, mutex must be held
+	size_t find (rai::endpoint const &, size_t);
+	// Add the last peer to the index
+	void index (size_t);
+	void rehash ();
+	// Open addressed index from endpoint hash to position in peers using linear probing
+	std::vector <uint32_t> slots;
+	static uint32_t constexpr empty_slot = std::numeric_limits <uint32_t>::max ();
+	// Peers with weight ordered by descending weight, rebuilt after weights change or peers are purged
+	std::vector <rai::peer_information> representatives_cache;
+	bool representatives_stale;
+};
+// Peers saved in the store so a restarted node can contact them straight away
+class peer_cache
+{
+public:
+	peer_cache (bool &, rai::block_store &);
+	// Replace the saved peers
+	void save (MDB_txn *, std::vector <rai::peer_information> const &);
+	std::vector <rai::peer_information> load (MDB_txn *);
+	// Remember the saved contact time of a peer put back in the container with a fresh one so it's saved unchanged until the peer answers
+	void restored (rai::endpoint const &, std::chrono::system_clock::time_point const &, std::chrono::system_clock::time_point const &);
+	rai::block_store & store;
+	// endpoint -> network_version, rep_weight, last_contact
+	MDB_dbi handle;
+private:
+	// Restored endpoint -> saved contact time, contact time given on restore
+	std::unordered_map <rai::endpoint, std::pair <std::chrono::system_clock::time_point, std::chrono::system_clock::time_point>> restored_contacts;
+	std::mutex mutex;
 };
 class send_info
 {
@@ -292,36 +324,140 @@ public:
     > arrival;
     std::mutex mutex;
 };
+class network;
+// Keeps one receive outstanding on a socket with its own buffer, several receivers run in parallel on the io threads
+class udp_receiver
+{
+public:
+	udp_receiver (rai::network &, boost::asio::ip::udp::socket &);
+	void receive ();
+	void receive_action (boost::system::error_code const &, size_t);
+	// Drain up to network::batch_size datagrams with one recvmmsg once the socket is readable
+	void receive_batch (boost::system::error_code const &);
+	rai::network & network;
+	boost::asio::ip::udp::socket & socket;
+	rai::endpoint remote;
+	std::array <uint8_t, 512> buffer;
+	// Buffers for batched receives, empty unless the network is batching
+	std::vector <std::array <uint8_t, 512>> batch_buffers;
+	std::atomic <uint64_t> packets;
+	std::atomic <uint64_t> bytes;
+	// Receive calls that returned at least one datagram
+	std::atomic <uint64_t> batches;
+};
+// Outgoing traffic classes, lower values are sent first when bandwidth is short
+enum class send_priority : uint8_t
+{
+	vote,
+	publish,
+	keepalive
+};
+class token_bucket
+{
+public:
+	// Refills at rate_a bytes per second and holds up to one second worth, a rate of zero is unlimited
+	token_bucket (size_t);
+	bool try_consume (size_t, std::chrono::steady_clock::time_point const &);
+	bool full (std::chrono::steady_clock::time_point const &);
+	size_t rate;
+	double tokens;
+	std::chrono::steady_clock::time_point last;
+private:
+	void refill (std::chrono::steady_clock::time_point const &);
+};
+class send_queue_item
+{
+public:
+	std::shared_ptr <std::vector <uint8_t>> buffer;
+	rai::endpoint endpoint;
+	std::function <void (boost::system::error_code const &, rai::endpoint const &)> callback;
+	// Payload digest, queued packets are keyed on it together with the endpoint
+	uint64_t key;
+};
+// Paces outgoing datagrams with a global and a per peer token bucket.
+// Packets go straight out while there's bandwidth, otherwise they wait in per priority queues where a payload already queued for the same peer is sent once.
+class send_queue
+{
+public:
+	send_queue (rai::network &);
+	// The callback is called for failed or dropped sends and with success for payloads coalesced into one already queued
+	void add (std::shared_ptr <std::vector <uint8_t>>, std::vector <rai::endpoint> const &, rai::send_priority, std::function <void (boost::system::error_code const &, rai::endpoint const &)>);
+	void drain ();
+	// Bytes waiting for bandwidth
+	size_t size ();
+	rai::network & network;
+	std::atomic <uint64_t> queued_bytes;
+	std::atomic <uint64_t> dropped_bytes;
+	std::atomic <uint64_t> coalesced;
+	static size_t constexpr max_queued_bytes = 4 * 1024 * 1024;
+	static size_t constexpr max_peer_buckets = 4096;
+	static std::chrono::milliseconds constexpr drain_interval = std::chrono::milliseconds (10);
+private:
+	// Takes tokens from the global and the peer bucket, returns true if the packet can go now
+	bool consume (rai::endpoint const &, size_t, std::chrono::steady_clock::time_point const &);
+	bool consume_peer (rai::endpoint const &, size_t, std::chrono::steady_clock::time_point const &);
+	void send (std::vector <rai::send_queue_item> &);
+	void schedule_drain ();
+	// Drops the oldest packets of the lowest priority until the queue fits
+	void evict (std::vector <rai::send_queue_item> &);
+	// Forgets a packet leaving queue index_a
+	void remove (rai::send_queue_item const &, size_t);
+	std::array <std::deque <rai::send_queue_item>, 3> queues;
+	std::set <std::pair <uint64_t, rai::endpoint>> keys;
+	// Packets waiting per peer and priority, a packet only waits behind its own peer's traffic
+	std::unordered_map <rai::endpoint, std::array <size_t, 3>> waiting;
+	rai::token_bucket bucket;
+	std::unordered_map <rai::endpoint, rai::token_bucket> peer_buckets;
+	size_t bytes;
+	bool drain_scheduled;
+	std::mutex mutex;
+};
 class network
 {
 public:
     network (rai::node &, uint16_t);
     void receive ();
     void stop ();
-    void receive_action (boost::system::error_code const &, size_t);
+    void process_packet (rai::endpoint const &, uint8_t const *, size_t);
     void rpc_action (boost::system::error_code const &, size_t);
 	void rebroadcast_reps (std::shared_ptr <rai::block>);
 	void republish_vote (std::chrono::system_clock::time_point const &, std::shared_ptr <rai::vote>);
     void republish_block (MDB_txn *, std::shared_ptr <rai::block>);
 	void republish (rai::block_hash const &, std::shared_ptr <std::vector <uint8_t>>, rai::endpoint);
+	void republish (rai::block_hash const &, std::shared_ptr <std::vector <uint8_t>>, std::vector <rai::endpoint> const &);
     void publish_broadcast (std::vector <rai::peer_information> &, std::unique_ptr <rai::block>);
 	void confirm_send (rai::confirm_ack const &, std::shared_ptr <std::vector <uint8_t>>, rai::endpoint const &);
+	void confirm_send (rai::confirm_ack const &, std::shared_ptr <std::vector <uint8_t>>, std::vector <rai::endpoint> const &);
     void merge_peers (std::array <rai::endpoint, 8> const &);
     void send_keepalive (rai::endpoint const &);
 	void broadcast_confirm_req (std::shared_ptr <rai::block>);
     void send_confirm_req (rai::endpoint const &, std::shared_ptr <rai::block>);
     void send_buffer (uint8_t const *, size_t, rai::endpoint const &, std::function <void (boost::system::error_code const &, size_t)>);
+    // Queue the buffer for every endpoint behind the bandwidth limits
+    void send (std::shared_ptr <std::vector <uint8_t>>, std::vector <rai::endpoint> const &, rai::send_priority, std::function <void (boost::system::error_code const &, rai::endpoint const &)>);
+    // Send the same buffer to every endpoint, batched with sendmmsg where available, the callback is only called for failed sends
+    void send_buffer_many (std::shared_ptr <std::vector <uint8_t>>, std::vector <rai::endpoint> const &, std::function <void (boost::system::error_code const &, rai::endpoint const &)>);
     rai::endpoint endpoint ();
-    rai::endpoint remote;
-    std::array <uint8_t, 512> buffer;
+    // Sends go out on this socket, it's also the first receive socket
     boost::asio::ip::udp::socket socket;
+    // Additional sockets bound to the peering port with SO_REUSEPORT, the kernel spreads incoming datagrams between them
+    std::vector <std::unique_ptr <boost::asio::ip::udp::socket>> reuse_sockets;
+    std::vector <std::unique_ptr <rai::udp_receiver>> receivers;
     std::mutex socket_mutex;
     boost::asio::ip::udp::resolver resolver;
     rai::node & node;
-    uint64_t bad_sender_count;
-    bool on;
-    uint64_t insufficient_work_count;
-    uint64_t error_count;
+    std::atomic <uint64_t> bad_sender_count;
+    std::atomic <bool> on;
+    std::atomic <uint64_t> insufficient_work_count;
+    std::atomic <uint64_t> error_count;
+    // Using recvmmsg and sendmmsg
+    bool batching;
+    std::atomic <uint64_t> send_batches;
+    static size_t constexpr batch_size = 64;
+    // Publishes and votes flooded through several peers are dropped here before their work is checked
+    rai::digest_filter duplicate_filter;
+    static size_t constexpr duplicate_filter_size = 256 * 1024;
+    rai::send_queue send_queue;
 	rai::message_statistics incoming;
 	rai::message_statistics outgoing;
     static uint16_t const node_port = rai::rai_network == rai::rai_networks::rai_live_network ? 7075 : 54000;
@@ -397,6 +533,30 @@ public:
 	unsigned work_threads;
 	bool enable_voting;
 	unsigned bootstrap_connections;
+	// Connections the bootstrap frontier scan splits the account space between
+	unsigned bootstrap_frontier_ranges;
+	unsigned signature_checker_threads;
+	unsigned vote_processor_threads;
+	// Threads handling messages queued by the UDP receivers
+	unsigned message_processor_threads;
+	// Milliseconds the block processor waits for more blocks before opening its write transaction, zero commits as soon as the queue drains
+	unsigned group_commit_interval;
+	// Commit the group early once it holds this many blocks
+	unsigned group_commit_blocks;
+	rai::mdb_env_config lmdb;
+	// Number of UDP receivers on the peering port, each with its own socket where SO_REUSEPORT is available
+	unsigned network_receivers;
+	// Batch datagram reads and broadcasts with recvmmsg and sendmmsg, only available on Linux
+	bool network_batching;
+	// Outgoing UDP bytes per second for the whole node and for each peer, zero is unlimited
+	uint64_t bandwidth_limit;
+	uint64_t peer_bandwidth_limit;
+	// Blocks a bootstrap server reads per transaction and sends per write when serving a bulk pull
+	unsigned bulk_pull_batch_size;
+	// Blocks with missing dependencies held in memory, about half a kilobyte each, before the oldest are written to disk
+	unsigned unchecked_pool_max;
+	// Seconds a block can wait in memory for its dependency before it's written to disk
+	unsigned unchecked_pool_age;
 	std::string callback_address;
 	uint16_t callback_port;
 	std::string callback_target;
@@ -414,12 +574,73 @@ public:
 	rai::observer_set <> disconnect;
 	rai::observer_set <> started;
 };
+// Votes received from the network are queued and their signatures checked in batches on a pool of verifier threads
 class vote_processor
 {
 public:
 	vote_processor (rai::node &);
+	~vote_processor ();
+	// Queue a vote for verification, returns true if the queue is full and the vote was dropped
+	bool add (std::shared_ptr <rai::vote>, rai::endpoint const &);
 	rai::vote_result vote (std::shared_ptr <rai::vote>, rai::endpoint);
+	void flush ();
+	void stop ();
+	size_t size ();
+	rai::node & node;
+	std::atomic <uint64_t> verified;
+	std::atomic <uint64_t> invalid;
+	std::atomic <uint64_t> dropped;
+	static size_t constexpr max_votes = 16384;
+	static size_t constexpr batch_size = 256;
+private:
+	void process_votes ();
+	void verify_votes (std::deque <std::pair <std::shared_ptr <rai::vote>, rai::endpoint>> &);
+	void process_result (rai::vote_result const &, std::shared_ptr <rai::vote>, rai::endpoint const &);
+	std::deque <std::pair <std::shared_ptr <rai::vote>, rai::endpoint>> votes;
+	bool stopped;
+	unsigned active;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector <std::thread> threads;
+};
+// Messages parsed off the network wait here for worker threads so the receive path never blocks on the ledger.
+// Each message type has its own bounded queue that drops its oldest entry when full, votes from high weight representatives are handled first.
+class message_processor
+{
+public:
+	message_processor (rai::node &);
+	~message_processor ();
+	void add (rai::keepalive const &, rai::endpoint const &);
+	void add (rai::publish const &, rai::endpoint const &);
+	void add (rai::confirm_req const &, rai::endpoint const &);
+	void add (rai::confirm_ack const &, rai::endpoint const &);
+	void flush ();
+	void stop ();
+	size_t size ();
 	rai::node & node;
+	rai::message_statistics dropped;
+	std::atomic <uint64_t> priority_votes;
+	static size_t constexpr max_queue = 4096;
+private:
+	void process_messages ();
+	template <typename T>
+	void push (std::deque <std::pair <T, rai::endpoint>> &, T const &, rai::endpoint const &, std::atomic <uint64_t> &);
+	template <typename T>
+	void process_front (std::unique_lock <std::mutex> &, std::deque <std::pair <T, rai::endpoint>> &);
+	void processed (rai::message const &);
+	void processed (rai::confirm_ack const &);
+	std::deque <std::pair <rai::confirm_ack, rai::endpoint>> priority_acks;
+	std::deque <std::pair <rai::confirm_ack, rai::endpoint>> confirm_acks;
+	std::deque <std::pair <rai::confirm_req, rai::endpoint>> confirm_reqs;
+	std::deque <std::pair <rai::keepalive, rai::endpoint>> keepalives;
+	std::deque <std::pair <rai::publish, rai::endpoint>> publishes;
+	// Representatives seen voting with enough weight for their votes to skip ahead, filled in by the workers so queueing never reads the ledger
+	std::unordered_set <rai::account> representatives;
+	bool stopped;
+	unsigned active;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector <std::thread> threads;
 };
 // The network is crawled for representatives by ocassionally sending a unicast confirm_req for a specific block and watching to see if it's acknowledged with a vote.
 class rep_crawler
@@ -439,11 +660,67 @@ public:
 	block_processor_item (std::shared_ptr <rai::block>, std::function <void (MDB_txn *, rai::process_return, std::shared_ptr <rai::block>)>);
 	block_processor_item (std::shared_ptr <rai::block>, std::function <void (MDB_txn *, rai::process_return, std::shared_ptr <rai::block>)>, bool);
 	std::shared_ptr <rai::block> block;
+	// Called with the transaction the result came from, blocks found old or missing a dependency before the commit stage get a read transaction
 	std::function <void (MDB_txn *, rai::process_return, std::shared_ptr <rai::block>)> callback;
 	bool force;
+	// Pulled by bootstrap, the commit stage stages block writes for batches holding these and writes them in key order
+	bool bootstrap;
+	// Account the block signature has been checked against, zero if not yet verified
+	rai::account verified;
+	// Filled in by the hashing stage, zero until then
+	rai::block_hash hash;
+	// Called once the transaction holding the block has committed
+	std::function <void (rai::process_return const &, std::shared_ptr <rai::block>)> completed;
+};
+class signature_check_set
+{
+public:
+	size_t size;
+	unsigned char const ** messages;
+	size_t * message_lengths;
+	unsigned char const ** pub_keys;
+	unsigned char const ** signatures;
+	int * verifications;
+};
+// Verifies sets of signatures in batches, large sets are split across a pool of worker threads
+class signature_checker
+{
+public:
+	signature_checker (unsigned);
+	~signature_checker ();
+	void verify (rai::signature_check_set &);
+	void stop ();
+	static size_t constexpr batch_size = 256;
+private:
+	void run ();
+	bool stopped;
+	std::deque <std::function <void ()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector <std::thread> threads;
+};
+enum class block_processor_stage
+{
+	hash,
+	verify,
+	dependencies,
+	commit
+};
+class block_processor_stats
+{
+public:
+	block_processor_stats ();
+	std::string name;
+	// Items waiting in front of the stage
+	size_t queued;
+	uint64_t blocks;
+	uint64_t batches;
+	// Microseconds spent processing batches
+	uint64_t time;
 };
 // Processing blocks is a potentially long IO operation
 // This class isolates block insertion from other operations like servicing network operations
+// Blocks flow through a pipeline of hashing, signature verification, dependency checking and committing, each stage running on its own thread with a bounded queue in front of the next
 class block_processor
 {
 public:
@@ -452,16 +729,45 @@ public:
 	void stop ();
 	void flush ();
 	void add (rai::block_processor_item const &);
+	// Processes the block on the calling thread, or waits for the group commit if that's enabled
 	void process_receive_many (rai::block_processor_item const &);
 	void process_receive_many (std::deque <rai::block_processor_item> &);
+	// Queue the block behind blocks from other producers and wait until the transaction holding it has committed
+	rai::process_return process_wait (rai::block_processor_item const &);
+	bool group_commit () const;
 	rai::process_return process_receive_one (MDB_txn *, std::shared_ptr <rai::block>);
+	rai::process_return process_receive_one (MDB_txn *, std::shared_ptr <rai::block>, rai::account const &);
+	void verify_signatures (std::deque <rai::block_processor_item> &);
+	void verify_signatures (std::deque <rai::block_processor_item> &, std::unordered_map <rai::block_hash, rai::account> &);
+	// Remove blocks already in the ledger and blocks missing a dependency so neither needs the write transaction
+	void check_dependencies (std::deque <rai::block_processor_item> &);
+	// Runs the commit stage on the calling thread
 	void process_blocks ();
+	std::vector <rai::block_processor_stats> stats ();
+	static size_t constexpr batch_size = 1024;
+	static size_t constexpr max_queue = 16384;
+	static size_t constexpr max_signers = 65536;
 private:
+	void run_stage (rai::block_processor_stage, std::deque <rai::block_processor_item> &, std::deque <rai::block_processor_item> *, std::function <void (std::deque <rai::block_processor_item> &)>);
+	void process_receive_many (std::deque <rai::block_processor_item> &, bool);
+	// Take blocks reaching the commit stage until there are enough or the deadline passes
+	void group_wait (std::deque <rai::block_processor_item> &, size_t, std::chrono::system_clock::time_point const &);
 	bool stopped;
-	bool idle;
+	std::thread::id commit_thread;
+	// Number of stages currently processing a batch
+	unsigned active;
 	std::deque <rai::block_processor_item> blocks;
+	std::deque <rai::block_processor_item> hashed;
+	std::deque <rai::block_processor_item> verified;
+	std::deque <rai::block_processor_item> checked;
+	// Orders the dependency stage's snapshot and pooling of gaps against the unchecked drain after each commit
+	std::mutex gaps_mutex;
+	std::array <rai::block_processor_stats, 4> stage_stats;
+	// Signers of recently verified blocks, only used by the verification stage
+	std::unordered_map <rai::block_hash, rai::account> signers;
 	std::mutex mutex;
 	std::condition_variable condition;
+	std::vector <std::thread> threads;
 	rai::node & node;
 };
 class node : public std::enable_shared_from_this <rai::node>
@@ -496,6 +802,10 @@ public:
 	void ongoing_rep_crawl ();
 	void ongoing_bootstrap ();
 	void ongoing_store_flush ();
+	void ongoing_peer_cache ();
+	void save_peers ();
+	// Add the peers saved by the last run so keepalives and rep queries can go out before any peer contacts us
+	void restore_peers ();
 	void backup_wallet ();
 	int price (rai::uint128_t const &, int);
 	void generate_work (rai::block &);
@@ -516,20 +826,26 @@ public:
 	rai::bootstrap_initiator bootstrap_initiator;
     rai::bootstrap_listener bootstrap;
     rai::peer_container peers;
+	rai::peer_cache peer_cache;
 	boost::filesystem::path application_path;
 	rai::node_observers observers;
 	rai::port_mapping port_mapping;
 	rai::vote_processor vote_processor;
 	rai::rep_crawler rep_crawler;
 	unsigned warmed_up;
+	rai::signature_checker checker;
     rai::block_processor block_processor;
 	std::thread block_processor_thread;
     rai::block_arrival block_arrival;
+	rai::message_processor message_processor;
 	static double constexpr price_max = 16.0;
 	static double constexpr free_cutoff = 1024.0;
     static std::chrono::seconds constexpr period = std::chrono::seconds (60);
     static std::chrono::seconds constexpr cutoff = period * 5;
 	static std::chrono::minutes constexpr backup_interval = std::chrono::minutes (5);
+	static std::chrono::minutes constexpr peer_cache_interval = std::chrono::minutes (5);
+	// Saved peers not heard from for this long are probably gone
+	static std::chrono::hours constexpr peer_cache_cutoff = std::chrono::hours (24 * 7);
 };
 class thread_runner
 {
@@ -1272,6 +1272,24 @@ void rai::rpc_handler::block_create ()
 	}
 }
 
+void rai::rpc_handler::block_processor ()
+{
+	boost::property_tree::ptree response_l;
+	for (auto & i : node.block_processor.stats ())
+	{
+		boost::property_tree::ptree entry;
+		entry.put ("queued", std::to_string (i.queued));
+		entry.put ("blocks", std::to_string (i.blocks));
+		entry.put ("batches", std::to_string (i.batches));
+		entry.put ("time", std::to_string (i.time));
+		entry.put ("latency", std::to_string (i.batches != 0 ? i.time / i.batches : 0));
+		entry.put ("rate", std::to_string (i.time != 0 ? i.blocks * 1000000 / i.time : 0));
+		response_l.add_child (i.name, entry);
+	}
+	response_l.get_child ("ingest").put ("appended", std::to_string (node.store.block_buffer.appended));
+	response (response_l);
+}
+
 void rai::rpc_handler::successors ()
 {
 	std::string block_text (request.get <std::string> ("block"));
@@ -1349,6 +1367,36 @@ void rai::rpc_handler::bootstrap_any ()
 	response (response_l);
 }
 
+void rai::rpc_handler::bootstrap_status ()
+{
+	boost::property_tree::ptree response_l;
+	auto attempt (node.bootstrap_initiator.current_attempt ());
+	response_l.put ("bootstrapping", attempt != nullptr ? "true" : "false");
+	if (attempt != nullptr)
+	{
+		{
+			std::lock_guard <std::mutex> lock (attempt->mutex);
+			response_l.put ("pulls", std::to_string (attempt->pulls.size ()));
+			response_l.put ("running", std::to_string (attempt->running.size ()));
+		}
+		response_l.put ("connections", std::to_string (attempt->connections));
+		boost::property_tree::ptree peers_l;
+		for (auto & i : attempt->active_clients ())
+		{
+			boost::property_tree::ptree entry;
+			entry.put ("blocks", std::to_string (i->block_count));
+			entry.put ("seconds", std::to_string (i->pull_seconds ()));
+			entry.put ("blocks_per_second", std::to_string (i->block_rate ()));
+			entry.put ("pulling", i->pulling () ? "true" : "false");
+			std::stringstream text;
+			text << i->endpoint;
+			peers_l.push_back (boost::property_tree::ptree::value_type (text.str (), entry));
+		}
+		response_l.add_child ("peers", peers_l);
+	}
+	response (response_l);
+}
+
 void rai::rpc_handler::chain ()
 {
 	std::string block_text (request.get <std::string> ("block"));
@@ -1899,6 +1947,44 @@ void rai::rpc_handler::mrai_to_raw ()
 	}
 }
 
+void rai::rpc_handler::network_stats ()
+{
+	boost::property_tree::ptree response_l;
+	boost::property_tree::ptree receivers;
+	for (auto & i : node.network.receivers)
+	{
+		boost::property_tree::ptree entry;
+		entry.put ("packets", std::to_string (i->packets));
+		entry.put ("bytes", std::to_string (i->bytes));
+		entry.put ("batches", std::to_string (i->batches));
+		receivers.push_back (std::make_pair ("", entry));
+	}
+	response_l.add_child ("receivers", receivers);
+	response_l.put ("send_batches", std::to_string (node.network.send_batches));
+	response_l.put ("error", std::to_string (node.network.error_count));
+	response_l.put ("insufficient_work", std::to_string (node.network.insufficient_work_count));
+	response_l.put ("bad_sender", std::to_string (node.network.bad_sender_count));
+	boost::property_tree::ptree dropped;
+	dropped.put ("keepalive", std::to_string (node.message_processor.dropped.keepalive));
+	dropped.put ("publish", std::to_string (node.message_processor.dropped.publish));
+	dropped.put ("confirm_req", std::to_string (node.message_processor.dropped.confirm_req));
+	dropped.put ("confirm_ack", std::to_string (node.message_processor.dropped.confirm_ack));
+	response_l.add_child ("dropped", dropped);
+	response_l.put ("queued", std::to_string (node.message_processor.size ()));
+	response_l.put ("priority_votes", std::to_string (node.message_processor.priority_votes));
+	boost::property_tree::ptree duplicates;
+	duplicates.put ("checked", std::to_string (node.network.duplicate_filter.checked));
+	duplicates.put ("hits", std::to_string (node.network.duplicate_filter.hits));
+	response_l.add_child ("duplicates", duplicates);
+	boost::property_tree::ptree send_queue;
+	send_queue.put ("queued_bytes", std::to_string (node.network.send_queue.queued_bytes));
+	send_queue.put ("dropped_bytes", std::to_string (node.network.send_queue.dropped_bytes));
+	send_queue.put ("coalesced", std::to_string (node.network.send_queue.coalesced));
+	send_queue.put ("pending_bytes", std::to_string (node.network.send_queue.size ()));
+	response_l.add_child ("send_queue", send_queue);
+	response (response_l);
+}
+
 void rai::rpc_handler::krai_from_raw ()
 {
 	std::string amount_text (request.get <std::string> ("amount"));
@@ -2369,6 +2455,13 @@ void rai::rpc_handler::process ()
 			node.block_arrival.add (hash);
 			rai::process_return result;
 			std::shared_ptr <rai::block> block_a (std::move (block));
+			auto group_commit (node.block_processor.group_commit ());
+			if (group_commit)
+			{
+				// Share the block processor's write transaction, observers are notified by the block processor once it commits
+				result = node.block_processor.process_wait (rai::block_processor_item (block_a));
+			}
+			else
 			{
 				rai::transaction transaction (node.store.environment, nullptr, true);
 				result = node.block_processor.process_receive_one (transaction, block_a);
@@ -2377,7 +2470,10 @@ void rai::rpc_handler::process ()
 			{
 				case rai::process_result::progress:
 				{
-					node.observers.blocks (block_a, result.account, result.amount);
+					if (!group_commit)
+					{
+						node.observers.blocks (block_a, result.account, result.amount);
+					}
 					boost::property_tree::ptree response_l;
 					response_l.put ("hash", hash.to_string ());
 					response (response_l);
@@ -3004,6 +3100,13 @@ void rai::rpc_handler::unchecked ()
 	}
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree unchecked;
+	// Blocks still pooled in memory come first
+	for (auto & block : node.store.unchecked_pooled (std::min <uint64_t> (count, std::numeric_limits <size_t>::max ())))
+	{
+		std::string contents;
+		block->serialize_json (contents);
+		unchecked.put (block->hash ().to_string (), contents);
+	}
 	rai::transaction transaction (node.store.environment, nullptr, false);
 	for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
 	{
@@ -3040,22 +3143,14 @@ void rai::rpc_handler::unchecked_get ()
 	auto error (hash.decode_hex (hash_text));
 	if (!error)
 	{
-		boost::property_tree::ptree response_l;
 		rai::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n; ++i)
-		{
-			rai::bufferstream stream (reinterpret_cast <uint8_t const *> (i->second.data ()), i->second.size ());
-			auto block (rai::deserialize_block (stream));
-			if (block->hash () == hash)
-			{
-				std::string contents;
-				block->serialize_json (contents);
-				response_l.put ("contents", contents);
-				break;
-			}
-		}
-		if (!response_l.empty ())
+		auto block (node.store.unchecked_find (transaction, hash));
+		if (block != nullptr)
 		{
+			boost::property_tree::ptree response_l;
+			std::string contents;
+			block->serialize_json (contents);
+			response_l.put ("contents", contents);
 			response (response_l);
 		}
 		else
@@ -3093,23 +3188,53 @@ void rai::rpc_handler::unchecked_keys ()
 	}
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree unchecked;
-	rai::transaction transaction (node.store.environment, nullptr, false);
-	for (auto i (node.store.unchecked_begin (transaction, key)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
+	auto add_entry ([&unchecked] (rai::block_hash const & key_a, rai::block const & block_a)
 	{
 		boost::property_tree::ptree entry;
-		rai::bufferstream stream (reinterpret_cast <uint8_t const *> (i->second.data ()), i->second.size ());
-		auto block (rai::deserialize_block (stream));
 		std::string contents;
-		block->serialize_json (contents);
-		entry.put ("key", rai::block_hash (i->first.uint256 ()).to_string ());
-		entry.put ("hash", block->hash ().to_string ());
+		block_a.serialize_json (contents);
+		entry.put ("key", key_a.to_string ());
+		entry.put ("hash", block_a.hash ().to_string ());
 		entry.put ("contents", contents);
 		unchecked.push_back (std::make_pair ("", entry));
+	});
+	// Pooled blocks are merged in to the table's key order
+	auto pooled (node.store.unchecked_pooled (key, std::min <uint64_t> (count, std::numeric_limits <size_t>::max ())));
+	auto j (pooled.begin ());
+	rai::transaction transaction (node.store.environment, nullptr, false);
+	for (auto i (node.store.unchecked_begin (transaction, key)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
+	{
+		rai::block_hash key_l (i->first.uint256 ());
+		for (; j != pooled.end () && j->dependency < key_l && unchecked.size () < count; ++j)
+		{
+			add_entry (j->dependency, *j->block);
+		}
+		if (unchecked.size () < count)
+		{
+			rai::bufferstream stream (reinterpret_cast <uint8_t const *> (i->second.data ()), i->second.size ());
+			auto block (rai::deserialize_block (stream));
+			add_entry (key_l, *block);
+		}
+	}
+	for (; j != pooled.end () && unchecked.size () < count; ++j)
+	{
+		add_entry (j->dependency, *j->block);
 	}
 	response_l.add_child ("unchecked", unchecked);
 	response (response_l);
 }
 
+void rai::rpc_handler::unchecked_pool ()
+{
+	boost::property_tree::ptree response_l;
+	rai::transaction transaction (node.store.environment, nullptr, false);
+	response_l.put ("memory", std::to_string (node.store.unchecked_pool_size ()));
+	response_l.put ("max", std::to_string (node.store.unchecked_pool.max));
+	response_l.put ("stored", std::to_string (node.store.unchecked_stored (transaction)));
+	response_l.put ("spilled", std::to_string (node.store.unchecked_pool_spilled ()));
+	response (response_l);
+}
+
 void rai::rpc_handler::version ()
 {
 	boost::property_tree::ptree response_l;
@@ -4275,6 +4400,10 @@ void rai::rpc_handler::process_request ()
 		{
 			block_create ();
 		}
+		else if (action == "block_processor")
+		{
+			block_processor ();
+		}
 		else if (action == "successors")
 		{
 			successors ();
@@ -4287,6 +4416,10 @@ void rai::rpc_handler::process_request ()
 		{
 			bootstrap_any ();
 		}
+		else if (action == "bootstrap_status")
+		{
+			bootstrap_status ();
+		}
 		else if (action == "chain")
 		{
 			chain ();
@@ -4347,6 +4480,10 @@ void rai::rpc_handler::process_request ()
 		{
 			mrai_to_raw ();
 		}
+		else if (action == "network_stats")
+		{
+			network_stats ();
+		}
 		else if (action == "password_change")
 		{
 			// Processed before logging
@@ -4451,6 +4588,10 @@ void rai::rpc_handler::process_request ()
 		{
 			unchecked_keys ();
 		}
+		else if (action == "unchecked_pool")
+		{
+			unchecked_pool ();
+		}
 		else if (action == "validate_account_number")
 		{
 			validate_account_number ();
@@ -115,8 +115,10 @@ public:
 	void block_count ();
 	void block_count_type ();
 	void block_create ();
+	void block_processor ();
 	void bootstrap ();
 	void bootstrap_any ();
+	void bootstrap_status ();
 	void chain ();
 	void delegators ();
 	void delegators_count ();
@@ -132,6 +134,7 @@ public:
 	void ledger ();
 	void mrai_to_raw ();
 	void mrai_from_raw ();
+	void network_stats ();
 	void password_change ();
 	void password_enter ();
 	void password_valid (bool wallet_locked);
@@ -159,6 +162,7 @@ public:
 	void unchecked_clear ();
 	void unchecked_get ();
 	void unchecked_keys ();
+	void unchecked_pool ();
 	void validate_account_number ();
 	void version ();
 	void wallet_add ();
@@ -12,7 +12,113 @@ boost::filesystem::path rai::unique_path ()
 	return result;
 }
 
-rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a)
+rai::mdb_env_config::mdb_env_config () :
+sync (rai::mdb_sync_mode::full),
+sync_interval (1000),
+write_map (false),
+no_readahead (false),
+map_size (1ULL * 1024 * 1024 * 1024 * 1024) // 1 Terabyte
+{
+}
+
+void rai::mdb_env_config::serialize_json (boost::property_tree::ptree & tree_a) const
+{
+	switch (sync)
+	{
+		case rai::mdb_sync_mode::full:
+			tree_a.put ("sync", "full");
+			break;
+		case rai::mdb_sync_mode::no_metasync:
+			tree_a.put ("sync", "no_metasync");
+			break;
+		case rai::mdb_sync_mode::periodic:
+			tree_a.put ("sync", "periodic");
+			break;
+	}
+	tree_a.put ("sync_interval", std::to_string (sync_interval));
+	tree_a.put ("write_map", write_map);
+	tree_a.put ("no_readahead", no_readahead);
+	tree_a.put ("map_size", std::to_string (map_size));
+}
+
+bool rai::mdb_env_config::deserialize_json (boost::property_tree::ptree const & tree_a)
+{
+	auto result (false);
+	try
+	{
+		auto sync_l (tree_a.get <std::string> ("sync"));
+		auto sync_interval_l (tree_a.get <std::string> ("sync_interval"));
+		write_map = tree_a.get <bool> ("write_map");
+		no_readahead = tree_a.get <bool> ("no_readahead");
+		auto map_size_l (tree_a.get <std::string> ("map_size"));
+		if (sync_l == "full")
+		{
+			sync = rai::mdb_sync_mode::full;
+		}
+		else if (sync_l == "no_metasync")
+		{
+			sync = rai::mdb_sync_mode::no_metasync;
+		}
+		else if (sync_l == "periodic")
+		{
+			sync = rai::mdb_sync_mode::periodic;
+		}
+		else
+		{
+			result = true;
+		}
+		try
+		{
+			sync_interval = std::stoul (sync_interval_l);
+			map_size = std::stoull (map_size_l);
+			result |= sync_interval == 0;
+			result |= map_size == 0;
+		}
+		catch (std::logic_error const &)
+		{
+			result = true;
+		}
+	}
+	catch (std::runtime_error const &)
+	{
+		result = true;
+	}
+	return result;
+}
+
+unsigned rai::mdb_env_config::flags () const
+{
+	unsigned result (MDB_NOSUBDIR);
+	switch (sync)
+	{
+		case rai::mdb_sync_mode::full:
+			break;
+		case rai::mdb_sync_mode::no_metasync:
+			result |= MDB_NOMETASYNC;
+			break;
+		case rai::mdb_sync_mode::periodic:
+			result |= MDB_NOSYNC;
+			break;
+	}
+	if (write_map)
+	{
+		result |= MDB_WRITEMAP;
+	}
+	if (no_readahead)
+	{
+		result |= MDB_NORDAHEAD;
+	}
+	return result;
+}
+
+rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a) :
+mdb_env (error_a, path_a, rai::mdb_env_config ())
+{
+}
+
+rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, rai::mdb_env_config const & config_a) :
+config (config_a),
+stopped (false)
 {
 	boost::system::error_code error;
 	if (path_a.has_parent_path ())
@@ -24,10 +130,14 @@ rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a)
 			assert (status1 == 0);
 			auto status2 (mdb_env_set_maxdbs (environment, 128));
 			assert (status2 == 0);
-			auto status3 (mdb_env_set_mapsize (environment, 1ULL * 1024 * 1024 * 1024 * 1024)); // 1 Terabyte
+			auto status3 (mdb_env_set_mapsize (environment, config.map_size));
 			assert (status3 == 0);
-			auto status4 (mdb_env_open (environment, path_a.string ().c_str (), MDB_NOSUBDIR, 00600));
+			auto status4 (mdb_env_open (environment, path_a.string ().c_str (), config.flags (), 00600));
 			error_a = status4 != 0;
+			if (!error_a && config.sync == rai::mdb_sync_mode::periodic)
+			{
+				sync_thread = std::thread ([this] () { run_sync (); });
+			}
 		}
 		else
 		{
@@ -44,12 +154,38 @@ rai::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a)
 
 rai::mdb_env::~mdb_env ()
 {
+	if (sync_thread.joinable ())
+	{
+		{
+			std::lock_guard <std::mutex> lock (mutex);
+			stopped = true;
+			condition.notify_all ();
+		}
+		sync_thread.join ();
+		mdb_env_sync (environment, 1);
+	}
 	if (environment != nullptr)
 	{
 		mdb_env_close (environment);
 	}
 }
 
+void rai::mdb_env::run_sync ()
+{
+	std::unique_lock <std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		condition.wait_for (lock, std::chrono::milliseconds (config.sync_interval));
+		if (!stopped)
+		{
+			lock.unlock ();
+			auto status (mdb_env_sync (environment, 1));
+			assert (status == 0);
+			lock.lock ();
+		}
+	}
+}
+
 rai::mdb_env::operator MDB_env * () const
 {
 	return environment;
@@ -109,17 +245,26 @@ rai::mdb_val::operator MDB_val const & () const
 	return value;
 }
 
-rai::transaction::transaction (rai::mdb_env & environment_a, MDB_txn * parent_a, bool write) :
-environment (environment_a)
+rai::transaction::transaction (rai::mdb_env & environment_a, MDB_txn * parent_a, bool write_a) :
+environment (environment_a),
+write (write_a && parent_a == nullptr)
 {
-	auto status (mdb_txn_begin (environment_a, parent_a, write ? 0 : MDB_RDONLY, &handle));
+	auto status (mdb_txn_begin (environment_a, parent_a, write_a ? 0 : MDB_RDONLY, &handle));
 	assert (status == 0);
 }
 
 rai::transaction::~transaction ()
 {
+	if (write && environment.commit_prepare)
+	{
+		environment.commit_prepare (handle);
+	}
 	auto status (mdb_txn_commit (handle));
 	assert (status == 0);
+	if (write && environment.commit_complete)
+	{
+		environment.commit_complete ();
+	}
 }
 
 rai::transaction::operator MDB_txn * () const
@@ -3,6 +3,9 @@
 #include <array>
 #include <atomic>
 #include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <type_traits>
 
 #include <boost/iostreams/device/back_inserter.hpp>
@@ -98,13 +101,49 @@ bool fetch_object (T & object, boost::filesystem::path const & path_a, std::fstr
 	return error;
 }
 
+enum class mdb_sync_mode
+{
+	// Flush data and meta pages on every commit
+	full,
+	// Skip the meta page flush, a crash can lose the last transaction but not corrupt the database
+	no_metasync,
+	// Don't flush on commit, a background thread flushes every sync_interval milliseconds
+	periodic
+};
+class mdb_env_config
+{
+public:
+	mdb_env_config ();
+	void serialize_json (boost::property_tree::ptree &) const;
+	bool deserialize_json (boost::property_tree::ptree const &);
+	unsigned flags () const;
+	rai::mdb_sync_mode sync;
+	unsigned sync_interval;
+	// Map the database writable, saves a copy per written page
+	bool write_map;
+	// Disable OS read ahead, helps random reads on databases larger than memory
+	bool no_readahead;
+	uint64_t map_size;
+};
 class mdb_env
 {
 public:
 	mdb_env (bool &, boost::filesystem::path const &);
+	mdb_env (bool &, boost::filesystem::path const &, rai::mdb_env_config const &);
 	~mdb_env ();
 	operator MDB_env * () const;
 	MDB_env * environment;
+	rai::mdb_env_config config;
+	// Called for every write transaction, before its commit while the write lock is still held and after the commit completes
+	// Lets in-memory copies of tables hand out only committed data, the prepare hook is given the committing transaction
+	std::function <void (MDB_txn *)> commit_prepare;
+	std::function <void ()> commit_complete;
+private:
+	void run_sync ();
+	bool stopped;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::thread sync_thread;
 };
 class mdb_val
 {
@@ -129,5 +168,6 @@ public:
 	operator MDB_txn * () const;
 	MDB_txn * handle;
 	rai::mdb_env & environment;
+	bool write;
 };
 }
@@ -145,9 +145,12 @@ std::pair <rai::uint128_t, std::shared_ptr <rai::block>> rai::ledger::winner (MD
 	return std::make_pair (existing->first, existing->second);
 }
 
-std::map <rai::uint128_t, std::shared_ptr <rai::block>, std::greater <rai::uint128_t>> rai::ledger::tally (MDB_txn * transaction_a, rai::votes const & votes_a)
+namespace
+{
+template <typename T>
+std::map <rai::uint128_t, std::shared_ptr <rai::block>, std::greater <rai::uint128_t>> tally_weights (rai::votes const & votes_a, T const & weight_a)
 {
-	std::unordered_map <std::shared_ptr <block>, rai::uint128_t, rai::shared_ptr_block_hash, rai::shared_ptr_block_hash> totals;
+	std::unordered_map <std::shared_ptr <rai::block>, rai::uint128_t, rai::shared_ptr_block_hash, rai::shared_ptr_block_hash> totals;
 	// Construct a map of blocks -> vote total.
 	for (auto & i: votes_a.rep_votes)
 	{
@@ -158,7 +161,7 @@ std::map <rai::uint128_t, std::shared_ptr <rai::block>, std::greater <rai::uint1
 			existing = totals.find (i.second);
 			assert (existing != totals.end ());
 		}
-		auto weight_l (weight (transaction_a, i.first));
+		auto weight_l (weight_a (i.first));
 		existing->second += weight_l;
 	}
 	// Construction a map of vote total -> block in decreasing order.
@@ -169,6 +172,42 @@ std::map <rai::uint128_t, std::shared_ptr <rai::block>, std::greater <rai::uint1
 	}
 	return result;
 }
+}
+
+std::map <rai::uint128_t, std::shared_ptr <rai::block>, std::greater <rai::uint128_t>> rai::ledger::tally (MDB_txn * transaction_a, rai::votes const & votes_a)
+{
+	return tally_weights (votes_a, [this, transaction_a] (rai::account const & account_a) { return weight (transaction_a, account_a); });
+}
+
+std::map <rai::uint128_t, std::shared_ptr <rai::block>, std::greater <rai::uint128_t>> rai::ledger::tally (rai::weight_snapshot const & weights_a, rai::votes const & votes_a)
+{
+	return tally_weights (votes_a, [&weights_a] (rai::account const & account_a) { return weights_a.weight (account_a); });
+}
+
+std::shared_ptr <rai::weight_snapshot> rai::ledger::weights (MDB_txn * transaction_a)
+{
+	auto result (std::make_shared <rai::weight_snapshot> ());
+	result->weights = store.rep_weights.snapshot ();
+	result->supply = supply (transaction_a);
+	return result;
+}
+
+rai::weight_snapshot::weight_snapshot () :
+weights (std::make_shared <rai::rep_weights::weights_map> ()),
+supply (0)
+{
+}
+
+rai::uint128_t rai::weight_snapshot::weight (rai::account const & account_a) const
+{
+	rai::uint128_t result (0);
+	auto existing (weights->find (account_a));
+	if (existing != weights->end ())
+	{
+		result = existing->second;
+	}
+	return result;
+}
 
 rai::votes::votes (std::shared_ptr <rai::block> block_a) :
 id (block_a->root ())
@@ -456,13 +495,15 @@ size_t rai::block_counts::sum ()
 }
 
 rai::block_store::block_store (bool & error_a, boost::filesystem::path const & path_a) :
-environment (error_a, path_a),
+block_store (error_a, path_a, rai::mdb_env_config ())
+{
+}
+
+rai::block_store::block_store (bool & error_a, boost::filesystem::path const & path_a, rai::mdb_env_config const & config_a) :
+environment (error_a, path_a, config_a),
 frontiers (0),
 accounts (0),
-send_blocks (0),
-receive_blocks (0),
-open_blocks (0),
-change_blocks (0),
+blocks (0),
 pending (0),
 blocks_info (0),
 representation (0),
@@ -475,10 +516,7 @@ checksum (0)
 		rai::transaction transaction (environment, nullptr, true);
 		error_a |= mdb_dbi_open (transaction, "frontiers", MDB_CREATE, &frontiers) != 0;
 		error_a |= mdb_dbi_open (transaction, "accounts", MDB_CREATE, &accounts) != 0;
-		error_a |= mdb_dbi_open (transaction, "send", MDB_CREATE, &send_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "receive", MDB_CREATE, &receive_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "open", MDB_CREATE, &open_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "change", MDB_CREATE, &change_blocks) != 0;
+		error_a |= mdb_dbi_open (transaction, "blocks", MDB_CREATE, &blocks) != 0;
 		error_a |= mdb_dbi_open (transaction, "pending", MDB_CREATE, &pending) != 0;
 		error_a |= mdb_dbi_open (transaction, "blocks_info", MDB_CREATE, &blocks_info) != 0;
 		error_a |= mdb_dbi_open (transaction, "representation", MDB_CREATE, &representation) != 0;
@@ -491,7 +529,114 @@ checksum (0)
 		{
 			do_upgrades (transaction);
 			checksum_put (transaction, 0, 0, 0);
+			rep_weights_load (transaction);
+		}
+		environment.commit_prepare = [this] (MDB_txn * transaction_a) { block_buffer_flush (transaction_a); rep_weights.commit_prepare (); };
+		environment.commit_complete = [this] () { rep_weights.commit_complete (); };
+	}
+}
+
+void rai::block_store::rep_weights_load (MDB_txn * transaction_a)
+{
+	rai::rep_weights::weights_map weights;
+	for (auto i (representation_begin (transaction_a)), n (representation_end ()); i != n; ++i)
+	{
+		rai::uint128_union weight;
+		rai::bufferstream stream (reinterpret_cast <uint8_t const *> (i->second.data ()), i->second.size ());
+		auto error (rai::read (stream, weight));
+		assert (!error);
+		weights [i->first.uint256 ()] = weight.number ();
+	}
+	rep_weights.load (std::move (weights));
+}
+
+rai::rep_weights::rep_weights () :
+current (std::make_shared <weights_map> ()),
+staged_transaction (nullptr),
+committed_pending (false)
+{
+}
+
+rai::uint128_t rai::rep_weights::get (MDB_txn * transaction_a, rai::account const & account_a)
+{
+	boost::optional <rai::uint128_t> result;
+	if (transaction_a == staged_transaction)
+	{
+		auto existing (staged.find (account_a));
+		if (existing != staged.end ())
+		{
+			result = existing->second;
+		}
+	}
+	if (!result && committed_pending)
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		auto existing (committed.find (account_a));
+		if (existing != committed.end ())
+		{
+			result = existing->second;
+		}
+	}
+	if (!result)
+	{
+		auto current_l (std::atomic_load (&current));
+		auto existing (current_l->find (account_a));
+		result = existing != current_l->end () ? existing->second : rai::uint128_t (0);
+	}
+	return result.get ();
+}
+
+void rai::rep_weights::put (MDB_txn * transaction_a, rai::account const & account_a, rai::uint128_t const & weight_a)
+{
+	assert (staged_transaction == nullptr || staged_transaction == transaction_a);
+	staged_transaction = transaction_a;
+	staged [account_a] = weight_a;
+}
+
+void rai::rep_weights::load (weights_map && weights_a)
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	staged.clear ();
+	staged_transaction = nullptr;
+	committed.clear ();
+	committed_pending = false;
+	std::atomic_store (&current, std::shared_ptr <weights_map const> (std::make_shared <weights_map> (std::move (weights_a))));
+}
+
+std::shared_ptr <rai::rep_weights::weights_map const> rai::rep_weights::snapshot ()
+{
+	return std::atomic_load (&current);
+}
+
+void rai::rep_weights::commit_prepare ()
+{
+	if (staged_transaction != nullptr)
+	{
+		std::lock_guard <std::mutex> lock (mutex);
+		for (auto & i : staged)
+		{
+			committed [i.first] = i.second;
 		}
+		committed_pending = true;
+		staged.clear ();
+		staged_transaction = nullptr;
+	}
+}
+
+void rai::rep_weights::commit_complete ()
+{
+	std::lock_guard <std::mutex> lock (mutex);
+	if (committed_pending)
+	{
+		// Copy on write, readers holding the previous map are unaffected
+		auto weights (std::make_shared <weights_map> (*current));
+		for (auto & i : committed)
+		{
+			(*weights) [i.first] = i.second;
+		}
+		std::atomic_store (&current, std::shared_ptr <weights_map const> (weights));
+		committed.clear ();
+		committed_pending = false;
 	}
 }
 
@@ -524,7 +669,13 @@ int rai::block_store::version_get (MDB_txn * transaction_a)
 
 void rai::block_store::do_upgrades (MDB_txn * transaction_a)
 {
-	switch (version_get (transaction_a))
+	auto version (version_get (transaction_a));
+	if (version < 11)
+	{
+		// Earlier upgrades read blocks through block_get so the per-type tables are merged first
+		upgrade_v10_to_v11 (transaction_a);
+	}
+	switch (version)
 	{
 		case 1:
 			upgrade_v1_to_v2 (transaction_a);
@@ -545,6 +696,10 @@ void rai::block_store::do_upgrades (MDB_txn * transaction_a)
 		case 9:
 			upgrade_v9_to_v10 (transaction_a);
 		case 10:
+			version_put (transaction_a, 11);
+		case 11:
+			upgrade_v11_to_v12 (transaction_a);
+		case 12:
 			break;
 		default:
 		assert (false);
@@ -792,6 +947,317 @@ void rai::block_store::clear (MDB_dbi db_a)
 	assert (status == 0);
 }
 
+namespace
+{
+char const snapshot_magic [8] = { 'r', 'a', 'i', 's', 'n', 'a', 'p', '\0' };
+uint8_t const snapshot_version (1);
+// No ledger table holds values anywhere near this size, anything larger is a corrupt stream
+uint32_t const snapshot_max_value (64 * 1024);
+// Every byte before the trailing digest passes through the hash
+class snapshot_writer
+{
+public:
+	snapshot_writer (std::ostream & stream_a) :
+	stream (stream_a)
+	{
+		blake2b_init (&hash, sizeof (rai::uint256_union));
+	}
+	void write (void const * data_a, size_t size_a)
+	{
+		blake2b_update (&hash, reinterpret_cast <uint8_t const *> (data_a), size_a);
+		stream.write (reinterpret_cast <char const *> (data_a), size_a);
+	}
+	template <typename T>
+	void write (T const & value_a)
+	{
+		static_assert (std::is_pod <T>::value, "Can't write non-pod type");
+		write (&value_a, sizeof (value_a));
+	}
+	rai::uint256_union digest ()
+	{
+		rai::uint256_union result;
+		blake2b_final (&hash, result.bytes.data (), sizeof (result.bytes));
+		return result;
+	}
+	std::ostream & stream;
+	blake2b_state hash;
+};
+class snapshot_reader
+{
+public:
+	snapshot_reader (std::istream & stream_a) :
+	stream (stream_a)
+	{
+		blake2b_init (&hash, sizeof (rai::uint256_union));
+	}
+	// Returns true if the stream ended early
+	bool read (void * data_a, size_t size_a)
+	{
+		stream.read (reinterpret_cast <char *> (data_a), size_a);
+		auto result (static_cast <size_t> (stream.gcount ()) != size_a);
+		if (!result)
+		{
+			blake2b_update (&hash, reinterpret_cast <uint8_t const *> (data_a), size_a);
+		}
+		return result;
+	}
+	template <typename T>
+	bool read (T & value_a)
+	{
+		static_assert (std::is_pod <T>::value, "Can't read non-pod type");
+		return read (&value_a, sizeof (value_a));
+	}
+	rai::uint256_union digest ()
+	{
+		rai::uint256_union result;
+		blake2b_final (&hash, result.bytes.data (), sizeof (result.bytes));
+		return result;
+	}
+	std::istream & stream;
+	blake2b_state hash;
+};
+}
+
+// Magic, format version, store version and block counts, then each table as a table index and entry count followed by size prefixed keys and values in key order.
+// Ends with the xor of all account heads, which is what ledger::checksum tracks, and a blake2b digest of everything before it.
+bool rai::block_store::snapshot_export (MDB_txn * transaction_a, std::ostream & stream_a)
+{
+	snapshot_writer writer (stream_a);
+	writer.write (snapshot_magic, sizeof (snapshot_magic));
+	writer.write (snapshot_version);
+	writer.write (static_cast <int32_t> (version_get (transaction_a)));
+	auto counts (block_count (transaction_a));
+	for (auto count : { counts.send, counts.receive, counts.open, counts.change })
+	{
+		writer.write (static_cast <uint64_t> (count));
+	}
+	rai::checksum heads (0);
+	std::array <MDB_dbi, 6> tables ({{ blocks, frontiers, accounts, pending, blocks_info, representation }});
+	for (uint8_t table (0); table < tables.size () && stream_a.good (); ++table)
+	{
+		MDB_stat stats;
+		auto status (mdb_stat (transaction_a, tables [table], &stats));
+		assert (status == 0);
+		writer.write (table);
+		writer.write (static_cast <uint64_t> (stats.ms_entries));
+		for (rai::store_iterator i (transaction_a, tables [table]), n (nullptr); i != n; ++i)
+		{
+			writer.write (static_cast <uint32_t> (i->first.size ()));
+			writer.write (i->first.data (), i->first.size ());
+			writer.write (static_cast <uint32_t> (i->second.size ()));
+			writer.write (i->second.data (), i->second.size ());
+			if (tables [table] == accounts)
+			{
+				heads ^= rai::account_info (i->second).head;
+			}
+		}
+	}
+	writer.write (heads.bytes.data (), heads.bytes.size ());
+	auto digest (writer.digest ());
+	stream_a.write (reinterpret_cast <char const *> (digest.bytes.data ()), digest.bytes.size ());
+	stream_a.flush ();
+	return !stream_a.good ();
+}
+
+bool rai::block_store::snapshot_import (std::istream & stream_a)
+{
+	// Opened directly so a bad snapshot can be aborted instead of committed
+	MDB_txn * transaction;
+	auto result (mdb_txn_begin (environment, nullptr, 0, &transaction) != 0);
+	if (!result)
+	{
+		std::array <MDB_dbi, 6> tables ({{ blocks, frontiers, accounts, pending, blocks_info, representation }});
+		for (auto table : tables)
+		{
+			MDB_stat stats;
+			auto status (mdb_stat (transaction, table, &stats));
+			assert (status == 0);
+			result |= stats.ms_entries != 0;
+		}
+		snapshot_reader reader (stream_a);
+		std::array <char, sizeof (snapshot_magic)> magic;
+		uint8_t version;
+		int32_t store_version;
+		result = result || reader.read (magic.data (), magic.size ()) || !std::equal (magic.begin (), magic.end (), snapshot_magic);
+		result = result || reader.read (version) || version != snapshot_version;
+		result = result || reader.read (store_version) || store_version != version_get (transaction);
+		std::array <uint64_t, 4> counts;
+		for (auto & count : counts)
+		{
+			result = result || reader.read (count);
+		}
+		std::array <uint64_t, 6> entries;
+		// Blocks of each type in the same order as the header counts
+		std::array <uint64_t, 4> types ({{ 0, 0, 0, 0 }});
+		rai::checksum heads (0);
+		std::vector <uint8_t> key;
+		std::vector <uint8_t> value;
+		auto max_key (static_cast <uint32_t> (mdb_env_get_maxkeysize (environment)));
+		for (uint8_t table (0); !result && table < tables.size (); ++table)
+		{
+			uint8_t table_l;
+			result = reader.read (table_l) || table_l != table || reader.read (entries [table]);
+			for (uint64_t i (0); !result && i < entries [table]; ++i)
+			{
+				uint32_t key_size;
+				uint32_t value_size;
+				result = reader.read (key_size) || key_size == 0 || key_size > max_key;
+				if (!result)
+				{
+					key.resize (key_size);
+					result = reader.read (key.data (), key.size ()) || reader.read (value_size) || value_size > snapshot_max_value;
+				}
+				if (!result)
+				{
+					value.resize (value_size);
+					result = reader.read (value.data (), value.size ());
+				}
+				if (!result && tables [table] == blocks)
+				{
+					// Block values start with their type
+					result = value.empty ();
+					if (!result)
+					{
+						switch (static_cast <rai::block_type> (value [0]))
+						{
+							case rai::block_type::send:
+								++types [0];
+								break;
+							case rai::block_type::receive:
+								++types [1];
+								break;
+							case rai::block_type::open:
+								++types [2];
+								break;
+							case rai::block_type::change:
+								++types [3];
+								break;
+							default:
+								result = true;
+								break;
+						}
+					}
+				}
+				if (!result && tables [table] == accounts)
+				{
+					result = value.size () != sizeof (rai::account_info);
+					if (!result)
+					{
+						heads ^= rai::account_info (rai::mdb_val (value.size (), value.data ())).head;
+					}
+				}
+				if (!result)
+				{
+					// Entries arrive in key order so every insert lands at the end of the table without a search, out of order keys fail here
+					result = mdb_put (transaction, tables [table], rai::mdb_val (key.size (), key.data ()), rai::mdb_val (value.size (), value.data ()), MDB_APPEND) != 0;
+				}
+			}
+		}
+		rai::checksum heads_l;
+		result = result || reader.read (heads_l.bytes.data (), heads_l.bytes.size ()) || heads_l != heads;
+		if (!result)
+		{
+			auto digest (reader.digest ());
+			rai::uint256_union digest_l;
+			stream_a.read (reinterpret_cast <char *> (digest_l.bytes.data ()), digest_l.bytes.size ());
+			result = static_cast <size_t> (stream_a.gcount ()) != digest_l.bytes.size () || digest_l != digest;
+		}
+		result = result || types != counts || entries [1] != entries [2];
+		if (!result)
+		{
+			block_count_add (transaction, rai::block_type::send, counts [0]);
+			block_count_add (transaction, rai::block_type::receive, counts [1]);
+			block_count_add (transaction, rai::block_type::open, counts [2]);
+			block_count_add (transaction, rai::block_type::change, counts [3]);
+			checksum_put (transaction, 0, 0, heads);
+			result = mdb_txn_commit (transaction) != 0;
+		}
+		else
+		{
+			mdb_txn_abort (transaction);
+		}
+		if (!result)
+		{
+			mdb_env_sync (environment, 1);
+			rai::transaction transaction_l (environment, nullptr, false);
+			rep_weights_load (transaction_l);
+		}
+	}
+	return result;
+}
+
+void rai::block_store::upgrade_v10_to_v11 (MDB_txn * transaction_a)
+{
+	std::array <std::pair <char const *, rai::block_type>, 4> tables ({{
+		{"send", rai::block_type::send},
+		{"receive", rai::block_type::receive},
+		{"open", rai::block_type::open},
+		{"change", rai::block_type::change}
+	}});
+	for (auto & table: tables)
+	{
+		MDB_dbi database;
+		auto status (mdb_dbi_open (transaction_a, table.first, 0, &database));
+		assert (status == 0 || status == MDB_NOTFOUND);
+		if (status == 0)
+		{
+			int64_t count (0);
+			std::vector <uint8_t> data;
+			for (rai::store_iterator i (transaction_a, database), n (nullptr); i != n; ++i)
+			{
+				data.clear ();
+				data.push_back (static_cast <uint8_t> (table.second));
+				auto bytes (reinterpret_cast <uint8_t const *> (i->second.data ()));
+				data.insert (data.end (), bytes, bytes + i->second.size ());
+				block_put_raw (transaction_a, i->first.uint256 (), rai::mdb_val (data.size (), data.data ()));
+				++count;
+			}
+			block_count_add (transaction_a, table.second, count);
+			auto status2 (mdb_drop (transaction_a, database, 1));
+			assert (status2 == 0);
+		}
+	}
+}
+
+void rai::block_store::upgrade_v11_to_v12 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 12);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
+	{
+		rai::account account (i->first.uint256 ());
+		rai::account_info info (i->second);
+		uint64_t height (1);
+		// Walk forward from the open block so balances of earlier blocks are already in their sideband
+		for (auto hash (info.open_block); !hash.is_zero ();)
+		{
+			auto block (block_get (transaction_a, hash));
+			assert (block != nullptr);
+			auto source (block->source ());
+			if (source.is_zero () || source == rai::genesis_account || block_exists (transaction_a, source))
+			{
+				auto successor (block_successor (transaction_a, hash));
+				rai::uint128_t balance;
+				if (block->type () == rai::block_type::send)
+				{
+					balance = static_cast <rai::send_block &> (*block).hashables.balance.number ();
+				}
+				else
+				{
+					balance = block_balance (transaction_a, hash);
+				}
+				block_put (transaction_a, hash, *block, successor, rai::block_sideband (account, height, balance));
+				++height;
+				hash = successor;
+			}
+			else
+			{
+				// Balance can't be computed without the source, the rest of this chain keeps walking the ledger instead
+				hash.clear ();
+			}
+		}
+	}
+}
+
 namespace
 {
 // Fill in our predecessors
@@ -809,9 +1275,12 @@ public:
 		rai::block_type type;
 		auto value (store.block_get_raw (transaction, block_a.previous (), type));
 		assert (value.mv_size != 0);
-		std::vector <uint8_t> data (static_cast <uint8_t *> (value.mv_data), static_cast <uint8_t *> (value.mv_data) + value.mv_size);
-		std::copy (hash.bytes.begin (), hash.bytes.end (), data.end () - hash.bytes.size ());
-		store.block_put_raw (transaction, store.block_database (type), block_a.previous (), rai::mdb_val (data.size (), data.data()));
+		std::vector <uint8_t> data;
+		data.reserve (value.mv_size + 1);
+		data.push_back (static_cast <uint8_t> (type));
+		data.insert (data.end (), static_cast <uint8_t *> (value.mv_data), static_cast <uint8_t *> (value.mv_data) + value.mv_size);
+		std::copy (hash.bytes.begin (), hash.bytes.end (), data.begin () + 1 + block_size (type));
+		store.block_put_raw (transaction, block_a.previous (), rai::mdb_val (data.size (), data.data()));
 	}
 	void send_block (rai::send_block const & block_a) override
 	{
@@ -834,136 +1303,179 @@ public:
 };
 }
 
-MDB_dbi rai::block_store::block_database (rai::block_type type_a)
-{
-	MDB_dbi result;
-	switch (type_a)
-	{
-		case rai::block_type::send:
-			result = send_blocks;
-			break;
-		case rai::block_type::receive:
-			result = receive_blocks;
-			break;
-		case rai::block_type::open:
-			result = open_blocks;
-			break;
-		case rai::block_type::change:
-			result = change_blocks;
-			break;
-		default:
-			assert(false);
-			break;
-	}
-	return result;
-}
-
-void rai::block_store::block_put_raw (MDB_txn * transaction_a, MDB_dbi database_a, rai::block_hash const & hash_a, MDB_val value_a)
+rai::block_buffer::block_buffer () :
+transaction (nullptr),
+written (0),
+appended (0),
+flushes (0),
+time (0)
 {
-	auto status2 (mdb_put (transaction_a, database_a, rai::mdb_val (hash_a), &value_a, 0));
-	assert (status2 == 0);
 }
 
-void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block const & block_a, rai::block_hash const & successor_a)
+void rai::block_store::block_buffer_begin (MDB_txn * transaction_a)
 {
-	assert (successor_a.is_zero () || block_exists (transaction_a, successor_a));
-	std::vector <uint8_t> vector;
-	{
-		rai::vectorstream stream (vector);
-		block_a.serialize (stream);
-		rai::write (stream, successor_a.bytes);
-	}
-	block_put_raw (transaction_a, block_database (block_a.type ()), hash_a, {vector.size (), vector.data ()});
-	set_predecessor predecessor (transaction_a, *this);
-	block_a.visit (predecessor);
-	assert (block_a.previous ().is_zero () || block_successor (transaction_a, block_a.previous ()) == hash_a);
+	assert (block_buffer.transaction == nullptr || block_buffer.transaction == transaction_a);
+	block_buffer.transaction = transaction_a;
 }
 
-MDB_val rai::block_store::block_get_raw (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_type & type_a)
+void rai::block_store::block_buffer_flush (MDB_txn * transaction_a)
 {
-	rai::mdb_val result;
-	auto status (mdb_get (transaction_a, send_blocks, rai::mdb_val (hash_a), result));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	if (status != 0)
+	auto transaction (block_buffer.transaction.load ());
+	// Only one write transaction is open at a time so a buffer left over from another one was never flushed
+	assert (transaction == nullptr || transaction == transaction_a);
+	if (transaction != nullptr)
 	{
-		auto status (mdb_get (transaction_a, receive_blocks, rai::mdb_val (hash_a), result));
-		assert (status == 0 || status == MDB_NOTFOUND);
-		if (status != 0)
+		auto start (std::chrono::steady_clock::now ());
+		MDB_cursor * cursor;
+		auto status (mdb_cursor_open (transaction, blocks, &cursor));
+		assert (status == 0);
+		rai::mdb_val last;
+		rai::mdb_val junk;
+		auto status2 (mdb_cursor_get (cursor, last, junk, MDB_LAST));
+		assert (status2 == 0 || status2 == MDB_NOTFOUND);
+		auto empty (status2 == MDB_NOTFOUND);
+		rai::block_hash last_key (empty ? rai::block_hash (0) : last.uint256 ());
+		uint64_t appended (0);
+		for (auto & i : block_buffer.blocks)
 		{
-			auto status (mdb_get (transaction_a, open_blocks, rai::mdb_val (hash_a), result));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			if (status != 0)
+			rai::mdb_val key (i.first);
+			if (!i.second.empty ())
 			{
-				auto status (mdb_get (transaction_a, change_blocks, rai::mdb_val (hash_a), result));
-				assert (status == 0 || status == MDB_NOTFOUND);
-				if (status == 0)
-				{
-					type_a = rai::block_type::change;
-				}
+				// Keys arrive in order so once one is past the end of the table every following one is too
+				auto append (empty || last_key < i.first);
+				MDB_val value {i.second.size (), i.second.data ()};
+				auto status3 (mdb_cursor_put (cursor, key, &value, append ? MDB_APPEND : 0));
+				assert (status3 == 0);
+				appended += append ? 1 : 0;
 			}
 			else
 			{
-				type_a = rai::block_type::open;
+				// Blocks added and removed within the transaction were never written
+				auto status3 (mdb_cursor_get (cursor, key, junk, MDB_SET));
+				assert (status3 == 0 || status3 == MDB_NOTFOUND);
+				if (status3 == 0)
+				{
+					auto status4 (mdb_cursor_del (cursor, 0));
+					assert (status4 == 0);
+				}
 			}
 		}
-		else
-		{
-			type_a = rai::block_type::receive;
-		}
+		mdb_cursor_close (cursor);
+		block_buffer.written += block_buffer.blocks.size ();
+		block_buffer.appended += appended;
+		++block_buffer.flushes;
+		block_buffer.time += std::chrono::duration_cast <std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count ();
+		block_buffer.blocks.clear ();
+		block_buffer.transaction = nullptr;
+	}
+}
+
+namespace
+{
+// Looks in the transaction's staged blocks before the table, returns the mdb status
+int block_raw_get (MDB_txn * transaction_a, MDB_dbi blocks_a, rai::block_buffer & buffer_a, rai::block_hash const & hash_a, rai::mdb_val & value_a)
+{
+	int result;
+	auto existing (transaction_a == buffer_a.transaction ? buffer_a.blocks.find (hash_a) : buffer_a.blocks.end ());
+	if (existing != buffer_a.blocks.end ())
+	{
+		result = existing->second.empty () ? MDB_NOTFOUND : 0;
+		value_a.value = {existing->second.size (), existing->second.data ()};
 	}
 	else
 	{
-		type_a = rai::block_type::send;
+		result = mdb_get (transaction_a, blocks_a, rai::mdb_val (hash_a), value_a);
 	}
 	return result;
 }
+}
 
-std::unique_ptr <rai::block> rai::block_store::block_random (MDB_txn * transaction_a, MDB_dbi database)
+void rai::block_store::block_put_raw (MDB_txn * transaction_a, rai::block_hash const & hash_a, MDB_val value_a)
 {
-	rai::block_hash hash;
-	rai::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
-	rai::store_iterator existing (transaction_a, database, rai::mdb_val (hash));
-	if (existing == rai::store_iterator (nullptr))
+	if (transaction_a == block_buffer.transaction)
 	{
-		existing = rai::store_iterator (transaction_a, database);
+		auto data (reinterpret_cast <uint8_t const *> (value_a.mv_data));
+		block_buffer.blocks [hash_a].assign (data, data + value_a.mv_size);
+	}
+	else
+	{
+		auto status2 (mdb_put (transaction_a, blocks, rai::mdb_val (hash_a), &value_a, 0));
+		assert (status2 == 0);
 	}
-	assert (existing != rai::store_iterator (nullptr));
-	return block_get (transaction_a, rai::block_hash (existing->first.uint256 ()));
 }
 
-std::unique_ptr <rai::block> rai::block_store::block_random (MDB_txn * transaction_a)
+void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block const & block_a, rai::block_hash const & successor_a, rai::block_sideband const & sideband_a)
 {
-	auto count (block_count (transaction_a));
-	auto region (rai::random_pool.GenerateWord32 (0, count.sum () - 1));
-	std::unique_ptr <rai::block> result;
-	if (region < count.send)
+	assert (successor_a.is_zero () || block_exists (transaction_a, successor_a));
+	std::vector <uint8_t> vector;
+	{
+		rai::vectorstream stream (vector);
+		rai::write (stream, block_a.type ());
+		block_a.serialize (stream);
+		rai::write (stream, successor_a.bytes);
+		sideband_a.serialize (stream);
+	}
+	// Only count blocks that weren't already stored, rewriting a block to change its successor or work leaves the counts alone
+	auto inserted (false);
+	if (transaction_a == block_buffer.transaction)
 	{
-		result = block_random (transaction_a, send_blocks);
+		rai::mdb_val junk;
+		inserted = block_raw_get (transaction_a, blocks, block_buffer, hash_a, junk) == MDB_NOTFOUND;
+		block_buffer.blocks [hash_a] = std::move (vector);
 	}
 	else
 	{
-		region -= count.send;
-		if (region < count.receive)
+		MDB_val value {vector.size (), vector.data ()};
+		auto status (mdb_put (transaction_a, blocks, rai::mdb_val (hash_a), &value, MDB_NOOVERWRITE));
+		if (status == MDB_KEYEXIST)
 		{
-			result = block_random (transaction_a, receive_blocks);
+			block_put_raw (transaction_a, hash_a, {vector.size (), vector.data ()});
 		}
 		else
 		{
-			region -= count.receive;
-			if (region < count.open)
-			{
-				result = block_random (transaction_a, open_blocks);
-			}
-			else
-			{
-				// change
-				result = block_random (transaction_a, change_blocks);
-			}
+			assert (status == 0);
+			inserted = true;
 		}
 	}
+	if (inserted)
+	{
+		block_count_add (transaction_a, block_a.type (), 1);
+	}
+	set_predecessor predecessor (transaction_a, *this);
+	block_a.visit (predecessor);
+	assert (block_a.previous ().is_zero () || block_successor (transaction_a, block_a.previous ()) == hash_a);
+}
+
+MDB_val rai::block_store::block_get_raw (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_type & type_a)
+{
+	rai::mdb_val value;
+	auto status (block_raw_get (transaction_a, blocks, block_buffer, hash_a, value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	MDB_val result {0, nullptr};
+	if (status == 0)
+	{
+		assert (value.value.mv_size > 1);
+		auto data (reinterpret_cast <uint8_t *> (value.value.mv_data));
+		type_a = static_cast <rai::block_type> (data [0]);
+		result.mv_size = value.value.mv_size - 1;
+		result.mv_data = data + 1;
+	}
 	return result;
 }
 
+std::unique_ptr <rai::block> rai::block_store::block_random (MDB_txn * transaction_a)
+{
+	rai::block_hash hash;
+	rai::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
+	rai::store_iterator existing (transaction_a, blocks, rai::mdb_val (hash));
+	if (existing == rai::store_iterator (nullptr))
+	{
+		existing = rai::store_iterator (transaction_a, blocks);
+	}
+	assert (existing != rai::store_iterator (nullptr));
+	return block_get (transaction_a, rai::block_hash (existing->first.uint256 ()));
+}
+
 rai::block_hash rai::block_store::block_successor (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
 	rai::block_type type;
@@ -971,8 +1483,9 @@ rai::block_hash rai::block_store::block_successor (MDB_txn * transaction_a, rai:
 	rai::block_hash result;
 	if (value.mv_size != 0)
 	{
-		assert (value.mv_size >= result.bytes.size ());
-		rai::bufferstream stream (reinterpret_cast <uint8_t const *> (value.mv_data) + value.mv_size - result.bytes.size (), result.bytes.size ());
+		auto offset (block_size (type));
+		assert (value.mv_size >= offset + result.bytes.size ());
+		rai::bufferstream stream (reinterpret_cast <uint8_t const *> (value.mv_data) + offset, result.bytes.size ());
 		auto error (rai::read (stream, result.bytes));
 		assert (!error);
 	}
@@ -985,11 +1498,12 @@ rai::block_hash rai::block_store::block_successor (MDB_txn * transaction_a, rai:
 
 void rai::block_store::block_successor_clear (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto block (block_get (transaction_a, hash_a));
-	block_put (transaction_a, hash_a, *block);
+	rai::block_sideband sideband;
+	auto block (block_get (transaction_a, hash_a, &sideband));
+	block_put (transaction_a, hash_a, *block, 0, sideband);
 }
 
-std::unique_ptr <rai::block> rai::block_store::block_get (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+std::unique_ptr <rai::block> rai::block_store::block_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_sideband * sideband_a)
 {
 	rai::block_type type;
 	auto value (block_get_raw (transaction_a, hash_a, type));
@@ -999,81 +1513,101 @@ std::unique_ptr <rai::block> rai::block_store::block_get (MDB_txn * transaction_
 		rai::bufferstream stream (reinterpret_cast <uint8_t const *> (value.mv_data), value.mv_size);
 		result = rai::deserialize_block (stream, type);
 		assert (result != nullptr);
+		if (sideband_a != nullptr)
+		{
+			rai::block_hash successor;
+			auto error (rai::read (stream, successor.bytes));
+			assert (!error);
+			// Blocks written before the sideband was back-filled end at the successor
+			if (sideband_a->deserialize (stream))
+			{
+				*sideband_a = rai::block_sideband ();
+			}
+		}
 	}
 	return result;
 }
 
-void rai::block_store::block_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+bool rai::block_store::block_sideband_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_sideband & sideband_a)
 {
-	auto status (mdb_del (transaction_a, send_blocks, rai::mdb_val (hash_a), nullptr));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	if (status != 0)
+	rai::block_type type;
+	auto value (block_get_raw (transaction_a, hash_a, type));
+	auto result (true);
+	if (value.mv_size != 0)
 	{
-		auto status (mdb_del (transaction_a, receive_blocks, rai::mdb_val (hash_a), nullptr));
-		assert (status == 0 || status == MDB_NOTFOUND);
-		if (status != 0)
+		auto offset (block_size (type) + sizeof (rai::block_hash));
+		if (value.mv_size >= offset + rai::block_sideband::size)
 		{
-			auto status (mdb_del (transaction_a, open_blocks, rai::mdb_val (hash_a), nullptr));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			if (status != 0)
-			{
-				auto status (mdb_del (transaction_a, change_blocks, rai::mdb_val (hash_a), nullptr));
-				assert (status == 0);
-			}
+			rai::bufferstream stream (reinterpret_cast <uint8_t const *> (value.mv_data) + offset, value.mv_size - offset);
+			result = sideband_a.deserialize (stream);
+			result = result || sideband_a.height == 0;
 		}
 	}
+	return result;
+}
+
+void rai::block_store::block_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	rai::block_type type;
+	auto value (block_get_raw (transaction_a, hash_a, type));
+	assert (value.mv_size != 0);
+	if (transaction_a == block_buffer.transaction)
+	{
+		block_buffer.blocks [hash_a].clear ();
+	}
+	else
+	{
+		auto status (mdb_del (transaction_a, blocks, rai::mdb_val (hash_a), nullptr));
+		assert (status == 0);
+	}
+	block_count_add (transaction_a, type, -1);
 }
 
 bool rai::block_store::block_exists (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto result (true);
 	rai::mdb_val junk;
-	auto status (mdb_get (transaction_a, send_blocks, rai::mdb_val (hash_a), junk));
+	auto status (block_raw_get (transaction_a, blocks, block_buffer, hash_a, junk));
 	assert (status == 0 || status == MDB_NOTFOUND);
-	result = status == 0;
-	if (!result)
+	return status == 0;
+}
+
+namespace
+{
+size_t block_count_get (MDB_txn * transaction_a, MDB_dbi meta_a, rai::block_type type_a)
+{
+	rai::uint256_union count_key (static_cast <uint64_t> (type_a));
+	rai::mdb_val data;
+	auto status (mdb_get (transaction_a, meta_a, rai::mdb_val (count_key), data));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	size_t result (0);
+	if (status == 0)
 	{
-		auto status (mdb_get (transaction_a, receive_blocks, rai::mdb_val (hash_a), junk));
-		assert (status == 0 || status == MDB_NOTFOUND);
-		result = status == 0;
-		if (!result)
-		{
-			auto status (mdb_get (transaction_a, open_blocks, rai::mdb_val (hash_a), junk));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			result = status == 0;
-			if (!result)
-			{
-				auto status (mdb_get (transaction_a, change_blocks, rai::mdb_val (hash_a), junk));
-				assert (status == 0 || status == MDB_NOTFOUND);
-				result = status == 0;
-			}
-		}
+		result = data.uint256 ().number ().convert_to <size_t> ();
 	}
 	return result;
 }
+}
 
 rai::block_counts rai::block_store::block_count (MDB_txn * transaction_a)
 {
 	rai::block_counts result;
-	MDB_stat send_stats;
-	auto status1 (mdb_stat (transaction_a, send_blocks, &send_stats));
-	assert (status1 == 0);
-	MDB_stat receive_stats;
-	auto status2 (mdb_stat (transaction_a, receive_blocks, &receive_stats));
-	assert (status2 == 0);
-	MDB_stat open_stats;
-	auto status3 (mdb_stat (transaction_a, open_blocks, &open_stats));
-	assert (status3 == 0);
-	MDB_stat change_stats;
-	auto status4 (mdb_stat (transaction_a, change_blocks, &change_stats));
-	assert (status4 == 0);
-	result.send = send_stats.ms_entries;
-	result.receive = receive_stats.ms_entries;
-	result.open = open_stats.ms_entries;
-	result.change = change_stats.ms_entries;
+	result.send = block_count_get (transaction_a, meta, rai::block_type::send);
+	result.receive = block_count_get (transaction_a, meta, rai::block_type::receive);
+	result.open = block_count_get (transaction_a, meta, rai::block_type::open);
+	result.change = block_count_get (transaction_a, meta, rai::block_type::change);
 	return result;
 }
 
+void rai::block_store::block_count_add (MDB_txn * transaction_a, rai::block_type type_a, int64_t amount_a)
+{
+	auto count (block_count_get (transaction_a, meta, type_a));
+	assert (amount_a >= 0 || count >= static_cast <size_t> (-amount_a));
+	rai::uint256_union count_key (static_cast <uint64_t> (type_a));
+	rai::uint256_union count_value (static_cast <uint64_t> (count + amount_a));
+	auto status (mdb_put (transaction_a, meta, rai::mdb_val (count_key), rai::mdb_val (count_value), 0));
+	assert (status == 0);
+}
+
 void rai::block_store::account_del (MDB_txn * transaction_a, rai::account const & account_a)
 {
 	auto status (mdb_del (transaction_a, accounts, rai::mdb_val (account_a), nullptr));
@@ -1353,6 +1887,46 @@ balance (0)
 {
 }
 
+rai::block_sideband::block_sideband () :
+account (0),
+height (0),
+balance (0)
+{
+}
+
+rai::block_sideband::block_sideband (rai::account const & account_a, uint64_t height_a, rai::amount const & balance_a) :
+account (account_a),
+height (height_a),
+balance (balance_a)
+{
+}
+
+void rai::block_sideband::serialize (rai::stream & stream_a) const
+{
+	rai::write (stream_a, account.bytes);
+	rai::write (stream_a, height);
+	rai::write (stream_a, balance.bytes);
+}
+
+bool rai::block_sideband::deserialize (rai::stream & stream_a)
+{
+	auto result (rai::read (stream_a, account.bytes));
+	if (!result)
+	{
+		result = rai::read (stream_a, height);
+		if (!result)
+		{
+			result = rai::read (stream_a, balance.bytes);
+		}
+	}
+	return result;
+}
+
+bool rai::block_sideband::operator == (rai::block_sideband const & other_a) const
+{
+	return account == other_a.account && height == other_a.height && balance == other_a.balance;
+}
+
 rai::block_info::block_info (MDB_val const & val_a)
 {
 	assert(val_a.mv_size == sizeof (*this));
@@ -1394,23 +1968,7 @@ rai::mdb_val rai::block_info::val () const
 
 rai::uint128_t rai::block_store::representation_get (MDB_txn * transaction_a, rai::account const & account_a)
 {
-	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, representation, rai::mdb_val (account_a), value));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	rai::uint128_t result;
-	if (status == 0)
-	{
-		rai::uint128_union rep;
-		rai::bufferstream stream (reinterpret_cast <uint8_t const *> (value.data ()), value.size ());
-		auto error (rai::read (stream, rep));
-		assert (!error);
-		result = rep.number ();
-	}
-	else
-	{
-		result = 0;
-	}
-	return result;
+	return rep_weights.get (transaction_a, account_a);
 }
 
 void rai::block_store::representation_put (MDB_txn * transaction_a, rai::account const & account_a, rai::uint128_t const & representation_a)
@@ -1418,6 +1976,7 @@ void rai::block_store::representation_put (MDB_txn * transaction_a, rai::account
 	rai::uint128_union rep (representation_a);
 	auto status (mdb_put (transaction_a, representation, rai::mdb_val (account_a), rai::mdb_val (rep), 0));
 	assert (status == 0);
+	rep_weights.put (transaction_a, account_a, representation_a);
 }
 
 rai::store_iterator rai::block_store::representation_begin (MDB_txn * transaction_a)
@@ -1432,16 +1991,156 @@ rai::store_iterator rai::block_store::representation_end ()
 	return result;
 }
 
+rai::unchecked_pool::unchecked_pool () :
+max (65536),
+spilled (0)
+{
+}
+
 void rai::block_store::unchecked_clear (MDB_txn * transaction_a)
 {
+	{
+		std::lock_guard <std::mutex> lock (cache_mutex);
+		unchecked_pool.blocks.clear ();
+	}
 	auto status (mdb_drop (transaction_a, unchecked, 0));
 	assert (status == 0);
 }
 
+namespace
+{
+void unchecked_write (MDB_txn * transaction_a, MDB_dbi unchecked_a, rai::unchecked_info const & info_a, std::vector <uint8_t> & buffer_a)
+{
+	buffer_a.clear ();
+	{
+		rai::vectorstream stream (buffer_a);
+		rai::serialize_block (stream, *info_a.block);
+	}
+	auto status (mdb_put (transaction_a, unchecked_a, rai::mdb_val (info_a.dependency), rai::mdb_val (buffer_a.size (), buffer_a.data ()), 0));
+	assert (status == 0);
+}
+}
+
 void rai::block_store::unchecked_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, std::shared_ptr <rai::block> const & block_a)
+{
+	unchecked_pool_put (transaction_a, hash_a, block_a);
+	unchecked_trim (transaction_a);
+}
+
+void rai::block_store::unchecked_pool_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, std::shared_ptr <rai::block> const & block_a)
+{
+	std::vector <uint8_t> vector;
+	{
+		rai::vectorstream stream (vector);
+		rai::serialize_block (stream, *block_a);
+	}
+	std::lock_guard <std::mutex> lock (cache_mutex);
+	auto & dependencies (unchecked_pool.blocks.get <1> ());
+	auto existing (dependencies.equal_range (hash_a));
+	if (std::none_of (existing.first, existing.second, [&block_a] (rai::unchecked_info const & info_a) { return *info_a.block == *block_a; }))
+	{
+		// A block spilled earlier and sent again would otherwise be processed twice once its dependency arrives
+		MDB_cursor * cursor;
+		auto status (mdb_cursor_open (transaction_a, unchecked, &cursor));
+		assert (status == 0);
+		rai::mdb_val key (hash_a);
+		rai::mdb_val value (vector.size (), vector.data ());
+		auto status2 (mdb_cursor_get (cursor, key, value, MDB_GET_BOTH));
+		assert (status2 == 0 || status2 == MDB_NOTFOUND);
+		mdb_cursor_close (cursor);
+		if (status2 == MDB_NOTFOUND)
+		{
+			unchecked_pool.blocks.insert (rai::unchecked_info {std::chrono::system_clock::now (), hash_a, block_a->hash (), block_a});
+		}
+	}
+}
+
+void rai::block_store::unchecked_trim (MDB_txn * transaction_a)
+{
+	std::lock_guard <std::mutex> lock (cache_mutex);
+	if (unchecked_pool.blocks.size () > unchecked_pool.max)
+	{
+		// Spill an eighth of the pool at once so a full pool doesn't write on every insert
+		auto target (unchecked_pool.max - unchecked_pool.max / 8);
+		auto & arrivals (unchecked_pool.blocks.get <0> ());
+		std::vector <uint8_t> buffer;
+		while (arrivals.size () > target)
+		{
+			unchecked_write (transaction_a, unchecked, *arrivals.begin (), buffer);
+			arrivals.erase (arrivals.begin ());
+			++unchecked_pool.spilled;
+		}
+	}
+}
+
+void rai::block_store::unchecked_spill (MDB_txn * transaction_a, std::chrono::system_clock::time_point const & cutoff_a)
+{
+	std::lock_guard <std::mutex> lock (cache_mutex);
+	auto & arrivals (unchecked_pool.blocks.get <0> ());
+	std::vector <uint8_t> buffer;
+	for (auto i (arrivals.begin ()), n (arrivals.end ()); i != n && i->arrival < cutoff_a; i = arrivals.erase (i))
+	{
+		unchecked_write (transaction_a, unchecked, *i, buffer);
+		++unchecked_pool.spilled;
+	}
+}
+
+std::vector <std::shared_ptr <rai::block>> rai::block_store::unchecked_pooled (size_t count_a)
+{
+	std::vector <std::shared_ptr <rai::block>> result;
+	std::lock_guard <std::mutex> lock (cache_mutex);
+	for (auto i (unchecked_pool.blocks.begin ()), n (unchecked_pool.blocks.end ()); i != n && result.size () < count_a; ++i)
+	{
+		result.push_back (i->block);
+	}
+	return result;
+}
+
+std::vector <rai::unchecked_info> rai::block_store::unchecked_pooled (rai::block_hash const & key_a, size_t count_a)
+{
+	std::vector <rai::unchecked_info> result;
+	{
+		std::lock_guard <std::mutex> lock (cache_mutex);
+		for (auto & i : unchecked_pool.blocks)
+		{
+			if (!(i.dependency < key_a))
+			{
+				result.push_back (i);
+			}
+		}
+	}
+	std::stable_sort (result.begin (), result.end (), [] (rai::unchecked_info const & a, rai::unchecked_info const & b) { return a.dependency < b.dependency; });
+	if (result.size () > count_a)
+	{
+		result.erase (result.begin () + count_a, result.end ());
+	}
+	return result;
+}
+
+std::vector <std::shared_ptr <rai::block>> rai::block_store::unchecked_pool_take (rai::block_hash const & hash_a)
+{
+	std::vector <std::shared_ptr <rai::block>> result;
+	std::lock_guard <std::mutex> lock (cache_mutex);
+	auto & dependencies (unchecked_pool.blocks.get <1> ());
+	auto existing (dependencies.equal_range (hash_a));
+	for (auto i (existing.first); i != existing.second; ++i)
+	{
+		result.push_back (i->block);
+	}
+	dependencies.erase (existing.first, existing.second);
+	return result;
+}
+
+size_t rai::block_store::unchecked_pool_size ()
+{
+	std::lock_guard <std::mutex> lock (cache_mutex);
+	return unchecked_pool.blocks.size ();
+}
+
+uint64_t rai::block_store::unchecked_pool_spilled ()
 {
 	std::lock_guard <std::mutex> lock (cache_mutex);
-	unchecked_cache.insert (std::make_pair (hash_a, block_a));
+	return unchecked_pool.spilled;
 }
 
 std::vector <std::shared_ptr <rai::block>> rai::block_store::unchecked_get (MDB_txn * transaction_a, rai::block_hash const & hash_a)
@@ -1449,9 +2148,10 @@ std::vector <std::shared_ptr <rai::block>> rai::block_store::unchecked_get (MDB_
 	std::vector <std::shared_ptr <rai::block>> result;
 	{
 		std::lock_guard <std::mutex> lock (cache_mutex);
-		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a; ++i)
+		auto existing (unchecked_pool.blocks.get <1> ().equal_range (hash_a));
+		for (auto i (existing.first); i != existing.second; ++i)
 		{
-			result.push_back (i->second);
+			result.push_back (i->block);
 		}
 	}
 	for (auto i (unchecked_begin (transaction_a, hash_a)), n (unchecked_end ()); i != n && rai::block_hash (i->first.uint256 ()) == hash_a; i.next_dup ())
@@ -1466,11 +2166,13 @@ void rai::block_store::unchecked_del (MDB_txn * transaction_a, rai::block_hash c
 {
 	{
 		std::lock_guard <std::mutex> lock (cache_mutex);
-		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a;)
+		auto & dependencies (unchecked_pool.blocks.get <1> ());
+		auto existing (dependencies.equal_range (hash_a));
+		for (auto i (existing.first); i != existing.second;)
 		{
-			if (*i->second == block_a)
+			if (*i->block == block_a)
 			{
-				i = unchecked_cache.erase (i);
+				i = dependencies.erase (i);
 			}
 			else
 			{
@@ -1487,6 +2189,29 @@ void rai::block_store::unchecked_del (MDB_txn * transaction_a, rai::block_hash c
 	assert (status == 0 || status == MDB_NOTFOUND);
 }
 
+std::shared_ptr <rai::block> rai::block_store::unchecked_find (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	std::shared_ptr <rai::block> result;
+	{
+		std::lock_guard <std::mutex> lock (cache_mutex);
+		auto existing (unchecked_pool.blocks.get <2> ().find (hash_a));
+		if (existing != unchecked_pool.blocks.get <2> ().end ())
+		{
+			result = existing->block;
+		}
+	}
+	for (auto i (unchecked_begin (transaction_a)), n (unchecked_end ()); i != n && result == nullptr; ++i)
+	{
+		rai::bufferstream stream (reinterpret_cast <uint8_t const *> (i->second.data ()), i->second.size ());
+		auto block (rai::deserialize_block (stream));
+		if (block->hash () == hash_a)
+		{
+			result = block;
+		}
+	}
+	return result;
+}
+
 rai::store_iterator rai::block_store::unchecked_begin (MDB_txn * transaction_a)
 {
     rai::store_iterator result (transaction_a, unchecked);
@@ -1506,6 +2231,11 @@ rai::store_iterator rai::block_store::unchecked_end ()
 }
 
 size_t rai::block_store::unchecked_count (MDB_txn * transaction_a)
+{
+	return unchecked_stored (transaction_a) + unchecked_pool_size ();
+}
+
+size_t rai::block_store::unchecked_stored (MDB_txn * transaction_a)
 {
 	MDB_stat unchecked_stats;
 	auto status (mdb_stat (transaction_a, unchecked, &unchecked_stats));
@@ -1586,24 +2316,18 @@ void rai::block_store::checksum_del (MDB_txn * transaction_a, uint64_t prefix, u
 }
 
 void rai::block_store::flush (MDB_txn * transaction_a)
+{
+	flush (transaction_a, std::chrono::system_clock::time_point::max ());
+}
+
+void rai::block_store::flush (MDB_txn * transaction_a, std::chrono::system_clock::time_point const & cutoff_a)
 {
 	std::unordered_map <rai::account, std::shared_ptr <rai::vote>> sequence_cache_l;
-	std::unordered_multimap <rai::block_hash, std::shared_ptr <rai::block>> unchecked_cache_l;
 	{
 		std::lock_guard <std::mutex> lock (cache_mutex);
 		sequence_cache_l.swap (vote_cache);
-		unchecked_cache_l.swap (unchecked_cache);
-	}
-	for (auto &i: unchecked_cache_l)
-	{
-		std::vector <uint8_t> vector;
-		{
-			rai::vectorstream stream (vector);
-			rai::serialize_block (stream, *i.second);
-		}
-		auto status (mdb_put (transaction_a, unchecked, rai::mdb_val (i.first), rai::mdb_val (vector.size (), vector.data ()), 0));
-		assert (status == 0);
 	}
+	unchecked_spill (transaction_a, cutoff_a);
 	for (auto i (sequence_cache_l.begin ()), n (sequence_cache_l.end ()); i != n; ++i)
 	{
 		std::vector <uint8_t> vector;
@@ -1688,12 +2412,18 @@ rai::vote_result rai::block_store::vote_validate (MDB_txn * transaction_a, std::
 	// Reject unsigned votes
 	if (!rai::validate_message (vote_a->account, vote_a->hash (), vote_a->signature))
 	{
-		result.code = rai::vote_code::replay;
-		result.vote = vote_max (transaction_a, vote_a);		// Make sure this sequence number is > any we've seen from this account before
-		if (result.vote == vote_a)
-		{
-			result.code = rai::vote_code::vote;
-		}
+		result = vote_sequence (transaction_a, vote_a);
+	}
+	return result;
+}
+
+rai::vote_result rai::block_store::vote_sequence (MDB_txn * transaction_a, std::shared_ptr <rai::vote> vote_a)
+{
+	rai::vote_result result ({rai::vote_code::replay, 0});
+	result.vote = vote_max (transaction_a, vote_a);		// Make sure this sequence number is > any we've seen from this account before
+	if (result.vote == vote_a)
+	{
+		result.code = rai::vote_code::vote;
 	}
 	return result;
 }
@@ -1792,13 +2522,16 @@ namespace
 class ledger_processor : public rai::block_visitor
 {
 public:
-    ledger_processor (rai::ledger &, MDB_txn *);
+    ledger_processor (rai::ledger &, MDB_txn *, rai::account const &);
     void send_block (rai::send_block const &) override;
     void receive_block (rai::receive_block const &) override;
     void open_block (rai::open_block const &) override;
     void change_block (rai::change_block const &) override;
+	bool signature_invalid (rai::account const &, rai::block_hash const &, rai::signature const &);
     rai::ledger & ledger;
 	MDB_txn * transaction;
+	// Account whose signature on this block was already checked by the caller, zero if unchecked
+	rai::account verified;
     rai::process_return result;
 };
 
@@ -2045,9 +2778,18 @@ void balance_visitor::compute (rai::block_hash const & block_hash)
 	current = block_hash;
 	while (!current.is_zero ())
 	{
-		auto block (store.block_get (transaction, current));
+		rai::block_sideband sideband;
+		auto block (store.block_get (transaction, current, &sideband));
 		assert (block != nullptr);
-		block->visit (*this);
+		if (sideband.height != 0)
+		{
+			result += sideband.balance.number ();
+			current = 0;
+		}
+		else
+		{
+			block->visit (*this);
+		}
 	}
 }
 
@@ -2093,7 +2835,12 @@ rai::uint128_t rai::ledger::account_pending (MDB_txn * transaction_a, rai::accou
 
 rai::process_return rai::ledger::process (MDB_txn * transaction_a, rai::block const & block_a)
 {
-	ledger_processor processor (*this, transaction_a);
+	return process (transaction_a, block_a, rai::account (0));
+}
+
+rai::process_return rai::ledger::process (MDB_txn * transaction_a, rai::block const & block_a, rai::account const & verified_a)
+{
+	ledger_processor processor (*this, transaction_a, verified_a);
 	block_a.visit (processor);
 	return processor.result;
 }
@@ -2172,25 +2919,34 @@ void rai::ledger::rollback (MDB_txn * transaction_a, rai::block_hash const & blo
 rai::account rai::ledger::account (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
 	assert (store.block_exists (transaction_a, hash_a));
-	auto hash (hash_a);
-	rai::block_hash successor (1);
-	rai::block_info block_info;
-	while (!successor.is_zero () && store.block_info_get (transaction_a, successor, block_info))
-	{
-		successor = store.block_successor (transaction_a, hash);
-		if (!successor.is_zero ())
-		{
-			hash = successor;
-		}
-	}
 	rai::account result;
-	if (successor.is_zero ())
+	rai::block_sideband sideband;
+	if (!store.block_sideband_get (transaction_a, hash_a, sideband))
 	{
-		result = store.frontier_get (transaction_a, hash);
+		result = sideband.account;
 	}
 	else
 	{
-		result = block_info.account;
+		// No sideband, walk successors until a block_info checkpoint or the frontier
+		auto hash (hash_a);
+		rai::block_hash successor (1);
+		rai::block_info block_info;
+		while (!successor.is_zero () && store.block_info_get (transaction_a, successor, block_info))
+		{
+			successor = store.block_successor (transaction_a, hash);
+			if (!successor.is_zero ())
+			{
+				hash = successor;
+			}
+		}
+		if (successor.is_zero ())
+		{
+			result = store.frontier_get (transaction_a, hash);
+		}
+		else
+		{
+			result = block_info.account;
+		}
 	}
 	assert (!result.is_zero ());
 	return result;
@@ -2199,9 +2955,24 @@ rai::account rai::ledger::account (MDB_txn * transaction_a, rai::block_hash cons
 // Return amount decrease or increase for block
 rai::uint128_t rai::ledger::amount (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-    amount_visitor amount (transaction_a, store);
-    amount.compute (hash_a);
-    return amount.result;
+	rai::uint128_t result;
+	rai::block_sideband sideband;
+	auto block (store.block_get (transaction_a, hash_a, &sideband));
+	rai::block_sideband previous;
+	auto previous_error (block != nullptr && !block->previous ().is_zero () && store.block_sideband_get (transaction_a, block->previous (), previous));
+	if (sideband.height != 0 && !previous_error)
+	{
+		auto balance (sideband.balance.number ());
+		auto previous_balance (previous.balance.number ());
+		result = balance > previous_balance ? balance - previous_balance : previous_balance - balance;
+	}
+	else
+	{
+		amount_visitor amount (transaction_a, store);
+		amount.compute (hash_a);
+		result = amount.result;
+	}
+	return result;
 }
 
 void rai::block_store::representation_add (MDB_txn * transaction_a, rai::block_hash const & source_a, rai::uint128_t const & amount_a)
@@ -2363,10 +3134,10 @@ void ledger_processor::change_block (rai::change_block const & block_a)
 				auto latest_error (ledger.store.account_get (transaction, account, info));
 				assert (!latest_error);
 				assert (info.head == block_a.hashables.previous);
-				result.code = validate_message (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Malformed)
+				result.code = signature_invalid (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Malformed)
 				if (result.code == rai::process_result::progress)
 				{
-					ledger.store.block_put (transaction, hash, block_a);
+					ledger.store.block_put (transaction, hash, block_a, 0, rai::block_sideband (account, info.block_count + 1, info.balance));
 					auto balance (ledger.balance (transaction, block_a.hashables.previous));
 					ledger.store.representation_add (transaction, hash, balance);
 					ledger.store.representation_add (transaction, info.rep_block, 0 - balance);
@@ -2396,7 +3167,7 @@ void ledger_processor::send_block (rai::send_block const & block_a)
 			result.code = account.is_zero () ? rai::process_result::fork : rai::process_result::progress;
 			if (result.code == rai::process_result::progress)
 			{
-				result.code = validate_message (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Malformed)
+				result.code = signature_invalid (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Malformed)
 				if (result.code == rai::process_result::progress)
 				{
 					rai::account_info info;
@@ -2408,7 +3179,7 @@ void ledger_processor::send_block (rai::send_block const & block_a)
 					{
 						auto amount (info.balance.number () - block_a.hashables.balance.number ());
 						ledger.store.representation_add (transaction, info.rep_block, 0 - amount);
-						ledger.store.block_put (transaction, hash, block_a);
+						ledger.store.block_put (transaction, hash, block_a, 0, rai::block_sideband (account, info.block_count + 1, block_a.hashables.balance));
 						ledger.change_latest (transaction, account, hash, info.rep_block, block_a.hashables.balance, info.block_count + 1);
 						ledger.store.pending_put (transaction, rai::pending_key (block_a.hashables.destination, hash), {account, amount});
 						ledger.store.frontier_del (transaction, block_a.hashables.previous);
@@ -2436,7 +3207,7 @@ void ledger_processor::receive_block (rai::receive_block const & block_a)
 			result.code = account.is_zero () ? rai::process_result::gap_previous : rai::process_result::progress;  //Have we seen the previous block? No entries for account at all (Harmless)
 			if (result.code == rai::process_result::progress)
 			{
-				result.code = rai::validate_message (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
+				result.code = signature_invalid (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
 				if (result.code == rai::process_result::progress)
 				{
 					rai::account_info info;
@@ -2454,7 +3225,7 @@ void ledger_processor::receive_block (rai::receive_block const & block_a)
                             auto error (ledger.store.account_get (transaction, pending.source, source_info));
                             assert (!error);
 							ledger.store.pending_del (transaction, key);
-							ledger.store.block_put (transaction, hash, block_a);
+							ledger.store.block_put (transaction, hash, block_a, 0, rai::block_sideband (account, info.block_count + 1, new_balance));
 							ledger.change_latest (transaction, account, hash, info.rep_block, new_balance, info.block_count + 1);
 							ledger.store.representation_add (transaction, info.rep_block, pending.amount.number ());
 							ledger.store.frontier_del (transaction, block_a.hashables.previous);
@@ -2484,7 +3255,7 @@ void ledger_processor::open_block (rai::open_block const & block_a)
         result.code = source_missing ? rai::process_result::gap_source : rai::process_result::progress; // Have we seen the source block? (Harmless)
         if (result.code == rai::process_result::progress)
         {
-			result.code = rai::validate_message (block_a.hashables.account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
+			result.code = signature_invalid (block_a.hashables.account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
 			if (result.code == rai::process_result::progress)
 			{
 				rai::account_info info;
@@ -2503,7 +3274,7 @@ void ledger_processor::open_block (rai::open_block const & block_a)
 							auto error (ledger.store.account_get (transaction, pending.source, source_info));
 							assert (!error);
 							ledger.store.pending_del (transaction, key);
-							ledger.store.block_put (transaction, hash, block_a);
+							ledger.store.block_put (transaction, hash, block_a, 0, rai::block_sideband (block_a.hashables.account, 1, pending.amount));
 							ledger.change_latest (transaction, block_a.hashables.account, hash, hash, pending.amount.number (), info.block_count + 1);
 							ledger.store.representation_add (transaction, hash, pending.amount.number ());
 							ledger.store.frontier_put (transaction, hash, block_a.hashables.account);
@@ -2517,10 +3288,21 @@ void ledger_processor::open_block (rai::open_block const & block_a)
     }
 }
 
-ledger_processor::ledger_processor (rai::ledger & ledger_a, MDB_txn * transaction_a) :
+ledger_processor::ledger_processor (rai::ledger & ledger_a, MDB_txn * transaction_a, rai::account const & verified_a) :
 ledger (ledger_a),
-transaction (transaction_a)
+transaction (transaction_a),
+verified (verified_a)
+{
+}
+
+bool ledger_processor::signature_invalid (rai::account const & account_a, rai::block_hash const & hash_a, rai::signature const & signature_a)
 {
+	auto result (false);
+	if (verified.is_zero () || verified != account_a)
+	{
+		result = rai::validate_message (account_a, hash_a, signature_a);
+	}
+	return result;
 }
 
 rai::vote::vote (rai::vote const & other_a) :
@@ -2640,7 +3422,7 @@ void rai::genesis::initialize (MDB_txn * transaction_a, rai::block_store & store
 {
 	auto hash_l (hash ());
 	assert (store_a.latest_begin (transaction_a) == store_a.latest_end ());
-	store_a.block_put (transaction_a, hash_l, *open);
+	store_a.block_put (transaction_a, hash_l, *open, 0, rai::block_sideband (genesis_account, 1, std::numeric_limits <rai::uint128_t>::max ()));
 	store_a.account_put (transaction_a, genesis_account, {hash_l, open->hash (), open->hash (), std::numeric_limits <rai::uint128_t>::max (), store_a.now (), 1});
 	store_a.representation_put (transaction_a, genesis_account, std::numeric_limits <rai::uint128_t>::max ());
 	store_a.checksum_put (transaction_a, 0, 0, hash_l);
@@ -3,8 +3,15 @@
 #include <rai/lib/blocks.hpp>
 #include <rai/node/utility.hpp>
 
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <atomic>
+#include <map>
+#include <mutex>
 #include <unordered_map>
 
 #include <blake2/blake2.h>
@@ -125,6 +132,21 @@ public:
 	rai::account account;
 	rai::amount balance;
 };
+// Ledger information stored alongside each block so it doesn't have to be recomputed by walking the chain
+class block_sideband
+{
+public:
+	block_sideband ();
+	block_sideband (rai::account const &, uint64_t, rai::amount const &);
+	void serialize (rai::stream &) const;
+	bool deserialize (rai::stream &);
+	bool operator == (rai::block_sideband const &) const;
+	static size_t constexpr size = sizeof (rai::account) + sizeof (uint64_t) + sizeof (rai::amount);
+	rai::account account;
+	// Position of the block in its account chain starting at 1, 0 if the block was stored without a sideband
+	uint64_t height;
+	rai::amount balance;
+};
 class block_counts
 {
 public:
@@ -170,24 +192,104 @@ public:
 	rai::vote_code code;
 	std::shared_ptr <rai::vote> vote;
 };
+// In-memory copy of the representation table
+// Readers look weights up in an immutable map without opening a transaction, changes made in a write transaction are published once it commits
+class rep_weights
+{
+public:
+	using weights_map = std::unordered_map <rai::account, rai::uint128_t>;
+	rep_weights ();
+	rai::uint128_t get (MDB_txn *, rai::account const &);
+	void put (MDB_txn *, rai::account const &, rai::uint128_t const &);
+	// Replace the table contents, discarding staged changes
+	void load (weights_map &&);
+	std::shared_ptr <weights_map const> snapshot ();
+	void commit_prepare ();
+	void commit_complete ();
+private:
+	std::shared_ptr <weights_map const> current;
+	// Changes made by the open write transaction, only touched by the writing thread
+	weights_map staged;
+	std::atomic <MDB_txn *> staged_transaction;
+	// Changes from transactions that have committed but aren't published yet
+	weights_map committed;
+	std::atomic <bool> committed_pending;
+	std::mutex mutex;
+};
+class unchecked_info
+{
+public:
+	std::chrono::system_clock::time_point arrival;
+	// Hash of the previous or source block this one is waiting for
+	rai::block_hash dependency;
+	// Hash of the block itself
+	rai::block_hash hash;
+	std::shared_ptr <rai::block> block;
+};
+// Blocks waiting on a missing dependency, held in memory and indexed by the hash they need
+// The oldest are spilled to the unchecked table when the pool is full or they've waited too long, lookups check both
+class unchecked_pool
+{
+public:
+	unchecked_pool ();
+	boost::multi_index_container
+	<
+		rai::unchecked_info,
+		boost::multi_index::indexed_by
+		<
+			boost::multi_index::ordered_non_unique <boost::multi_index::member <rai::unchecked_info, std::chrono::system_clock::time_point, &rai::unchecked_info::arrival>>,
+			boost::multi_index::hashed_non_unique <boost::multi_index::member <rai::unchecked_info, rai::block_hash, &rai::unchecked_info::dependency>>,
+			boost::multi_index::hashed_non_unique <boost::multi_index::member <rai::unchecked_info, rai::block_hash, &rai::unchecked_info::hash>>
+		>
+	> blocks;
+	// Blocks held in memory before the oldest are spilled
+	size_t max;
+	// Blocks written to the table to make room or because they aged out
+	uint64_t spilled;
+};
+// Block writes made by one write transaction, held in key order and written just before it commits
+// A batch of random hashes then walks the blocks table once, appending past the last key, instead of searching it per block
+class block_buffer
+{
+public:
+	block_buffer ();
+	// Serialized values by hash, an empty value is a deleted block
+	std::map <rai::block_hash, std::vector <uint8_t>> blocks;
+	// Compared against by every thread's block lookups, only the thread holding the write transaction sets it
+	std::atomic <MDB_txn *> transaction;
+	// Totals over all flushes, read by other threads
+	std::atomic <uint64_t> written;
+	std::atomic <uint64_t> appended;
+	std::atomic <uint64_t> flushes;
+	// Microseconds spent writing
+	std::atomic <uint64_t> time;
+};
 class block_store
 {
 public:
 	block_store (bool &, boost::filesystem::path const &);
+	block_store (bool &, boost::filesystem::path const &, rai::mdb_env_config const &);
 	uint64_t now ();
 	
-	MDB_dbi block_database (rai::block_type);
-	void block_put_raw (MDB_txn *, MDB_dbi, rai::block_hash const &, MDB_val);
-	void block_put (MDB_txn *, rai::block_hash const &, rai::block const &, rai::block_hash const & = rai::block_hash (0));
+	// Value is the block type followed by the serialized block, its successor and sideband
+	void block_put_raw (MDB_txn *, rai::block_hash const &, MDB_val);
+	void block_put (MDB_txn *, rai::block_hash const &, rai::block const &, rai::block_hash const & = rai::block_hash (0), rai::block_sideband const & = rai::block_sideband ());
+	// Returns the serialized block, its successor and sideband, without the leading type
 	MDB_val block_get_raw (MDB_txn *, rai::block_hash const &, rai::block_type &);
 	rai::block_hash block_successor (MDB_txn *, rai::block_hash const &);
 	void block_successor_clear (MDB_txn *, rai::block_hash const &);
-	std::unique_ptr <rai::block> block_get (MDB_txn *, rai::block_hash const &);
+	std::unique_ptr <rai::block> block_get (MDB_txn *, rai::block_hash const &, rai::block_sideband * = nullptr);
+	bool block_sideband_get (MDB_txn *, rai::block_hash const &, rai::block_sideband &);
 	std::unique_ptr <rai::block> block_random (MDB_txn *);
-	std::unique_ptr <rai::block> block_random (MDB_txn *, MDB_dbi);
 	void block_del (MDB_txn *, rai::block_hash const &);
 	bool block_exists (MDB_txn *, rai::block_hash const &);
 	rai::block_counts block_count (MDB_txn *);
+	void block_count_add (MDB_txn *, rai::block_type, int64_t);
+	// Stage the transaction's block writes until it commits, reads through the transaction see them but iterators don't
+	void block_buffer_begin (MDB_txn *);
+	// Writes the staged blocks through the committing transaction
+	void block_buffer_flush (MDB_txn *);
+	rai::block_buffer block_buffer;
 	
 	void frontier_put (MDB_txn *, rai::block_hash const &, rai::account const &);
 	rai::account frontier_get (MDB_txn *, rai::block_hash const &);
@@ -227,14 +329,34 @@ public:
 	rai::store_iterator representation_end ();
 	
 	void unchecked_clear (MDB_txn *);
+	// Pools the block, spilling the oldest pooled blocks through the transaction if the pool is full
 	void unchecked_put (MDB_txn *, rai::block_hash const &, std::shared_ptr <rai::block> const &);
+	// Pools the block without writing so it can be called with a read transaction, the pool can go past its limit until the next trim
+	void unchecked_pool_put (MDB_txn *, rai::block_hash const &, std::shared_ptr <rai::block> const &);
+	// Spill the oldest pooled blocks if the pool is over its limit
+	void unchecked_trim (MDB_txn *);
 	std::vector <std::shared_ptr <rai::block>> unchecked_get (MDB_txn *, rai::block_hash const &);
 	void unchecked_del (MDB_txn *, rai::block_hash const &, rai::block const &);
+	// Look an unchecked block up by its own hash, the table is keyed by dependency so only the pool is indexed for this
+	std::shared_ptr <rai::block> unchecked_find (MDB_txn *, rai::block_hash const &);
 	rai::store_iterator unchecked_begin (MDB_txn *);
 	rai::store_iterator unchecked_begin (MDB_txn *, rai::block_hash const &);
 	rai::store_iterator unchecked_end ();
+	// Pooled and stored blocks
 	size_t unchecked_count (MDB_txn *);
-	std::unordered_multimap <rai::block_hash, std::shared_ptr <rai::block>> unchecked_cache;
+	// Blocks in the unchecked table
+	size_t unchecked_stored (MDB_txn *);
+	// Write pooled blocks that arrived before the cutoff to the unchecked table
+	void unchecked_spill (MDB_txn *, std::chrono::system_clock::time_point const &);
+	// Remove and return the pooled blocks waiting on a dependency, the table is left alone so no write transaction is needed
+	std::vector <std::shared_ptr <rai::block>> unchecked_pool_take (rai::block_hash const &);
+	// Up to the given number of pooled blocks, oldest first
+	std::vector <std::shared_ptr <rai::block>> unchecked_pooled (size_t);
+	// Up to the given number of pooled blocks waiting on a dependency at or after the key, in table order
+	std::vector <rai::unchecked_info> unchecked_pooled (rai::block_hash const &, size_t);
+	size_t unchecked_pool_size ();
+	uint64_t unchecked_pool_spilled ();
+	rai::unchecked_pool unchecked_pool;
 	
 	void unsynced_put (MDB_txn *, rai::block_hash const &);
 	void unsynced_del (MDB_txn *, rai::block_hash const &);
@@ -248,6 +370,8 @@ public:
 	void checksum_del (MDB_txn *, uint64_t, uint8_t);
 	
 	rai::vote_result vote_validate (MDB_txn *, std::shared_ptr <rai::vote>);
+	// Classify a vote whose signature has already been checked as either new or a replay
+	rai::vote_result vote_sequence (MDB_txn *, std::shared_ptr <rai::vote>);
 	// Return latest vote for an account from store
 	std::shared_ptr <rai::vote> vote_get (MDB_txn *, rai::account const &);
 	// Populate vote with the next sequence number
@@ -256,7 +380,10 @@ public:
 	std::shared_ptr <rai::vote> vote_max (MDB_txn *, std::shared_ptr <rai::vote>);
 	// Return latest vote for an account considering the vote cache
 	std::shared_ptr <rai::vote> vote_current (MDB_txn *, rai::account const &);
+	// Write the vote cache and every pooled unchecked block
 	void flush (MDB_txn *);
+	// Write the vote cache and the unchecked blocks pooled before the cutoff
+	void flush (MDB_txn *, std::chrono::system_clock::time_point const &);
 	rai::store_iterator vote_begin (MDB_txn *);
 	rai::store_iterator vote_end ();
 	std::mutex cache_mutex;
@@ -274,28 +401,31 @@ public:
 	void upgrade_v7_to_v8 (MDB_txn *);
 	void upgrade_v8_to_v9 (MDB_txn *);
 	void upgrade_v9_to_v10 (MDB_txn *);
+	void upgrade_v10_to_v11 (MDB_txn *);
+	void upgrade_v11_to_v12 (MDB_txn *);
 	
 	void clear (MDB_dbi);
 	
+	// Write the ledger tables to a checksummed stream, returns true on error
+	bool snapshot_export (MDB_txn *, std::ostream &);
+	// Load a snapshot in to an empty ledger with appending inserts, returns true on error and leaves the store unchanged
+	bool snapshot_import (std::istream &);
+	void rep_weights_load (MDB_txn *);
+	
 	rai::mdb_env environment;
 	// block_hash -> account                                        // Maps head blocks to owning account
 	MDB_dbi frontiers;
 	// account -> block_hash, representative, balance, timestamp    // Account to head block, representative, balance, last_change
 	MDB_dbi accounts;
-	// block_hash -> send_block
-	MDB_dbi send_blocks;
-	// block_hash -> receive_block
-	MDB_dbi receive_blocks;
-	// block_hash -> open_block
-	MDB_dbi open_blocks;
-	// block_hash -> change_block
-	MDB_dbi change_blocks;
+	// block_hash -> block_type, block, successor, sideband         // All blocks, counts per type are kept in meta
+	MDB_dbi blocks;
 	// block_hash -> sender, amount, destination                    // Pending blocks to sender account, amount, destination account
 	MDB_dbi pending;
 	// block_hash -> account, balance                               // Blocks info
 	MDB_dbi blocks_info;
 	// account -> weight                                            // Representation
 	MDB_dbi representation;
+	rai::rep_weights rep_weights;
 	// block_hash -> block                                          // Unchecked bootstrap blocks
 	MDB_dbi unchecked;
 	// block_hash ->                                                // Blocks that haven't been broadcast
@@ -304,7 +434,7 @@ public:
 	MDB_dbi checksum;
 	// account -> uint64_t											// Highest vote observed for account
 	MDB_dbi vote;
-	// uint256_union -> ?											// Meta information about block store
+	// uint256_union -> ?											// Meta information about block store, 1 is the version and block_type values are block counts
 	MDB_dbi meta;
 };
 enum class process_result
@@ -334,6 +464,15 @@ enum class tally_result
 	changed,
 	confirm
 };
+// Representative weights and vote supply as of one point in time, lets elections tally without opening a transaction
+class weight_snapshot
+{
+public:
+	weight_snapshot ();
+	rai::uint128_t weight (rai::account const &) const;
+	std::shared_ptr <rai::rep_weights::weights_map const> weights;
+	rai::uint128_t supply;
+};
 class votes
 {
 public:
@@ -351,6 +490,8 @@ public:
 	std::pair <rai::uint128_t, std::shared_ptr <rai::block>> winner (MDB_txn *, rai::votes const & votes_a);
 	// Map of weight -> associated block, ordered greatest to least
 	std::map <rai::uint128_t, std::shared_ptr <rai::block>, std::greater <rai::uint128_t>> tally (MDB_txn *, rai::votes const &);
+	std::map <rai::uint128_t, std::shared_ptr <rai::block>, std::greater <rai::uint128_t>> tally (rai::weight_snapshot const &, rai::votes const &);
+	std::shared_ptr <rai::weight_snapshot> weights (MDB_txn *);
 	rai::account account (MDB_txn *, rai::block_hash const &);
 	rai::uint128_t amount (MDB_txn *, rai::block_hash const &);
 	rai::uint128_t balance (MDB_txn *, rai::block_hash const &);
@@ -368,6 +509,7 @@ public:
 	std::string block_text (rai::block_hash const &);
 	rai::uint128_t supply (MDB_txn *);
 	rai::process_return process (MDB_txn *, rai::block const &);
+	rai::process_return process (MDB_txn *, rai::block const &, rai::account const &);
 	void rollback (MDB_txn *, rai::block_hash const &);
 	void change_latest (MDB_txn *, rai::account const &, rai::block_hash const &, rai::account const &, rai::uint128_union const &, uint64_t);
 	void checksum_update (MDB_txn *, rai::block_hash const &);